@@ -1,8 +1,22 @@
 #include "imgui.h"
 #include "bindings/imgui_impl_glfw.h"
 #include "bindings/imgui_impl_opengl3.h"
+#include "frame_queue.h"
+#include "frame_arena.h"
+#include "frame_profiler.h"
+#include "size_class_pool.h"
+#include "memory_telemetry.h"
+#include "headless.h"
+#include "input_recorder.h"
+#include "frame_pacer.h"
+#include "imgui_indirect_renderer.h"
+#include "frame_capture.h"
+#include "remote_imgui.h"
+#include <string>
 #include <stdio.h>
+#include <chrono>
 #include <cstdlib>
+#include <thread>
 #ifndef GL_SILENCE_DEPRECATION
 #define GL_SILENCE_DEPRECATION
 #endif
@@ -31,7 +45,11 @@ static void glfw_error_callback2(int error, const char *description)
 class App
 {
 public:
-    App()
+    // With headless.enabled the window stays hidden, the UI renders into an offscreen
+    // framebuffer without vsync, and Run() returns after headless.frames frames with a report.
+    // input_options records the session's input to a file, or replays one (ending the run with it).
+    explicit App(const HeadlessOptions &headless_options = HeadlessOptions(), const InputRecordingOptions &input_options = InputRecordingOptions())
+        : headless(headless_options)
     {
         // RAII setup
         glfwSetErrorCallback(glfw_error_callback2);
@@ -64,17 +82,31 @@ public:
 #endif
 
         // Create window with graphics context
-        window = glfwCreateWindow(1280, 720, "Dear ImGui GLFW+OpenGL3 example", NULL, NULL);
+        applyHeadlessWindowHints(headless);
+        int width = headless.enabled ? headless.width : 1280;
+        int height = headless.enabled ? headless.height : 720;
+        window = glfwCreateWindow(width, height, "Dear ImGui GLFW+OpenGL3 example", NULL, NULL);
         if (window == NULL) {
             printf("ERROR: CREATING WINDOW");
             std::exit(1);
         }
         glfwMakeContextCurrent(window);
-        glfwSwapInterval(1); // Enable vsync
+        // vsync, unless running as fast as possible; the pacer sets the swap interval before the first swap
+        pacer.setMode(headless.enabled ? PacingMode::Uncapped : PacingMode::VSync);
+        if (!initGlew() || (headless.enabled && !offscreen.create(width, height))) {
+            printf("ERROR: SETTING UP OPENGL");
+            std::exit(1);
+        }
 
-        // Setup ImGui context
+        // Setup ImGui context, with all of ImGui's allocations served from a size-class pool
         IMGUI_CHECKVERSION();
+        ImGui::SetAllocatorFunctions(&MemoryTelemetry::imguiAlloc, &MemoryTelemetry::imguiFree, &imgui_pool);
         ImGui::CreateContext();
+        if (headless.enabled)
+            ImGui::GetIO().IniFilename = NULL; // runs must not depend on (or rewrite) a saved layout
+        profiler.setPool(&imgui_pool);
+        profiler.setArena(&frame_arena);
+        profiler.setPacer(&pacer);
 
         // Setup ImGui style
         ImGui::StyleColorsDark();
@@ -83,6 +115,15 @@ public:
         // Setup Platform/Renderer backends
         ImGui_ImplGlfw_InitForOpenGL(window, true);
         ImGui_ImplOpenGL3_Init(glsl_version);
+        if (!input_recorder.start(window, input_options)) {
+            printf("ERROR: STARTING INPUT RECORDING");
+            std::exit(1);
+        }
+        // create the font atlas texture now, while this thread owns the context, so it can be tracked
+        ImGui_ImplOpenGL3_CreateDeviceObjects();
+        trackImGuiFontTexture();
+        // multi-draw-indirect where the driver has it; otherwise imgui_renderer falls back to the backend
+        imgui_renderer.init();
 
         // Load Fonts
         // - If no fonts are loaded, dear imgui will use the default font. You can also load multiple fonts and use ImGui::PushFont()/PopFont() to select them.
@@ -109,9 +150,16 @@ public:
     virtual ~App()
     {
         // RAII cleanup
+        remote.stop();
+        input_recorder.stop();
+        capture.shutdown();
+        offscreen.destroy();
+        imgui_renderer.shutdown();
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
+        // imgui_pool goes with this object
+        MemoryTelemetry::restoreImGuiAllocator();
 
         glfwDestroyWindow(window);
         glfwTerminate();
@@ -120,6 +168,21 @@ public:
     void Run()
     {
         Startup();
+        auto run_start = std::chrono::steady_clock::now();
+
+        // the backend's RenderDrawData reads the ImGui context, which the UI thread is already
+        // building the next frame in, so only the indirect renderer can draw from another thread
+        if (threaded_rendering && !imgui_renderer.available())
+        {
+            fprintf(stderr, "Threaded rendering needs the indirect ImGui renderer; rendering on the UI thread\n");
+            threaded_rendering = false;
+        }
+        if (threaded_rendering)
+        {
+            RunThreaded();
+            ReportHeadless(run_start);
+            return;
+        }
 
         // Main loop
 #ifdef __EMSCRIPTEN__
@@ -128,9 +191,13 @@ public:
         io.IniFilename = NULL;
         EMSCRIPTEN_MAINLOOP_BEGIN
 #else
-        while (!glfwWindowShouldClose(window))
+        while (KeepRunning())
 #endif
         {
+            // in low-latency mode this sleeps until the frame can just make the next vblank
+            pacer.waitForFrameStart();
+            frame_arena.reset();
+            profiler.beginFrame();
 
             // Poll and handle events (inputs, window resize, etc.)
             // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
@@ -138,34 +205,196 @@ public:
             // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application, or clear/overwrite your copy of the keyboard data.
             // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
             glfwPollEvents();
+            input_recorder.newFrame();
+            remote.newFrame(window);
 
             // Start the Dear ImGui frame
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
+            input_recorder.applyReplayDeltaTime();
             ImGui::NewFrame();
 
             // the implementor of Update() now can already make draw calls and just focus on the gui
             Update();
+            if (show_profiler)
+                profiler.draw(&show_profiler);
+            if (show_memory)
+                memoryTelemetry().draw(&show_memory);
+            if (show_pacer)
+                pacer.draw(&show_pacer);
+            if (show_capture)
+                capture.draw(&show_capture);
 
             // Rendering
             // now we proceed to generic rendering and swapping the frame to be displayed
             ImGui::Render();
+            remote.send(ImGui::GetDrawData());
             int display_w, display_h;
             glfwGetFramebufferSize(window, &display_w, &display_h);
+            if (headless.enabled)
+                offscreen.bind();
             glViewport(0, 0, display_w, display_h);
             glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
             glClear(GL_COLOR_BUFFER_BIT);
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            Render();
+            imgui_renderer.render(ImGui::GetDrawData());
+            capture.frame(display_w, display_h);
 
+            pacer.beforeSwap();
             glfwSwapBuffers(window);
+            pacer.afterSwap();
+            profiler.endFrame();
+            if (headless.enabled && !remote.listening())
+                frame_times.add(profiler.lastFrame().cpu_ms);
+        }
+        ReportHeadless(run_start);
+    }
+
+    // Threaded mode: this thread polls input and builds ImGui frames, snapshots the draw data
+    // into a FrameQueue and moves on to the next frame, while a render thread that owns the
+    // GL context submits and swaps. Update() must not make GL calls here; use Render().
+    void RunThreaded()
+    {
+        FrameQueue frames;
+        glfwMakeContextCurrent(NULL);
+        // input is polled on this thread and swapped on the render thread
+        pacer.setLowLatencyAvailable(false);
+
+        std::thread render_thread([&]() {
+            glfwMakeContextCurrent(window);
+
+            while (RenderFrame *frame = frames.beginRead())
+            {
+                if (headless.enabled)
+                    offscreen.bind();
+                glViewport(0, 0, frame->framebuffer_width, frame->framebuffer_height);
+                glClearColor(frame->clear_color.x * frame->clear_color.w, frame->clear_color.y * frame->clear_color.w, frame->clear_color.z * frame->clear_color.w, frame->clear_color.w);
+                glClear(GL_COLOR_BUFFER_BIT);
+                Render();
+                if (ImDrawData *draw_data = frame->draw_data.drawData())
+                    imgui_renderer.render(draw_data);
+                capture.frame(frame->framebuffer_width, frame->framebuffer_height);
+                pacer.beforeSwap();
+                glfwSwapBuffers(window);
+                pacer.afterSwap();
+                frames.endRead();
+            }
+            glfwMakeContextCurrent(NULL);
+        });
+
+        uint64_t frame_index = 0;
+        while (KeepRunning())
+        {
+            frame_arena.reset();
+            profiler.beginFrame();
+            glfwPollEvents();
+            input_recorder.newFrame();
+            remote.newFrame(window);
+
+            // ImGui_ImplOpenGL3_NewFrame() is skipped: all it does is create the device objects,
+            // which the constructor already did
+            ImGui_ImplGlfw_NewFrame();
+            input_recorder.applyReplayDeltaTime();
+            ImGui::NewFrame();
+            Update();
+            if (show_profiler)
+                profiler.draw(&show_profiler);
+            if (show_memory)
+                memoryTelemetry().draw(&show_memory);
+            if (show_pacer)
+                pacer.draw(&show_pacer);
+            if (show_capture)
+                capture.draw(&show_capture);
+            ImGui::Render();
+            remote.send(ImGui::GetDrawData());
+
+            // blocks only while the render thread still has every other slot in flight
+            RenderFrame *frame = frames.beginWrite();
+            if (!frame)
+                break;
+            frame->draw_data.capture(ImGui::GetDrawData());
+            glfwGetFramebufferSize(window, &frame->framebuffer_width, &frame->framebuffer_height);
+            frame->clear_color = clear_color;
+            frame->index = frame_index++;
+            frames.endWrite();
+            profiler.endFrame();
+            if (headless.enabled && !remote.listening())
+                frame_times.add(profiler.lastFrame().cpu_ms);
         }
+
+        frames.stop();
+        render_thread.join();
+        // the destructor shuts the GL backend down on this thread
+        glfwMakeContextCurrent(window);
+    }
+
+    // Serves the UI to dear-imgui-viewer on address (see remote_imgui.h) from the next frame on.
+    // A headless app then runs at 60 FPS until it is killed, instead of for a frame count.
+    bool ServeRemote(const std::string &address)
+    {
+        if (!remote.listen(address))
+            return false;
+        if (headless.enabled)
+            pacer.setMode(PacingMode::FixedRate, 60.0);
+        printf("Serving the UI on %s\n", address.c_str());
+        return true;
+    }
+
+    // Headless runs stop after the requested frame count instead of on window close,
+    // and a replay stops with its recording
+    bool KeepRunning() const
+    {
+        if (input_recorder.replayFinished())
+            return false;
+        if (headless.enabled && remote.listening())
+            return true;
+        if (headless.enabled)
+            return frame_times.frames() < (size_t)headless.frames;
+        return !glfwWindowShouldClose(window);
+    }
+
+    // Waits for the GPU to finish the queued frames, so the total covers all the work, and prints the summary
+    void ReportHeadless(std::chrono::steady_clock::time_point run_start)
+    {
+        if (!headless.enabled)
+            return;
+        glFinish();
+        double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run_start).count();
+        frame_times.print(stdout, "App", total_ms);
     }
 
     virtual void Update() = 0;
     virtual void Startup() = 0;
+    // Called on the thread owning the GL context, after the clear and before the ImGui pass
+    virtual void Render() {}
 
 protected:
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
+    // Set in Startup() to build UI frames on this thread and submit them from a render thread;
+    // ignored when the indirect renderer is unavailable
+    bool threaded_rendering = false;
+
+    // Reset at the top of every frame; Update() can put temporaries in it through frame_memory,
+    // e.g. std::pmr::vector<ImVec2> points(&frame_memory)
+    FrameArena frame_arena;
+    FrameArenaResource frame_memory{frame_arena};
+    SizeClassPool imgui_pool;
+    FrameProfiler profiler;
+    bool show_profiler = true;
+    bool show_memory = true;
+    // Startup() can pick another mode, e.g. pacer.setMode(PacingMode::FixedRate, 30.0)
+    FramePacer pacer;
+    bool show_pacer = true;
+    // records the finished frames, before each swap, to a GIF or PNG sequence
+    FrameCapture capture;
+    bool show_capture = false;
+    ImGuiIndirectRenderer imgui_renderer;
+    HeadlessOptions headless;
+    OffscreenTarget offscreen;
+    FrameTimeStats frame_times;
+    InputRecorder input_recorder;
+    // streams every frame's draw data to a remote viewer once ServeRemote() was called
+    RemoteServer remote;
     GLFWwindow *window;
 private:
 };
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 330 core
+
+layout(location = 0) in vec3 aPos;       // Model-space position
+layout(location = 1) in vec4 aColor;     // RGBA8, normalized
+layout(location = 2) in uint aTransform; // Index into the transform buffer
+
+out vec4 vertexColor;
+
+uniform mat4 viewProjection;
+uniform samplerBuffer transforms; // 4 RGBA32F texels per model matrix
+
+void main() {
+    int base = int(aTransform) * 4;
+    mat4 model = mat4(texelFetch(transforms, base),
+                      texelFetch(transforms, base + 1),
+                      texelFetch(transforms, base + 2),
+                      texelFetch(transforms, base + 3));
+
+    vertexColor = aColor;
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+}
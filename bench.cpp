@@ -0,0 +1,711 @@
+// dear-imgui-bench: runs fixed UI and scene workloads headless for a fixed number of frames and
+// reports CPU frame time percentiles, draw calls, vertices and allocations per frame.
+//
+//   dear-imgui-bench [--frames N] [--warmup N] [--size WxH] [--context native|egl|osmesa]
+//                    [--scenario NAME]... [--csv FILE] [--json FILE]
+//                    [--baseline FILE] [--threshold PERCENT] [--renderer mdi|loop]
+//
+// With --baseline (a CSV written by an earlier --csv run) it exits with 2 when a scenario got
+// slower, drew more or allocated more than the baseline by more than the threshold (default 10%).
+// --renderer loop draws ImGui with the backend's draw call per command instead of
+// multi-draw-indirect, which is also what happens on drivers without GL 4.3.
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "imgui.h"
+#include "frame_bench.h"
+#include "file_manager.h"
+#include "opengl_shader.h"
+#include "mesh_file.h"
+#include "scene_graph.h"
+#include "frustum_culling.h"
+#include "job_system.h"
+#include "memory_telemetry.h"
+#include "telemetry_plot.h"
+#include "gpu_line_plot.h"
+#include "columnar_table.h"
+#include "log_viewer.h"
+#include "texture_manager.h"
+#include "frame_capture.h"
+#include "remote_imgui.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench_scenarios
+{
+    BenchScenario DemoWindow()
+    {
+        BenchScenario scenario;
+        scenario.name = "demo_window";
+        scenario.frame = [](BenchFrame &) {
+            ImGui::SetNextWindowPos(ImVec2(20.0f, 20.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(600.0f, 680.0f), ImGuiCond_Always);
+            ImGui::ShowDemoWindow();
+        };
+        return scenario;
+    }
+
+    // 200 small overlapping windows with a handful of widgets each
+    BenchScenario ManyWindows()
+    {
+        BenchScenario scenario;
+        scenario.name = "many_windows";
+        scenario.frame = [](BenchFrame &frame) {
+            static float values[200] = {};
+            static bool flags[200] = {};
+            for (int i = 0; i < 200; i++)
+            {
+                char title[32];
+                snprintf(title, sizeof(title), "Window %d", i);
+                ImGui::SetNextWindowPos(ImVec2(10.0f + (i % 20) * 50.0f, 10.0f + (i / 20) * 60.0f), ImGuiCond_Always);
+                ImGui::SetNextWindowSize(ImVec2(220.0f, 140.0f), ImGuiCond_Always);
+                ImGui::Begin(title);
+                ImGui::Text("Frame %llu", (unsigned long long)frame.index);
+                ImGui::SliderFloat("Value", &values[i], 0.0f, 1.0f);
+                ImGui::Checkbox("Flag", &flags[i]);
+                ImGui::Button("Button");
+                ImGui::ProgressBar(std::fmod(frame.index * 0.01f + i * 0.05f, 1.0f));
+                ImGui::End();
+            }
+        };
+        return scenario;
+    }
+
+    // 100k rows x 8 columns, scrolled a little every frame, with only the visible rows submitted
+    BenchScenario LargeTable()
+    {
+        BenchScenario scenario;
+        scenario.name = "large_table";
+        scenario.frame = [](BenchFrame &frame) {
+            const int rows = 100000, columns = 8;
+            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+            ImGui::Begin("Table", nullptr, ImGuiWindowFlags_NoDecoration);
+            ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable;
+            if (ImGui::BeginTable("rows", columns, flags))
+            {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                for (int column = 0; column < columns; column++)
+                {
+                    char name[16];
+                    snprintf(name, sizeof(name), "Column %d", column);
+                    ImGui::TableSetupColumn(name);
+                }
+                ImGui::TableHeadersRow();
+                ImGui::SetScrollY((float)(frame.index % 1000) * 37.0f);
+
+                ImGuiListClipper clipper;
+                clipper.Begin(rows);
+                while (clipper.Step())
+                {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+                    {
+                        ImGui::TableNextRow();
+                        for (int column = 0; column < columns; column++)
+                        {
+                            ImGui::TableSetColumnIndex(column);
+                            ImGui::Text("%d.%d %08x", row, column, (unsigned)(row * 2654435761u + column));
+                        }
+                    }
+                }
+                ImGui::EndTable();
+            }
+            ImGui::End();
+        };
+        return scenario;
+    }
+
+    // Long wrapped paragraphs at two font scales, re-laid out every frame
+    BenchScenario FontHeavyText()
+    {
+        BenchScenario scenario;
+        scenario.name = "text";
+        scenario.frame = [](BenchFrame &frame) {
+            static const char *paragraph =
+                "Dear ImGui is a bloat-free graphical user interface library for C++. It outputs optimized vertex buffers "
+                "that you can render anytime in your 3D-pipeline-enabled application. It is fast, portable, renderer "
+                "agnostic, and self-contained (no external dependencies). ";
+            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+            ImGui::Begin("Text", nullptr, ImGuiWindowFlags_NoDecoration);
+            for (int i = 0; i < 40; i++)
+            {
+                ImGui::SetWindowFontScale(i % 2 ? 1.0f : 1.6f);
+                ImGui::Text("Paragraph %d, frame %llu", i, (unsigned long long)frame.index);
+                ImGui::TextWrapped("%s%s", paragraph, paragraph);
+                ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "0123456789 ABCDEFGHIJKLMNOPQRSTUVWXYZ abcdefghijklmnopqrstuvwxyz");
+            }
+            ImGui::SetWindowFontScale(1.0f);
+            ImGui::End();
+        };
+        return scenario;
+    }
+
+    // The instanced cuboid grid of main_draggable5: 10^5 scene graph nodes under a rotating root,
+    // so every frame updates all transforms, refreshes bounds, culls and refills the instance buffer
+    struct CuboidState
+    {
+        Shader shader;
+        GpuMesh mesh;
+        GLuint instanceBuffer = 0;
+        SceneGraph scene;
+        JobSystem jobs;
+        SceneNode root = kInvalidNode;
+        std::vector<SceneNode> objects;
+        BoundsSoA bounds;
+        std::vector<uint32_t> visible;
+    };
+
+    BenchScenario Cuboids(const FrameBench &bench, int count = 100000)
+    {
+        auto state = std::make_shared<CuboidState>();
+        BenchScenario scenario;
+        scenario.name = "cuboids";
+        scenario.setup = [state, count]() {
+            std::string vertex = FileManager::read("vertex-shader-instanced.glsl");
+            std::string fragment = FileManager::read("fragment-shader-1.glsl");
+            if (vertex.empty() || fragment.empty() || !loadMesh("cuboid.obj", "cuboid.mesh", state->mesh))
+                return false;
+            state->shader.init(vertex, fragment);
+
+            glGenBuffers(1, &state->instanceBuffer);
+            glBindVertexArray(state->mesh.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, state->instanceBuffer);
+            trackedBufferData(GL_ARRAY_BUFFER, state->instanceBuffer, count * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW, "Bench cuboid instances");
+            for (int column = 0; column < 4; column++)
+            {
+                glEnableVertexAttribArray(2 + column);
+                glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(sizeof(glm::vec4) * column));
+                glVertexAttribDivisor(2 + column, 1);
+            }
+            glBindVertexArray(0);
+
+            int side = (int)std::ceil(std::cbrt((double)count));
+            state->root = state->scene.create();
+            state->objects.resize(count);
+            for (int i = 0; i < count; i++)
+            {
+                glm::vec3 cell((float)(i % side), (float)(i / side % side), (float)(i / (side * side)));
+                state->objects[i] = state->scene.create(state->root);
+                state->scene.setTranslation(state->objects[i], (cell - glm::vec3((side - 1) * 0.5f)) * 1.5f);
+            }
+            state->bounds.resize(count);
+            state->visible.resize(count);
+            state->jobs.init();
+            return true;
+        };
+        scenario.frame = [state, &bench](BenchFrame &frame) {
+            CuboidState &s = *state;
+            s.scene.setRotation(s.root, glm::vec3(0.0f, (float)(frame.index % 360), 0.0f));
+            s.scene.update(&s.jobs);
+            s.jobs.parallelFor(s.objects.size(), 4096, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                    s.bounds.setTransformedBox(i, s.scene.world(s.objects[i]), s.mesh.bounds_center, s.mesh.bounds_extent);
+            });
+
+            glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, 90.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)bench.width() / bench.height(), 0.1f, 300.0f);
+            size_t visibleCount = cullBoxes(Frustum::fromMatrix(projection * view), s.bounds, s.visible.data(), s.jobs);
+
+            glBindBuffer(GL_ARRAY_BUFFER, s.instanceBuffer);
+            if (visibleCount > 0)
+            {
+                glm::mat4 *instances = (glm::mat4 *)glMapBufferRange(GL_ARRAY_BUFFER, 0, visibleCount * sizeof(glm::mat4), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+                s.jobs.parallelFor(visibleCount, 4096, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++)
+                        instances[i] = s.scene.world(s.objects[s.visible[i]]);
+                });
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+
+            glEnable(GL_DEPTH_TEST);
+            s.shader.use();
+            glm::mat4 model = s.mesh.dequantization;
+            s.shader.setUniform<float *>("model", &model[0][0]);
+            s.shader.setUniform<float *>("view", &view[0][0]);
+            s.shader.setUniform<float *>("projection", &projection[0][0]);
+            s.shader.setUniform<float>("lightColor", 1.0f, 1.0f, 1.0f);
+            s.shader.setUniform<float>("lightDir", -0.2f, -1.0f, -0.3f);
+            s.mesh.drawInstanced((uint32_t)visibleCount);
+            glDisable(GL_DEPTH_TEST);
+            // counted like ImGui's, as indexed vertices submitted
+            frame.draw_calls += 1;
+            frame.vertices += (uint64_t)visibleCount * s.mesh.index_count;
+
+            ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_Always);
+            ImGui::Begin("Cuboids", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+            ImGui::Text("Drawn: %zu of %zu", visibleCount, s.objects.size());
+            ImGui::End();
+        };
+        scenario.teardown = [state]() {
+            state->jobs.shutdown();
+            trackedDeleteBuffers(1, &state->instanceBuffer);
+            state->mesh.destroy();
+            state->shader.destroy();
+        };
+        return scenario;
+    }
+
+    // A full 10^8-sample telemetry history, taking 16k new samples a frame (1 MHz at 60 FPS),
+    // plotted whole across the screen and zoomed into the newest 10^4 below it
+    BenchScenario Telemetry(size_t samples = 100000000)
+    {
+        auto full = std::make_shared<std::unique_ptr<TelemetryPlot>>();
+        auto recent = std::make_shared<std::unique_ptr<TelemetryPlot>>();
+        auto fill = [](TelemetryPlot &plot, uint64_t first, size_t count) {
+            const size_t chunk = 1 << 16;
+            for (size_t done = 0; done < count; done += chunk)
+            {
+                for (size_t i = done; i < std::min(count, done + chunk); i++)
+                    plot.input().push((float)std::sin((first + i) * 1e-5) + (float)((first + i) * 2654435761u % 1000) * 1e-4f);
+                plot.update();
+            }
+        };
+        BenchScenario scenario;
+        scenario.name = "telemetry";
+        scenario.setup = [full, recent, fill, samples]() {
+            *full = std::make_unique<TelemetryPlot>(samples, 1 << 16);
+            *recent = std::make_unique<TelemetryPlot>(10000, 1 << 16);
+            fill(**full, 0, samples);
+            return true;
+        };
+        scenario.frame = [full, recent, fill, samples](BenchFrame &frame) {
+            uint64_t first = samples + frame.index * 16384;
+            fill(**full, first, 16384);
+            fill(**recent, first, 16384);
+            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+            ImGui::Begin("Telemetry", nullptr, ImGuiWindowFlags_NoDecoration);
+            (*full)->draw("Full history", ImVec2(0.0f, 300.0f));
+            (*recent)->draw("Newest 10^4", ImVec2(0.0f, 300.0f));
+            ImGui::End();
+        };
+        scenario.teardown = [full, recent]() {
+            full->reset();
+            recent->reset();
+        };
+        return scenario;
+    }
+
+    // The same stream as a GPU-expanded line over the whole 2^24-sample history; the CPU side
+    // of a frame is two ImDrawList callbacks and the upload of the new samples
+    BenchScenario GpuLines(size_t samples = 1 << 24)
+    {
+        auto plot = std::make_shared<std::unique_ptr<GpuLinePlot>>();
+        BenchScenario scenario;
+        scenario.name = "gpu_lines";
+        scenario.setup = [plot, samples]() {
+            // the ring holds the whole prefill until the first frame's callback uploads it
+            *plot = std::make_unique<GpuLinePlot>(samples, samples);
+            for (size_t i = 0; i < samples; i++)
+                (*plot)->input().push((float)std::sin(i * 1e-5) + (float)(i * 2654435761u % 1000) * 1e-4f);
+            return true;
+        };
+        scenario.frame = [plot, samples](BenchFrame &frame) {
+            uint64_t first = samples + frame.index * 16384;
+            for (uint64_t i = first; i < first + 16384; i++)
+                (*plot)->input().push((float)std::sin(i * 1e-5) + (float)(i * 2654435761u % 1000) * 1e-4f);
+            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+            ImGui::Begin("GPU lines", nullptr, ImGuiWindowFlags_NoDecoration);
+            (*plot)->draw("Full history", ImVec2(0.0f, 300.0f));
+            ImGui::End();
+            // the line's glDrawArrays runs inside the ImGui pass, which doesn't count callbacks
+            frame.draw_calls += 1;
+        };
+        scenario.teardown = [plot]() {
+            (*plot)->shutdown();
+            plot->reset();
+        };
+        return scenario;
+    }
+    // A 10^7-row, three-column table re-sorted by another column (or direction)
+    // every 60 frames; the sorts run on the job system, so frames only pay for the visible rows
+    struct TableState
+    {
+        JobSystem jobs;
+        std::unique_ptr<ColumnarTable> table;
+    };
+
+    BenchScenario ColumnarRows(size_t rows = 10000000)
+    {
+        auto state = std::make_shared<TableState>();
+        BenchScenario scenario;
+        scenario.name = "columnar_table";
+        scenario.setup = [state, rows]() {
+            state->jobs.init();
+            state->table = std::make_unique<ColumnarTable>(state->jobs);
+            TableColumn &ids = state->table->addColumn("id", ColumnType::Int64);
+            TableColumn &values = state->table->addColumn("value", ColumnType::Double);
+            TableColumn &names = state->table->addColumn("name", ColumnType::String);
+            ids.ints.reserve(rows);
+            values.doubles.reserve(rows);
+            names.offsets.reserve(rows + 1);
+            char name[32];
+            for (size_t i = 0; i < rows; i++)
+            {
+                uint32_t hash = (uint32_t)(i * 2654435761u);
+                ids.push((int64_t)i);
+                values.push((double)(hash % 1000000) * 1e-3);
+                names.push(name, (size_t)snprintf(name, sizeof(name), "item %u", hash % 100000));
+            }
+            return true;
+        };
+        scenario.frame = [state](BenchFrame &frame) {
+            if (frame.index % 60 == 0)
+                state->table->sortBy((int)(frame.index / 60 % 3), frame.index / 180 % 2 == 0);
+            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+            ImGui::Begin("Columnar table", nullptr, ImGuiWindowFlags_NoDecoration);
+            state->table->draw("rows");
+            ImGui::End();
+        };
+        scenario.teardown = [state]() {
+            state->table.reset();
+            state->jobs.shutdown();
+        };
+        return scenario;
+    }
+    // A 2*10^6-line log that grows by 100 lines a frame, followed at the end like `tail -f`;
+    // a frame draws one screen of lines whatever the file size
+    BenchScenario LogTail(int lines = 2000000)
+    {
+        auto viewer = std::make_shared<LogViewer>();
+        auto filename = std::make_shared<std::string>((std::filesystem::temp_directory_path() / "bench_log_viewer.log").string());
+        auto writeLines = [filename](int first, int count) {
+            std::ofstream file(*filename, std::ios::binary | std::ios::app);
+            for (int i = first; i < first + count; i++)
+                file << "2024-01-01 12:00:00.000 [worker " << i % 8 << "] request " << i << " took " << i % 997 << " us\n";
+        };
+        BenchScenario scenario;
+        scenario.name = "log_viewer";
+        scenario.setup = [viewer, filename, writeLines, lines]() {
+            std::filesystem::remove(*filename);
+            writeLines(0, lines);
+            return viewer->open(*filename);
+        };
+        scenario.frame = [viewer, writeLines, lines](BenchFrame &frame) {
+            writeLines(lines + (int)frame.index * 100, 100);
+            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+            ImGui::Begin("Log", nullptr, ImGuiWindowFlags_NoDecoration);
+            viewer->draw("Lines");
+            ImGui::End();
+        };
+        scenario.teardown = [viewer, filename]() {
+            viewer->close();
+            std::filesystem::remove(*filename);
+        };
+        return scenario;
+    }
+    // 400 512x512 images scrolled through as a 128-pixel thumbnail grid under a 64 MB budget, so
+    // decodes, staged uploads and evictions all run during the measured frames
+    struct GalleryState
+    {
+        JobSystem jobs;
+        std::unique_ptr<TextureManager> textures;
+        std::filesystem::path folder;
+        std::vector<std::string> images;
+    };
+
+    BenchScenario TextureGallery(int count = 400, int size = 512)
+    {
+        auto state = std::make_shared<GalleryState>();
+        BenchScenario scenario;
+        scenario.name = "texture_gallery";
+        scenario.setup = [state, count, size]() {
+            state->jobs.init();
+            state->textures = std::make_unique<TextureManager>(state->jobs, 64 << 20);
+            state->folder = std::filesystem::temp_directory_path() / "bench_texture_gallery";
+            std::filesystem::create_directories(state->folder);
+            // uncompressed 32-bit TGA, top-left origin, BGRA
+            std::vector<uint8_t> pixels((size_t)size * size * 4);
+            for (int i = 0; i < count; i++)
+            {
+                for (size_t p = 0; p < pixels.size(); p += 4)
+                {
+                    size_t x = p / 4 % size, y = p / 4 / size;
+                    pixels[p + 0] = (uint8_t)(x + i * 13);
+                    pixels[p + 1] = (uint8_t)(y + i * 7);
+                    pixels[p + 2] = (uint8_t)((x ^ y) + i);
+                    pixels[p + 3] = 255;
+                }
+                uint8_t header[18] = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, (uint8_t)size, (uint8_t)(size >> 8), (uint8_t)size, (uint8_t)(size >> 8), 32, 0x28};
+                std::string filename = (state->folder / ("image" + std::to_string(i) + ".tga")).string();
+                std::ofstream file(filename, std::ios::binary);
+                file.write((const char *)header, sizeof(header));
+                file.write((const char *)pixels.data(), pixels.size());
+                if (!file)
+                    return false;
+                state->images.push_back(filename);
+            }
+            return true;
+        };
+        scenario.frame = [state](BenchFrame &frame) {
+            state->textures->newFrame();
+            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+            ImGui::Begin("Gallery", nullptr, ImGuiWindowFlags_NoDecoration);
+            const float thumbnail = 128.0f;
+            float rowHeight = thumbnail + ImGui::GetStyle().ItemSpacing.y;
+            int columns = std::max(1, (int)(ImGui::GetContentRegionAvail().x / (thumbnail + ImGui::GetStyle().ItemSpacing.x)));
+            int rows = ((int)state->images.size() + columns - 1) / columns;
+            ImGui::SetScrollY(std::fmod(frame.index * 8.0f, std::max(1.0f, rows * rowHeight - ImGui::GetWindowHeight())));
+            ImGuiListClipper clipper;
+            clipper.Begin(rows, rowHeight);
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+                {
+                    for (int column = 0; column < columns && row * columns + column < (int)state->images.size(); column++)
+                    {
+                        if (column > 0)
+                            ImGui::SameLine();
+                        state->textures->image(state->images[row * columns + column], ImVec2(thumbnail, thumbnail));
+                    }
+                }
+            }
+            ImGui::End();
+        };
+        scenario.teardown = [state]() {
+            state->textures->shutdown();
+            state->textures.reset();
+            state->jobs.shutdown();
+            std::error_code error;
+            std::filesystem::remove_all(state->folder, error);
+        };
+        return scenario;
+    }
+
+    // The demo window recorded into a GIF every frame, read back from a foreground draw list
+    // callback once everything else is drawn; shows what the readback ring and the hand-off to
+    // the encoder cost a frame, as the encoding itself happens on its own thread
+    struct CaptureState
+    {
+        std::unique_ptr<FrameCapture> capture;
+        std::filesystem::path file;
+        int width = 0;
+        int height = 0;
+    };
+
+    BenchScenario FrameCaptureGif()
+    {
+        auto state = std::make_shared<CaptureState>();
+        BenchScenario scenario;
+        scenario.name = "frame_capture";
+        scenario.setup = [state]() {
+            state->capture = std::make_unique<FrameCapture>();
+            state->file = std::filesystem::temp_directory_path() / "bench_frame_capture.gif";
+            CaptureOptions options;
+            options.path = state->file.string();
+            return state->capture->start(options);
+        };
+        scenario.frame = [state](BenchFrame &) {
+            ImGui::SetNextWindowPos(ImVec2(20.0f, 20.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(600.0f, 680.0f), ImGuiCond_Always);
+            ImGui::ShowDemoWindow();
+            ImGuiIO &io = ImGui::GetIO();
+            state->width = (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x);
+            state->height = (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y);
+            ImDrawList *drawList = ImGui::GetForegroundDrawList();
+            drawList->AddCallback([](const ImDrawList *, const ImDrawCmd *cmd) {
+                CaptureState *capture = (CaptureState *)cmd->UserCallbackData;
+                capture->capture->frame(capture->width, capture->height);
+            }, state.get());
+            drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+        };
+        scenario.teardown = [state]() {
+            state->capture->shutdown();
+            // waits for the encoder to write the rest
+            state->capture.reset();
+            std::error_code error;
+            std::filesystem::remove(state->file, error);
+        };
+        return scenario;
+    }
+
+    // The demo window streamed to a RemoteClient over loopback, sent from a foreground draw list
+    // callback where the frame's draw data is complete; measures the capture and delta encoding
+    // the app thread pays per frame, the socket writes being on the server's own thread
+    struct RemoteState
+    {
+        std::unique_ptr<RemoteServer> server;
+        std::unique_ptr<RemoteClient> client;
+    };
+
+    BenchScenario RemoteStream()
+    {
+        auto state = std::make_shared<RemoteState>();
+        BenchScenario scenario;
+        scenario.name = "remote";
+        scenario.setup = [state]() {
+            // port 0 lets the system pick a free one, so a viewer or a parallel run can't be in the way
+            state->server = std::make_unique<RemoteServer>();
+            state->client = std::make_unique<RemoteClient>();
+            if (!state->server->listen("127.0.0.1:0") || state->server->port() < 0)
+                return false;
+            if (!state->client->connect("127.0.0.1:" + std::to_string(state->server->port())))
+                return false;
+            for (int i = 0; i < 100 && !state->server->connected(); i++)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            return state->server->connected();
+        };
+        scenario.frame = [state](BenchFrame &) {
+            ImGui::SetNextWindowPos(ImVec2(20.0f, 20.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(600.0f, 680.0f), ImGuiCond_Always);
+            ImGui::ShowDemoWindow();
+            ImDrawList *drawList = ImGui::GetForegroundDrawList();
+            drawList->AddCallback([](const ImDrawList *, const ImDrawCmd *cmd) {
+                ((RemoteState *)cmd->UserCallbackData)->server->send(ImGui::GetDrawData());
+            }, state.get());
+            drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+        };
+        scenario.teardown = [state]() {
+            RemoteStats stats = state->server->stats();
+            printf("remote: %llu frames sent, %.1f KB per frame, %.1f KB without deltas\n", (unsigned long long)stats.frames_sent,
+                   stats.frames_sent ? stats.bytes_sent / 1024.0 / stats.frames_sent : 0.0, stats.frames_sent ? stats.raw_bytes / 1024.0 / stats.frames_sent : 0.0);
+            state->client.reset();
+            state->server.reset();
+        };
+        return scenario;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    HeadlessOptions options;
+    options.frames = 300;
+    if (!parseHeadlessOptions(argc, argv, options))
+        return 1;
+
+    int warmup = 30;
+    double threshold = 10.0;
+    std::string csvFile, jsonFile, baselineFile;
+    std::vector<std::string> only;
+    bool indirect = true;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        // parseHeadlessOptions already checked its own options
+        if (strcmp(arg, "--headless") == 0)
+            continue;
+        bool headlessOption = strcmp(arg, "--frames") == 0 || strcmp(arg, "--size") == 0 || strcmp(arg, "--context") == 0;
+        bool benchOption = strcmp(arg, "--warmup") == 0 || strcmp(arg, "--threshold") == 0 || strcmp(arg, "--scenario") == 0 ||
+                           strcmp(arg, "--csv") == 0 || strcmp(arg, "--json") == 0 || strcmp(arg, "--baseline") == 0 ||
+                           strcmp(arg, "--renderer") == 0;
+        if (!headlessOption && !benchOption)
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 1;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << arg << " needs a value\n";
+            return 1;
+        }
+        const char *value = argv[++i];
+        char *end = nullptr;
+        if (strcmp(arg, "--warmup") == 0)
+        {
+            long frames = strtol(value, &end, 10);
+            if (end == value || *end != '\0' || frames < 0 || frames > INT_MAX)
+            {
+                std::cerr << "--warmup needs a frame count\n";
+                return 1;
+            }
+            warmup = (int)frames;
+        }
+        else if (strcmp(arg, "--threshold") == 0)
+        {
+            threshold = strtod(value, &end);
+            if (end == value || *end != '\0' || threshold < 0.0)
+            {
+                std::cerr << "--threshold needs a percentage\n";
+                return 1;
+            }
+        }
+        else if (strcmp(arg, "--scenario") == 0)
+            only.push_back(value);
+        else if (strcmp(arg, "--csv") == 0)
+            csvFile = value;
+        else if (strcmp(arg, "--json") == 0)
+            jsonFile = value;
+        else if (strcmp(arg, "--baseline") == 0)
+            baselineFile = value;
+        else if (strcmp(arg, "--renderer") == 0)
+        {
+            if (strcmp(value, "loop") != 0 && strcmp(value, "mdi") != 0)
+            {
+                std::cerr << "--renderer needs mdi or loop\n";
+                return 1;
+            }
+            indirect = strcmp(value, "loop") != 0;
+        }
+    }
+
+    FrameBench bench;
+    bench.setIndirectRendering(indirect);
+    if (!bench.init(options))
+    {
+        std::cerr << "Failed to create the benchmark context\n";
+        return 1;
+    }
+
+    std::vector<BenchScenario> scenarios = {
+        bench_scenarios::DemoWindow(),
+        bench_scenarios::ManyWindows(),
+        bench_scenarios::LargeTable(),
+        bench_scenarios::FontHeavyText(),
+        bench_scenarios::Cuboids(bench),
+        bench_scenarios::Telemetry(),
+        bench_scenarios::GpuLines(),
+        bench_scenarios::ColumnarRows(),
+        bench_scenarios::LogTail(),
+        bench_scenarios::TextureGallery(),
+        bench_scenarios::FrameCaptureGif(),
+        bench_scenarios::RemoteStream(),
+    };
+
+    std::vector<BenchResult> results;
+    for (const BenchScenario &scenario : scenarios)
+    {
+        if (!only.empty() && std::find(only.begin(), only.end(), scenario.name) == only.end())
+            continue;
+        BenchResult result;
+        if (!bench.run(scenario, options.frames, warmup, result))
+        {
+            bench.shutdown();
+            return 1;
+        }
+        results.push_back(result);
+    }
+    bench.shutdown();
+
+    printBenchResults(stdout, results);
+    if ((!csvFile.empty() && !writeBenchCsv(csvFile, results)) || (!jsonFile.empty() && !writeBenchJson(jsonFile, results)))
+        return 1;
+
+    if (!baselineFile.empty())
+    {
+        std::vector<BenchResult> baseline;
+        if (!readBenchCsv(baselineFile, baseline))
+            return 1;
+        if (!compareBenchResults(stdout, results, baseline, threshold))
+            return 2;
+        printf("No regressions beyond %.1f%% against %s\n", threshold, baselineFile.c_str());
+    }
+    return 0;
+}
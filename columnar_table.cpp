@@ -0,0 +1,441 @@
+#include "columnar_table.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// "lo..hi" with either side optional, or a single value; false when it doesn't parse
+	bool parseRange(const std::string& text, double& lo, double& hi)
+	{
+		size_t dots = text.find("..");
+		std::string first = dots == std::string::npos ? text : text.substr(0, dots);
+		std::string second = dots == std::string::npos ? text : text.substr(dots + 2);
+		auto parse = [](const std::string& part, double empty, double& value) {
+			if (part.find_first_not_of(' ') == std::string::npos)
+			{
+				value = empty;
+				return true;
+			}
+			char* end = nullptr;
+			value = strtod(part.c_str(), &end);
+			return end != part.c_str();
+		};
+		return parse(first, -INFINITY, lo) && parse(second, INFINITY, hi);
+	}
+
+	// Each chunk is sorted by its own job, then sorted runs are merged pairwise, every merge of a
+	// round on a job of its own. Gives up between rounds once cancel() returns true.
+	template<typename T, typename Less, typename Cancel>
+	bool parallelSort(JobSystem& jobs, T* data, size_t count, const Less& less, const Cancel& cancel)
+	{
+		if (count < 2)
+			return true;
+		size_t chunks = std::max<size_t>(1, jobs.threadCount() * 4);
+		size_t run = (count + chunks - 1) / chunks;
+		jobs.parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+			for (size_t c = begin; c < end; c++)
+				if (c * run < count)
+					std::sort(data + c * run, data + std::min(count, (c + 1) * run), less);
+		});
+
+		std::vector<T> buffer(count);
+		T* from = data;
+		T* to = buffer.data();
+		for (; run < count; run *= 2)
+		{
+			if (cancel())
+				return false;
+			size_t pairs = (count + 2 * run - 1) / (2 * run);
+			jobs.parallelFor(pairs, 1, [&](size_t begin, size_t end) {
+				for (size_t p = begin; p < end; p++)
+				{
+					size_t lo = p * 2 * run, mid = std::min(count, lo + run), hi = std::min(count, lo + 2 * run);
+					std::merge(from + lo, from + mid, from + mid, from + hi, to + lo, less);
+				}
+			});
+			std::swap(from, to);
+		}
+		if (from != data)
+			std::copy(from, from + count, data);
+		return true;
+	}
+}
+
+size_t TableColumn::rows() const
+{
+	switch (type)
+	{
+	case ColumnType::Int64: return ints.size();
+	case ColumnType::Double: return doubles.size();
+	case ColumnType::String: return offsets.size() - 1;
+	}
+	return 0;
+}
+
+void TableColumn::push(const char* text, size_t length)
+{
+	chars.insert(chars.end(), text, text + length);
+	offsets.push_back(chars.size());
+}
+
+ColumnarTable::ColumnarTable(JobSystem& jobs)
+	: jobs_(jobs)
+{
+}
+
+ColumnarTable::~ColumnarTable()
+{
+	requested_generation_++;
+	if (job_running_)
+		jobs_.wait(job_counter_);
+}
+
+TableColumn& ColumnarTable::addColumn(const std::string& name, ColumnType type)
+{
+	columns_.emplace_back();
+	columns_.back().name = name;
+	columns_.back().type = type;
+	return columns_.back();
+}
+
+void ColumnarTable::sortBy(int column, bool ascending)
+{
+	Request next = wanted_;
+	next.sort.clear();
+	if (column >= 0 && column < (int)columns_.size())
+		next.sort.push_back({ column, ascending });
+	request(next);
+}
+
+void ColumnarTable::filterBy(int column, const std::string& text)
+{
+	Request next = wanted_;
+	next.filter_column = column < (int)columns_.size() ? column : -1;
+	next.filter_text = text;
+	request(next);
+}
+
+void ColumnarTable::request(const Request& next)
+{
+	wanted_ = next;
+	wanted_.generation = ++requested_generation_;
+	if (!job_running_)
+		startJob();
+}
+
+void ColumnarTable::startJob()
+{
+	running_ = wanted_;
+	job_running_ = true;
+	result_ready_ = false;
+	std::shared_ptr<const std::vector<uint32_t>> order = running_.sort == applied_.sort ? view_.order : nullptr;
+	bool same_filter = running_.filter_column == applied_.filter_column && running_.filter_text == applied_.filter_text;
+	std::shared_ptr<const std::vector<uint64_t>> selection = same_filter ? view_.selection : nullptr;
+
+	auto job = [this, request = running_, order, selection]() {
+		TableView result;
+		bool valid = rebuild(request, order, selection, result);
+		std::lock_guard<std::mutex> lock(result_mutex_);
+		result_ = std::move(result);
+		result_valid_ = valid;
+		result_ready_ = true;
+	};
+	if (jobs_.threadCount() < 2)
+		job();
+	else
+		jobs_.run(job, &job_counter_);
+}
+
+void ColumnarTable::collectJob()
+{
+	if (!job_running_)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(result_mutex_);
+		if (!result_ready_)
+			return;
+		if (result_valid_)
+		{
+			view_ = std::move(result_);
+			applied_ = running_;
+		}
+		result_ = TableView();
+	}
+	job_running_ = false;
+	// requests that came in meanwhile
+	if (wanted_.generation != running_.generation)
+		startJob();
+}
+
+bool ColumnarTable::rebuild(const Request& request, std::shared_ptr<const std::vector<uint32_t>> order,
+	std::shared_ptr<const std::vector<uint64_t>> selection, TableView& result) const
+{
+	size_t rows = rowCount();
+	auto start = std::chrono::steady_clock::now();
+	if (!order || order->size() != rows)
+	{
+		auto sorted = std::make_shared<std::vector<uint32_t>>(rows);
+		if (!sortRows(request.sort, *sorted, request.generation))
+			return false;
+		order = sorted;
+		result.sort_ms = millisecondsSince(start);
+	}
+	else
+	{
+		result.sort_ms = view_.sort_ms;
+	}
+
+	start = std::chrono::steady_clock::now();
+	bool filtered = request.filter_column >= 0 && !request.filter_text.empty();
+	if (filtered && !selection)
+	{
+		auto bits = std::make_shared<std::vector<uint64_t>>((rows + 63) / 64);
+		if (!filterRows(request.filter_column, request.filter_text, *bits, request.generation))
+			return false;
+		selection = bits;
+	}
+	if (!filtered)
+		selection = nullptr;
+
+	if (!selection)
+	{
+		result.rows = order;
+	}
+	else
+	{
+		// Keep the selected rows in sorted order: count per chunk, then each chunk writes its
+		// rows at the prefix sum of the counts before it
+		const std::vector<uint32_t>& in = *order;
+		const std::vector<uint64_t>& bits = *selection;
+		auto selected = [&](uint32_t row) { return (bits[row >> 6] >> (row & 63)) & 1; };
+		size_t chunks = std::max<size_t>(1, jobs_.threadCount() * 4);
+		size_t chunk_size = (rows + chunks - 1) / chunks;
+		std::vector<size_t> counts(chunks + 1, 0);
+		jobs_.parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+			for (size_t c = begin; c < end; c++)
+				for (size_t i = c * chunk_size; i < std::min(rows, (c + 1) * chunk_size); i++)
+					counts[c + 1] += selected(in[i]);
+		});
+		for (size_t c = 0; c < chunks; c++)
+			counts[c + 1] += counts[c];
+		auto out = std::make_shared<std::vector<uint32_t>>(counts[chunks]);
+		jobs_.parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+			for (size_t c = begin; c < end; c++)
+			{
+				size_t at = counts[c];
+				for (size_t i = c * chunk_size; i < std::min(rows, (c + 1) * chunk_size); i++)
+					if (selected(in[i]))
+						(*out)[at++] = in[i];
+			}
+		});
+		result.rows = out;
+	}
+	result.order = order;
+	result.selection = selection;
+	result.filter_ms = filtered ? millisecondsSince(start) : 0.0;
+	return !cancelled(request.generation);
+}
+
+// Sorts row indices, never row data. Ties fall back to the row index, so the result is the same
+// whatever the chunking. A single numeric key is copied next to its row first: comparing those
+// pairs stays in cache, where going through the column for every comparison does not.
+bool ColumnarTable::sortRows(const std::vector<SortKey>& keys, std::vector<uint32_t>& order, uint64_t generation) const
+{
+	size_t rows = order.size();
+	auto cancel = [&]() { return cancelled(generation); };
+	if (keys.size() == 1 && columns_[keys[0].column].type != ColumnType::String)
+	{
+		const TableColumn& column = columns_[keys[0].column];
+		bool ascending = keys[0].ascending;
+		auto sortPairs = [&](const auto& values) {
+			using Value = typename std::decay_t<decltype(values)>::value_type;
+			std::vector<std::pair<Value, uint32_t>> pairs(rows);
+			jobs_.parallelFor(rows, 65536, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+					pairs[i] = { values[i], (uint32_t)i };
+			});
+			auto less = [ascending](const std::pair<Value, uint32_t>& a, const std::pair<Value, uint32_t>& b) {
+				if (a.first != b.first)
+					return ascending ? a.first < b.first : a.first > b.first;
+				return a.second < b.second;
+			};
+			if (!parallelSort(jobs_, pairs.data(), rows, less, cancel))
+				return false;
+			jobs_.parallelFor(rows, 65536, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+					order[i] = pairs[i].second;
+			});
+			return true;
+		};
+		bool sorted = column.type == ColumnType::Int64 ? sortPairs(column.ints) : sortPairs(column.doubles);
+		return sorted && !cancel();
+	}
+
+	jobs_.parallelFor(rows, 65536, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			order[i] = (uint32_t)i;
+	});
+	if (keys.empty())
+		return true;
+	auto less = [&](uint32_t a, uint32_t b) {
+		for (const SortKey& key : keys)
+		{
+			const TableColumn& column = columns_[key.column];
+			int order_ab = 0;
+			switch (column.type)
+			{
+			case ColumnType::Int64:
+				order_ab = column.ints[a] < column.ints[b] ? -1 : column.ints[a] > column.ints[b] ? 1 : 0;
+				break;
+			case ColumnType::Double:
+				order_ab = column.doubles[a] < column.doubles[b] ? -1 : column.doubles[a] > column.doubles[b] ? 1 : 0;
+				break;
+			case ColumnType::String:
+				order_ab = std::string_view(column.stringBegin(a), column.stringEnd(a) - column.stringBegin(a))
+					.compare(std::string_view(column.stringBegin(b), column.stringEnd(b) - column.stringBegin(b)));
+				break;
+			}
+			if (order_ab != 0)
+				return key.ascending ? order_ab < 0 : order_ab > 0;
+		}
+		return a < b;
+	};
+	return parallelSort(jobs_, order.data(), rows, less, cancel) && !cancel();
+}
+
+bool ColumnarTable::filterRows(int column_index, const std::string& text, std::vector<uint64_t>& selection, uint64_t generation) const
+{
+	const TableColumn& column = columns_[column_index];
+	size_t rows = rowCount();
+	double lo = 0.0, hi = 0.0;
+	if (column.type != ColumnType::String && !parseRange(text, lo, hi))
+	{
+		// not a number yet, e.g. half typed: show everything rather than nothing
+		std::fill(selection.begin(), selection.end(), ~uint64_t(0));
+		return true;
+	}
+
+	std::string_view needle(text);
+	// one 64-row word per step, so no two jobs write the same word
+	jobs_.parallelFor(selection.size(), 1024, [&](size_t begin, size_t end) {
+		for (size_t word = begin; word < end; word++)
+		{
+			uint64_t bits = 0;
+			size_t first = word * 64, last = std::min(rows, first + 64);
+			for (size_t row = first; row < last; row++)
+			{
+				bool match = false;
+				switch (column.type)
+				{
+				case ColumnType::Int64: match = column.ints[row] >= lo && column.ints[row] <= hi; break;
+				case ColumnType::Double: match = column.doubles[row] >= lo && column.doubles[row] <= hi; break;
+				case ColumnType::String:
+					match = std::string_view(column.stringBegin(row), column.stringEnd(row) - column.stringBegin(row)).find(needle) != std::string_view::npos;
+					break;
+				}
+				bits |= (uint64_t)match << (row - first);
+			}
+			selection[word] = bits;
+		}
+	});
+	return !cancelled(generation);
+}
+
+void ColumnarTable::draw(const char* label, float height)
+{
+	collectJob();
+	if (columns_.empty())
+		return;
+	ImGui::PushID(label);
+
+	bool filter_changed = false;
+	ImGui::SetNextItemWidth(140.0f);
+	if (ImGui::BeginCombo("##column", columns_[filter_column_].name.c_str()))
+	{
+		for (int c = 0; c < (int)columns_.size(); c++)
+		{
+			if (ImGui::Selectable(columns_[c].name.c_str(), c == filter_column_))
+			{
+				filter_changed = c != filter_column_;
+				filter_column_ = c;
+			}
+		}
+		ImGui::EndCombo();
+	}
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(220.0f);
+	const char* hint = columns_[filter_column_].type == ColumnType::String ? "contains" : "lo..hi";
+	filter_changed |= ImGui::InputTextWithHint("##filter", hint, filter_text_, sizeof(filter_text_));
+	if (filter_changed)
+		filterBy(filter_column_, filter_text_);
+
+	const std::vector<uint32_t>* rows = view_.rows.get();
+	size_t count = rows ? rows->size() : rowCount();
+	ImGui::SameLine();
+	ImGui::Text("%zu of %zu rows", count, rowCount());
+	ImGui::SameLine();
+	if (job_running_)
+		ImGui::TextDisabled("updating...");
+	else
+		ImGui::TextDisabled("sort %.1f ms, filter %.1f ms", view_.sort_ms, view_.filter_ms);
+
+	ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable
+		| ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable | ImGuiTableFlags_Sortable | ImGuiTableFlags_SortMulti;
+	if (ImGui::BeginTable(label, (int)columns_.size(), flags, ImVec2(0.0f, height)))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		for (int c = 0; c < (int)columns_.size(); c++)
+			ImGui::TableSetupColumn(columns_[c].name.c_str(), ImGuiTableColumnFlags_None, 0.0f, (ImGuiID)c);
+		ImGui::TableHeadersRow();
+
+		if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs())
+		{
+			if (specs->SpecsDirty)
+			{
+				Request next = wanted_;
+				next.sort.clear();
+				for (int i = 0; i < specs->SpecsCount; i++)
+					next.sort.push_back({ (int)specs->Specs[i].ColumnUserID, specs->Specs[i].SortDirection == ImGuiSortDirection_Ascending });
+				if (!(next.sort == wanted_.sort))
+					request(next);
+				specs->SpecsDirty = false;
+			}
+		}
+
+		ImGuiListClipper clipper;
+		clipper.Begin((int)count);
+		while (clipper.Step())
+		{
+			for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++)
+			{
+				uint32_t row = rows ? (*rows)[r] : (uint32_t)r;
+				ImGui::TableNextRow();
+				for (int c = 0; c < (int)columns_.size(); c++)
+				{
+					ImGui::TableSetColumnIndex(c);
+					const TableColumn& column = columns_[c];
+					switch (column.type)
+					{
+					case ColumnType::Int64: ImGui::Text("%lld", (long long)column.ints[row]); break;
+					case ColumnType::Double: ImGui::Text("%.6g", column.doubles[row]); break;
+					case ColumnType::String: ImGui::TextUnformatted(column.stringBegin(row), column.stringEnd(row)); break;
+					}
+				}
+			}
+		}
+		ImGui::EndTable();
+	}
+	ImGui::PopID();
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+
+enum class ColumnType
+{
+	Int64,
+	Double,
+	String
+};
+
+// One typed column stored contiguously. Strings are packed back to back in chars with
+// offsets[i]..offsets[i + 1] delimiting row i, so a cell is drawn straight from the blob.
+struct TableColumn
+{
+	std::string name;
+	ColumnType type = ColumnType::Int64;
+	std::vector<int64_t> ints;
+	std::vector<double> doubles;
+	std::vector<uint64_t> offsets{ 0 };
+	std::vector<char> chars;
+
+	size_t rows() const;
+	void push(int64_t value) { ints.push_back(value); }
+	void push(double value) { doubles.push_back(value); }
+	void push(const char* text, size_t length);
+	const char* stringBegin(size_t row) const { return chars.data() + offsets[row]; }
+	const char* stringEnd(size_t row) const { return chars.data() + offsets[row + 1]; }
+};
+
+// What the table shows: row order after sorting, the filter's selection bitmap (empty when
+// nothing is filtered) and the order with the unselected rows taken out
+struct TableView
+{
+	std::shared_ptr<const std::vector<uint32_t>> order;
+	std::shared_ptr<const std::vector<uint64_t>> selection;
+	std::shared_ptr<const std::vector<uint32_t>> rows;
+	double sort_ms = 0.0;
+	double filter_ms = 0.0;
+};
+
+// Read-only table of millions of rows kept column by column. Only the rows in view are submitted,
+// through ImGuiListClipper. Sorting never moves row data: it builds a permutation of row indices,
+// in parallel on the job system, and filtering builds a bitmap over the rows. Both run as one
+// background job; the frame keeps showing the previous view until the new one is swapped in.
+//
+// Fill the columns before the first draw() and leave them alone afterwards.
+class ColumnarTable
+{
+public:
+	// jobs needs worker threads for the rebuilds to run off the calling thread; with only the
+	// calling thread they run inside draw()
+	explicit ColumnarTable(JobSystem& jobs);
+	~ColumnarTable();
+
+	TableColumn& addColumn(const std::string& name, ColumnType type);
+	size_t rowCount() const { return columns_.empty() ? 0 : columns_[0].rows(); }
+
+	// Both requests replace the previous one and take effect once the rebuild finishes.
+	// column < 0 clears the sort or the filter.
+	void sortBy(int column, bool ascending = true);
+	// Strings: rows containing text. Numbers: "lo..hi" with either side optional, or one value.
+	void filterBy(int column, const std::string& text);
+
+	bool busy() const { return job_running_; }
+	const TableView& view() const { return view_; }
+
+	void draw(const char* label, float height = 0.0f);
+
+private:
+	struct SortKey
+	{
+		int column;
+		bool ascending;
+		bool operator==(const SortKey& other) const { return column == other.column && ascending == other.ascending; }
+	};
+
+	struct Request
+	{
+		std::vector<SortKey> sort;
+		int filter_column = -1;
+		std::string filter_text;
+		uint64_t generation = 0;
+	};
+
+	void request(const Request& next);
+	void startJob();
+	void collectJob();
+	// Run on the job system; false when a newer request made the result pointless. A sort order or
+	// selection that the request shares with the current view is passed in and reused.
+	bool rebuild(const Request& request, std::shared_ptr<const std::vector<uint32_t>> order,
+		std::shared_ptr<const std::vector<uint64_t>> selection, TableView& result) const;
+	bool cancelled(uint64_t generation) const { return generation != requested_generation_.load(std::memory_order_relaxed); }
+	bool sortRows(const std::vector<SortKey>& keys, std::vector<uint32_t>& order, uint64_t generation) const;
+	bool filterRows(int column, const std::string& text, std::vector<uint64_t>& selection, uint64_t generation) const;
+
+	JobSystem& jobs_;
+	std::deque<TableColumn> columns_;  // addColumn() references stay valid
+	TableView view_;
+
+	Request wanted_;          // latest request
+	Request applied_;         // what view_ shows
+	Request running_;         // what the job is building
+	bool job_running_ = false;
+	std::atomic<uint64_t> requested_generation_{ 0 };
+	JobCounter job_counter_;
+	std::mutex result_mutex_;
+	bool result_ready_ = false;
+	bool result_valid_ = false;
+	TableView result_;
+
+	// filter input
+	int filter_column_ = 0;
+	char filter_text_[128] = {};
+};
@@ -15,6 +15,7 @@ class ImGuiExample(ConanFile):
         self.requires("glew/2.2.0")
         self.requires("glm/cci.20230113")
         self.requires("imguizmo/cci.20231114")
+        self.requires("stb/cci.20230920")
 
     def generate(self):
         copy(self, "*glfw*", os.path.join(self.dependencies["imgui"].package_folder,
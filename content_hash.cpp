@@ -0,0 +1,119 @@
+#include "content_hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONTENT_HASH_SSE2 1
+#endif
+
+namespace
+{
+	const size_t kStripe = 64;
+	const size_t kStripesPerBlock = 16;  // scrambled after each
+	const uint64_t kPrime32 = 0x9E3779B1u;
+	const uint64_t kPrime64_1 = 0x9E3779B185EBCA87ull;
+	const uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4Full;
+	const uint64_t kPrime64_3 = 0x165667B19E3779F9ull;
+	const uint64_t kKeyStep = 0x9E3779B97F4A7C15ull;
+	alignas(16) const uint64_t kKeys[8] = {
+		0xBE4BA423396CFEB8ull, 0x1CAD21F72C81017Cull, 0xDB979083E96DD4DEull, 0x1F67B3B7A4A44072ull,
+		0x78E5C0CC4EE679CBull, 0x2172FFCC7DD05A82ull, 0x8E2443F7744608B8ull, 0x4C263A81E69035E0ull,
+	};
+
+	uint64_t rotl(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	// Each lane j gains (lo32 * hi32) of its input XOR key, and its neighbour j ^ 1 the input
+	// itself so no bits are lost to a zero half
+	void accumulate(uint64_t* acc, uint64_t* keys, const uint8_t* data, size_t stripes)
+	{
+#if defined(CONTENT_HASH_SSE2)
+		__m128i a[4], k[4];
+		const __m128i step = _mm_set1_epi64x((long long)kKeyStep);
+		for (int v = 0; v < 4; v++)
+		{
+			a[v] = _mm_load_si128((const __m128i*)(acc + v * 2));
+			k[v] = _mm_load_si128((const __m128i*)(keys + v * 2));
+		}
+		for (size_t s = 0; s < stripes; s++, data += kStripe)
+		{
+			for (int v = 0; v < 4; v++)
+			{
+				__m128i d = _mm_loadu_si128((const __m128i*)(data + v * 16));
+				__m128i dk = _mm_xor_si128(d, k[v]);
+				__m128i product = _mm_mul_epu32(dk, _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1)));
+				__m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+				a[v] = _mm_add_epi64(a[v], _mm_add_epi64(product, swapped));
+				k[v] = _mm_add_epi64(k[v], step);
+			}
+		}
+		for (int v = 0; v < 4; v++)
+		{
+			_mm_store_si128((__m128i*)(acc + v * 2), a[v]);
+			_mm_store_si128((__m128i*)(keys + v * 2), k[v]);
+		}
+#else
+		for (size_t s = 0; s < stripes; s++, data += kStripe)
+		{
+			for (int j = 0; j < 8; j++)
+			{
+				uint64_t d;
+				memcpy(&d, data + j * 8, 8);
+				uint64_t dk = d ^ keys[j];
+				acc[j ^ 1] += d;
+				acc[j] += (dk & 0xFFFFFFFFu) * (dk >> 32);
+				keys[j] += kKeyStep;
+			}
+		}
+#endif
+	}
+
+	void scramble(uint64_t* acc)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			acc[j] ^= acc[j] >> 47;
+			acc[j] ^= kKeys[j];
+			acc[j] *= kPrime32;
+		}
+	}
+}
+
+uint64_t contentHash(const void* data, size_t size, uint64_t seed)
+{
+	alignas(16) uint64_t acc[8] = { kPrime32, kPrime64_1, kPrime64_2, kPrime64_3, kPrime64_1 ^ seed, kPrime64_2, kPrime64_3, kPrime32 ^ seed };
+	alignas(16) uint64_t keys[8];
+	for (int j = 0; j < 8; j++)
+		keys[j] = kKeys[j] + seed;
+
+	const uint8_t* bytes = (const uint8_t*)data;
+	size_t stripes = size / kStripe;
+	for (size_t first = 0; first < stripes; first += kStripesPerBlock)
+	{
+		size_t count = std::min(kStripesPerBlock, stripes - first);
+		accumulate(acc, keys, bytes + first * kStripe, count);
+		if (count == kStripesPerBlock)
+			scramble(acc);
+	}
+	if (size % kStripe != 0)
+	{
+		// zero padded; the length below tells it from data that really ends in zeros
+		alignas(16) uint8_t last[kStripe] = {};
+		memcpy(last, bytes + stripes * kStripe, size % kStripe);
+		accumulate(acc, keys, last, 1);
+	}
+
+	uint64_t hash = (uint64_t)size * kPrime64_1 ^ seed;
+	for (int j = 0; j < 8; j++)
+		hash = rotl(hash + acc[j] * kPrime64_2, 31) * kPrime64_1;
+	hash ^= hash >> 33;
+	hash *= kPrime64_2;
+	hash ^= hash >> 29;
+	hash *= kPrime64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
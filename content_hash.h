@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A fast 64-bit hash of a byte range, for telling whether data changed since it was last seen,
+// not for hash tables facing untrusted keys. Eight 64-bit lanes each take a multiply of the two
+// halves of their 8 bytes XORed with a key that advances every 64-byte stripe, in the manner of
+// XXH3, and are scrambled every kilobyte; SSE2 does two lanes an instruction where it is there.
+// The SSE2 and scalar paths give the same value.
+//
+// seed chains ranges: contentHash(b, nb, contentHash(a, na)) covers a and then b.
+uint64_t contentHash(const void* data, size_t size, uint64_t seed = 0);
@@ -0,0 +1,63 @@
+#include "draw_data_snapshot.h"
+
+#include <new>
+
+namespace
+{
+	// Points destination at an arena copy of source; ImVector would free its Data on
+	// destruction, so every vector filled here is detached again in clear()
+	template <typename T>
+	void copyVector(FrameArena& arena, ImVector<T>& destination, const ImVector<T>& source)
+	{
+		destination.Data = arena.copy(source.Data, (size_t)source.Size);
+		destination.Size = destination.Capacity = source.Size;
+	}
+
+	template <typename T>
+	void detachVector(ImVector<T>& vector)
+	{
+		vector.Data = nullptr;
+		vector.Size = vector.Capacity = 0;
+	}
+}
+
+void DrawDataSnapshot::capture(const ImDrawData* source)
+{
+	clear();
+	if (!source || !source->Valid)
+		return;
+
+	draw_data_.Valid = true;
+	draw_data_.CmdListsCount = source->CmdListsCount;
+	draw_data_.TotalIdxCount = source->TotalIdxCount;
+	draw_data_.TotalVtxCount = source->TotalVtxCount;
+	draw_data_.DisplayPos = source->DisplayPos;
+	draw_data_.DisplaySize = source->DisplaySize;
+	draw_data_.FramebufferScale = source->FramebufferScale;
+	draw_data_.OwnerViewport = source->OwnerViewport;
+
+	ImDrawList** lists = arena_.allocate<ImDrawList*>((size_t)source->CmdLists.Size);
+	for (int i = 0; i < source->CmdLists.Size; i++)
+	{
+		const ImDrawList* list = source->CmdLists[i];
+		// the constructor only zeroes members, and arena lists are never destroyed
+		ImDrawList* copy = new (arena_.allocate(sizeof(ImDrawList), alignof(ImDrawList))) ImDrawList(list->_Data);
+		copy->Flags = list->Flags;
+		copyVector(arena_, copy->CmdBuffer, list->CmdBuffer);
+		copyVector(arena_, copy->IdxBuffer, list->IdxBuffer);
+		copyVector(arena_, copy->VtxBuffer, list->VtxBuffer);
+		lists[i] = copy;
+	}
+	draw_data_.CmdLists.Data = lists;
+	draw_data_.CmdLists.Size = draw_data_.CmdLists.Capacity = source->CmdLists.Size;
+}
+
+void DrawDataSnapshot::clear()
+{
+	detachVector(draw_data_.CmdLists);
+	draw_data_.Valid = false;
+	draw_data_.CmdListsCount = 0;
+	draw_data_.TotalIdxCount = 0;
+	draw_data_.TotalVtxCount = 0;
+	arena_.reset();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "imgui.h"
+#include "frame_arena.h"
+
+// Deep copy of an ImDrawData whose draw lists, commands, vertices and indices all live
+// in a FrameArena, so it can be rendered on another thread while ImGui builds the next
+// frame. Re-capturing reuses the arena's memory. User callbacks are copied as pointers
+// and run on the rendering thread, so they must not touch UI-thread state.
+class DrawDataSnapshot
+{
+public:
+	DrawDataSnapshot() = default;
+	~DrawDataSnapshot() { clear(); }
+	DrawDataSnapshot(const DrawDataSnapshot&) = delete;
+	DrawDataSnapshot& operator=(const DrawDataSnapshot&) = delete;
+
+	void capture(const ImDrawData* source);
+	void clear();
+
+	ImDrawData* drawData() { return draw_data_.Valid ? &draw_data_ : nullptr; }
+	size_t bytes() const { return arena_.bytesUsed(); }
+
+private:
+	FrameArena arena_;
+	ImDrawData draw_data_;
+};
@@ -0,0 +1,156 @@
+#include "dynamic_batch.h"
+#include "file_manager.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include "memory_telemetry.h"
+
+DynamicBatch::DynamicBatch()
+	: vao_(0), vbo_(0), transform_buffer_(0), transform_texture_(0),
+	  vertex_capacity_(0), transform_capacity_(0), view_projection_(1.0f)
+{
+}
+
+DynamicBatch::~DynamicBatch()
+{
+}
+
+void DynamicBatch::init(size_t initial_vertex_capacity)
+{
+	shader_.init(FileManager::read("batch-vertex-shader.glsl"), FileManager::read("batch-fragment-shader.glsl"));
+
+	vertex_capacity_ = initial_vertex_capacity;
+	transform_capacity_ = 256;
+	vertices_.reserve(vertex_capacity_);
+	transforms_.reserve(transform_capacity_);
+
+	glGenVertexArrays(1, &vao_);
+	glGenBuffers(1, &vbo_);
+	glBindVertexArray(vao_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+	trackedBufferData(GL_ARRAY_BUFFER, vbo_, vertex_capacity_ * sizeof(Vertex), NULL, GL_STREAM_DRAW, "DynamicBatch vertices");
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, position));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void *)offsetof(Vertex, color));
+	glEnableVertexAttribArray(1);
+	glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void *)offsetof(Vertex, transform));
+	glEnableVertexAttribArray(2);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// model matrices live in a texture buffer: 4 RGBA32F texels per mat4
+	glGenBuffers(1, &transform_buffer_);
+	glBindBuffer(GL_TEXTURE_BUFFER, transform_buffer_);
+	trackedBufferData(GL_TEXTURE_BUFFER, transform_buffer_, transform_capacity_ * sizeof(glm::mat4), NULL, GL_STREAM_DRAW, "DynamicBatch transforms");
+	glGenTextures(1, &transform_texture_);
+	glBindTexture(GL_TEXTURE_BUFFER, transform_texture_);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, transform_buffer_);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void DynamicBatch::shutdown()
+{
+	glDeleteTextures(1, &transform_texture_);
+	trackedDeleteBuffers(1, &transform_buffer_);
+	trackedDeleteBuffers(1, &vbo_);
+	glDeleteVertexArrays(1, &vao_);
+	shader_.destroy();
+	vao_ = vbo_ = transform_buffer_ = transform_texture_ = 0;
+}
+
+void DynamicBatch::begin(const glm::mat4& view_projection)
+{
+	// clear() keeps the capacity, so steady-state frames do not allocate
+	view_projection_ = view_projection;
+	vertices_.clear();
+	transforms_.clear();
+	transforms_.push_back(glm::mat4(1.0f));
+}
+
+uint32_t DynamicBatch::pushTransform(const glm::mat4& model)
+{
+	transforms_.push_back(model);
+	return (uint32_t)(transforms_.size() - 1);
+}
+
+void DynamicBatch::addTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec4& color, uint32_t transform)
+{
+	uint32_t packed = packColor(color);
+	pushVertex(a, packed, transform);
+	pushVertex(b, packed, transform);
+	pushVertex(c, packed, transform);
+}
+
+void DynamicBatch::addQuad(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d, const glm::vec4& color, uint32_t transform)
+{
+	// GL_QUADS is gone in core profile, so a quad is two triangles
+	uint32_t packed = packColor(color);
+	pushVertex(a, packed, transform);
+	pushVertex(b, packed, transform);
+	pushVertex(c, packed, transform);
+	pushVertex(c, packed, transform);
+	pushVertex(d, packed, transform);
+	pushVertex(a, packed, transform);
+}
+
+void DynamicBatch::end()
+{
+	if (vertices_.empty())
+		return;
+
+	// orphan the previous storage so the driver never waits on last frame's draw
+	// (only a new size goes through the telemetry)
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+	if (vertices_.size() > vertex_capacity_)
+	{
+		vertex_capacity_ = std::max(vertices_.size(), vertex_capacity_ * 2);
+		trackedBufferData(GL_ARRAY_BUFFER, vbo_, vertex_capacity_ * sizeof(Vertex), NULL, GL_STREAM_DRAW, "DynamicBatch vertices");
+	}
+	else
+		glBufferData(GL_ARRAY_BUFFER, vertex_capacity_ * sizeof(Vertex), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, vertices_.size() * sizeof(Vertex), vertices_.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, transform_buffer_);
+	if (transforms_.size() > transform_capacity_)
+	{
+		transform_capacity_ = std::max(transforms_.size(), transform_capacity_ * 2);
+		trackedBufferData(GL_TEXTURE_BUFFER, transform_buffer_, transform_capacity_ * sizeof(glm::mat4), NULL, GL_STREAM_DRAW, "DynamicBatch transforms");
+	}
+	else
+		glBufferData(GL_TEXTURE_BUFFER, transform_capacity_ * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, transforms_.size() * sizeof(glm::mat4), transforms_.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	shader_.use();
+	shader_.setUniform("viewProjection", &view_projection_[0][0]);
+	shader_.setUniform("transforms", 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_BUFFER, transform_texture_);
+
+	glBindVertexArray(vao_);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices_.size());
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void DynamicBatch::pushVertex(const glm::vec3& position, uint32_t color, uint32_t transform)
+{
+	Vertex v;
+	v.position[0] = position.x;
+	v.position[1] = position.y;
+	v.position[2] = position.z;
+	v.color = color;
+	v.transform = transform;
+	vertices_.push_back(v);
+}
+
+uint32_t DynamicBatch::packColor(const glm::vec4& color)
+{
+	// RGBA8 in memory order, read back as normalized unsigned bytes
+	auto channel = [](float c) { return (uint32_t)(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f); };
+	return channel(color.r) | (channel(color.g) << 8) | (channel(color.b) << 16) | (channel(color.a) << 24);
+}
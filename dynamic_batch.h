@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "opengl_shader.h"
+
+// Accumulates quads and triangles during a frame and submits them with one draw call.
+// Vertices stay in model space and carry the index of their model matrix; the vertex
+// shader fetches the matrix from a texture buffer, so moving a handle only rewrites
+// its 64-byte transform instead of every vertex.
+class DynamicBatch
+{
+public:
+	DynamicBatch();
+	~DynamicBatch();
+
+	void init(size_t initial_vertex_capacity = 4096);
+	void shutdown();
+
+	// Transform 0 is always the identity.
+	void begin(const glm::mat4& view_projection);
+	uint32_t pushTransform(const glm::mat4& model);
+	void addTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec4& color, uint32_t transform = 0);
+	void addQuad(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d, const glm::vec4& color, uint32_t transform = 0);
+	void end();
+
+	size_t vertexCount() const { return vertices_.size(); }
+	size_t transformCount() const { return transforms_.size(); }
+
+private:
+	struct Vertex
+	{
+		float position[3];
+		uint32_t color;
+		uint32_t transform;
+	};
+
+	void pushVertex(const glm::vec3& position, uint32_t color, uint32_t transform);
+	static uint32_t packColor(const glm::vec4& color);
+
+	Shader shader_;
+	unsigned int vao_, vbo_, transform_buffer_, transform_texture_;
+	size_t vertex_capacity_, transform_capacity_;
+	glm::mat4 view_projection_;
+	std::vector<Vertex> vertices_;
+	std::vector<glm::mat4> transforms_;
+};
@@ -0,0 +1,64 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+FrameArena::FrameArena(size_t block_size)
+	: block_size_(block_size)
+{
+}
+
+FrameArena::~FrameArena()
+{
+	for (Block& block : blocks_)
+		free(block.data);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	if (!blocks_.empty())
+	{
+		Block& block = blocks_.back();
+		uintptr_t base = (uintptr_t)block.data;
+		size_t aligned = (size_t)(((base + offset_ + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+		if (aligned + size <= block.size)
+		{
+			offset_ = aligned + size;
+			used_ += size;
+			return block.data + aligned;
+		}
+	}
+
+	// malloc aligns to max_align_t; larger alignments get slack in the block
+	size_t block_size = std::max(block_size_, size + alignment);
+	uint8_t* data = (uint8_t*)malloc(block_size);
+	if (!data)
+		throw std::bad_alloc();
+	blocks_.push_back({ data, block_size });
+	system_allocations_++;
+	offset_ = 0;
+	return allocate(size, alignment);
+}
+
+void FrameArena::reset()
+{
+	if (blocks_.size() > 1)
+	{
+		size_t total = capacity();
+		for (Block& block : blocks_)
+			free(block.data);
+		blocks_.clear();
+		block_size_ = std::max(block_size_, total);
+	}
+	offset_ = 0;
+	used_ = 0;
+}
+
+size_t FrameArena::capacity() const
+{
+	size_t total = 0;
+	for (const Block& block : blocks_)
+		total += block.size;
+	return total;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for data that lives exactly one frame. Allocation is a pointer bump,
+// reset() releases everything at once. When a frame overflows the current block a new
+// one is chained in; the next reset() merges them into a single block of the peak size,
+// so steady-state frames never touch the system allocator.
+class FrameArena
+{
+public:
+	explicit FrameArena(size_t block_size = 256 * 1024);
+	~FrameArena();
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	template <typename T>
+	T* allocate(size_t count) { return (T*)allocate(sizeof(T) * count, alignof(T)); }
+	template <typename T>
+	T* copy(const T* source, size_t count)
+	{
+		if (count == 0)
+			return nullptr;
+		T* destination = allocate<T>(count);
+		memcpy(destination, source, sizeof(T) * count);
+		return destination;
+	}
+
+	void reset();
+	size_t bytesUsed() const { return used_; }
+	size_t capacity() const;
+	// Cumulative count of blocks malloc'd, for per-frame deltas
+	uint64_t systemAllocations() const { return system_allocations_; }
+
+private:
+	struct Block
+	{
+		uint8_t* data;
+		size_t size;
+	};
+
+	std::vector<Block> blocks_;
+	size_t block_size_;
+	size_t offset_ = 0; // into blocks_.back()
+	size_t used_ = 0;
+	uint64_t system_allocations_ = 0;
+};
+
+// std::pmr adapter so per-frame temporaries (std::pmr::vector etc.) can live in a
+// FrameArena. Deallocation is a no-op; the memory comes back at the arena's reset().
+class FrameArenaResource : public std::pmr::memory_resource
+{
+public:
+	explicit FrameArenaResource(FrameArena& arena) : arena_(arena) {}
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override { return arena_.allocate(bytes, alignment); }
+	void do_deallocate(void*, size_t, size_t) override {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	FrameArena& arena_;
+};
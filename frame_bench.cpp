@@ -0,0 +1,339 @@
+#include "frame_bench.h"
+#include "memory_telemetry.h"
+#include "imgui.h"
+#include "bindings/imgui_impl_glfw.h"
+#include "bindings/imgui_impl_opengl3.h"
+#include <GLFW/glfw3.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	struct Metric
+	{
+		const char* name;
+		double BenchResult::*value;
+		// differences below this never count as a regression, so 0 -> 1 allocations or
+		// microsecond jitter on a tiny scenario does not fail a run
+		double min_delta;
+		bool compared;
+	};
+
+	const Metric kMetrics[] = {
+		{ "cpu_mean_ms", &BenchResult::cpu_mean_ms, 0.05, true },
+		{ "cpu_p50_ms", &BenchResult::cpu_p50_ms, 0.05, true },
+		{ "cpu_p95_ms", &BenchResult::cpu_p95_ms, 0.05, true },
+		{ "cpu_p99_ms", &BenchResult::cpu_p99_ms, 0.05, false },
+		{ "cpu_max_ms", &BenchResult::cpu_max_ms, 0.05, false },
+		{ "draw_calls", &BenchResult::draw_calls, 0.5, true },
+		{ "vertices", &BenchResult::vertices, 0.5, true },
+		// not compared: baselines from before it was measured read as 0
+		{ "upload_kb", &BenchResult::upload_kb, 1.0, false },
+		{ "heap_allocations", &BenchResult::heap_allocations, 0.5, true },
+		{ "pool_allocations", &BenchResult::pool_allocations, 0.5, true },
+	};
+
+	void glfwErrorCallback(int error, const char* description)
+	{
+		fprintf(stderr, "GLFW Error %d: %s\n", error, description);
+	}
+
+	// The whole cell has to be a number; false for anything else, an empty cell included
+	bool parseNumber(const std::string& cell, double& value)
+	{
+		char* end = nullptr;
+		value = strtod(cell.c_str(), &end);
+		return end != cell.c_str() && *end == '\0';
+	}
+}
+
+bool FrameBench::init(const HeadlessOptions& options)
+{
+	options_ = options;
+	options_.enabled = true;
+
+	glfwSetErrorCallback(glfwErrorCallback);
+	if (!glfwInit())
+		return false;
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	applyHeadlessWindowHints(options_);
+	window_ = glfwCreateWindow(options_.width, options_.height, "dear-imgui-bench", nullptr, nullptr);
+	if (!window_)
+	{
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(window_);
+	glfwSwapInterval(0);
+	if (!initGlew() || !offscreen_.create(options_.width, options_.height))
+	{
+		shutdown();
+		return false;
+	}
+
+	IMGUI_CHECKVERSION();
+	ImGui::SetAllocatorFunctions(&MemoryTelemetry::imguiAlloc, &MemoryTelemetry::imguiFree, &imgui_pool_);
+	profiler_.setPool(&imgui_pool_);
+	renderer_.init();
+	return true;
+}
+
+void FrameBench::shutdown()
+{
+	// imgui_pool_ goes with this object
+	MemoryTelemetry::restoreImGuiAllocator();
+	renderer_.shutdown();
+	offscreen_.destroy();
+	if (window_)
+		glfwDestroyWindow(window_);
+	window_ = nullptr;
+	glfwTerminate();
+}
+
+void FrameBench::frame(const BenchScenario& scenario, BenchFrame& counters)
+{
+	profiler_.beginFrame();
+	glfwPollEvents();
+
+	ImGui_ImplOpenGL3_NewFrame();
+	ImGui_ImplGlfw_NewFrame();
+	// the backend fills these from the clock and the window; pin them so every run is identical
+	ImGuiIO& io = ImGui::GetIO();
+	io.DeltaTime = kDeltaTime;
+	io.DisplaySize = ImVec2((float)options_.width, (float)options_.height);
+	io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
+	ImGui::NewFrame();
+
+	offscreen_.bind();
+	glViewport(0, 0, options_.width, options_.height);
+	glClearColor(0.45f, 0.55f, 0.60f, 1.00f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	scenario.frame(counters);
+
+	ImGui::Render();
+	ImDrawData* draw_data = ImGui::GetDrawData();
+	if (indirect_)
+	{
+		renderer_.render(draw_data);
+		counters.draw_calls += renderer_.lastFrame().draw_calls;
+		counters.upload_bytes += renderer_.lastFrame().bytes_uploaded;
+	}
+	else
+	{
+		ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+		for (int i = 0; i < draw_data->CmdListsCount; i++)
+			counters.draw_calls += draw_data->CmdLists[i]->CmdBuffer.Size;
+		counters.upload_bytes += (uint64_t)draw_data->TotalVtxCount * sizeof(ImDrawVert) + (uint64_t)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+	}
+	counters.vertices += draw_data->TotalVtxCount;
+
+	glfwSwapBuffers(window_);
+	profiler_.endFrame();
+}
+
+bool FrameBench::run(const BenchScenario& scenario, int frames, int warmup, BenchResult& result)
+{
+	// a fresh context per scenario, so windows and tables of the previous one are not carried along
+	ImGui::CreateContext();
+	ImGui::GetIO().IniFilename = nullptr;
+	ImGui::StyleColorsDark();
+	// no callbacks: the hidden window gets no input anyway, and nothing may leak into the frames
+	ImGui_ImplGlfw_InitForOpenGL(window_, false);
+	ImGui_ImplOpenGL3_Init("#version 330");
+	auto destroy_context = []() {
+		ImGui_ImplOpenGL3_Shutdown();
+		ImGui_ImplGlfw_Shutdown();
+		ImGui::DestroyContext();
+	};
+
+	if (scenario.setup && !scenario.setup())
+	{
+		std::cerr << "Scenario " << scenario.name << " failed to set up\n";
+		destroy_context();
+		return false;
+	}
+
+	FrameTimeStats times;
+	times.reserve(frames);
+	double draw_calls = 0.0, vertices = 0.0, upload_bytes = 0.0, heap_allocations = 0.0, pool_allocations = 0.0;
+	for (int i = 0; i < warmup + frames; i++)
+	{
+		BenchFrame counters;
+		counters.index = (uint64_t)i;
+		frame(scenario, counters);
+		if (i < warmup)
+			continue;
+		const FrameStats& stats = profiler_.lastFrame();
+		times.add(stats.cpu_ms);
+		draw_calls += (double)counters.draw_calls;
+		vertices += (double)counters.vertices;
+		upload_bytes += (double)counters.upload_bytes;
+		heap_allocations += (double)stats.heap_allocations;
+		pool_allocations += (double)stats.pool_allocations;
+	}
+	glFinish();
+
+	if (scenario.teardown)
+		scenario.teardown();
+	destroy_context();
+
+	result = BenchResult();
+	result.scenario = scenario.name;
+	result.frames = times.frames();
+	result.cpu_mean_ms = times.mean();
+	result.cpu_p50_ms = times.percentile(0.50);
+	result.cpu_p95_ms = times.percentile(0.95);
+	result.cpu_p99_ms = times.percentile(0.99);
+	result.cpu_max_ms = times.percentile(1.0);
+	if (frames > 0)
+	{
+		result.draw_calls = draw_calls / frames;
+		result.vertices = vertices / frames;
+		result.upload_kb = upload_bytes / 1024.0 / frames;
+		result.heap_allocations = heap_allocations / frames;
+		result.pool_allocations = pool_allocations / frames;
+	}
+	return true;
+}
+
+bool writeBenchCsv(const std::string& filename, const std::vector<BenchResult>& results)
+{
+	std::ofstream file(filename, std::ios::trunc);
+	if (!file)
+	{
+		std::cerr << "Failed to write " << filename << "\n";
+		return false;
+	}
+	file << "scenario,frames";
+	for (const Metric& metric : kMetrics)
+		file << "," << metric.name;
+	file << "\n";
+	for (const BenchResult& result : results)
+	{
+		file << result.scenario << "," << result.frames;
+		for (const Metric& metric : kMetrics)
+			file << "," << result.*metric.value;
+		file << "\n";
+	}
+	return (bool)file;
+}
+
+bool writeBenchJson(const std::string& filename, const std::vector<BenchResult>& results)
+{
+	std::ofstream file(filename, std::ios::trunc);
+	if (!file)
+	{
+		std::cerr << "Failed to write " << filename << "\n";
+		return false;
+	}
+	file << "[\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		file << "  { \"scenario\": \"" << results[i].scenario << "\", \"frames\": " << results[i].frames;
+		for (const Metric& metric : kMetrics)
+			file << ", \"" << metric.name << "\": " << results[i].*metric.value;
+		file << (i + 1 < results.size() ? " },\n" : " }\n");
+	}
+	file << "]\n";
+	return (bool)file;
+}
+
+bool readBenchCsv(const std::string& filename, std::vector<BenchResult>& results)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cerr << "Failed to read " << filename << "\n";
+		return false;
+	}
+	results.clear();
+
+	// columns are matched by name, so baselines written before a metric was added still load
+	std::string line, cell;
+	std::vector<std::string> columns;
+	size_t line_number = 1;
+	if (std::getline(file, line))
+	{
+		std::stringstream header(line);
+		while (std::getline(header, cell, ','))
+			columns.push_back(cell);
+	}
+	while (std::getline(file, line))
+	{
+		line_number++;
+		if (line.empty())
+			continue;
+		BenchResult result;
+		std::stringstream row(line);
+		for (size_t column = 0; std::getline(row, cell, ',') && column < columns.size(); column++)
+		{
+			if (columns[column] == "scenario")
+			{
+				result.scenario = cell;
+				continue;
+			}
+			bool known = columns[column] == "frames";
+			for (const Metric& metric : kMetrics)
+				known |= columns[column] == metric.name;
+			if (!known)
+				continue;
+			double value = 0.0;
+			if (!parseNumber(cell, value) || (columns[column] == "frames" && value < 0.0))
+			{
+				std::cerr << filename << ":" << line_number << ": bad " << columns[column] << " value '" << cell << "'\n";
+				results.clear();
+				return false;
+			}
+			if (columns[column] == "frames")
+				result.frames = (size_t)value;
+			for (const Metric& metric : kMetrics)
+				if (columns[column] == metric.name)
+					result.*metric.value = value;
+		}
+		results.push_back(result);
+	}
+	return true;
+}
+
+void printBenchResults(FILE* out, const std::vector<BenchResult>& results)
+{
+	fprintf(out, "%-16s %7s %9s %9s %9s %9s %9s %10s %10s %10s %10s\n", "scenario", "frames", "mean ms", "p50 ms", "p95 ms", "p99 ms", "draws", "vertices", "upload KB", "heap alloc", "pool alloc");
+	for (const BenchResult& r : results)
+		fprintf(out, "%-16s %7zu %9.3f %9.3f %9.3f %9.3f %9.1f %10.0f %10.1f %10.1f %10.1f\n", r.scenario.c_str(), r.frames, r.cpu_mean_ms, r.cpu_p50_ms, r.cpu_p95_ms, r.cpu_p99_ms, r.draw_calls, r.vertices, r.upload_kb, r.heap_allocations, r.pool_allocations);
+}
+
+bool compareBenchResults(FILE* out, const std::vector<BenchResult>& results, const std::vector<BenchResult>& baseline, double threshold_percent)
+{
+	bool passed = true;
+	for (const BenchResult& result : results)
+	{
+		const BenchResult* base = nullptr;
+		for (const BenchResult& candidate : baseline)
+			if (candidate.scenario == result.scenario)
+				base = &candidate;
+		if (!base)
+		{
+			fprintf(out, "%s: not in baseline\n", result.scenario.c_str());
+			continue;
+		}
+		for (const Metric& metric : kMetrics)
+		{
+			if (!metric.compared)
+				continue;
+			double value = result.*metric.value, reference = base->*metric.value;
+			if (value > reference * (1.0 + threshold_percent / 100.0) && value - reference > metric.min_delta)
+			{
+				double change = reference > 0.0 ? (value / reference - 1.0) * 100.0 : 100.0;
+				fprintf(out, "REGRESSION %s %s: %.3f -> %.3f (+%.1f%%)\n", result.scenario.c_str(), metric.name, reference, value, change);
+				passed = false;
+			}
+		}
+	}
+	return passed;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "headless.h"
+#include "frame_profiler.h"
+#include "imgui_indirect_renderer.h"
+#include "size_class_pool.h"
+
+struct GLFWwindow;
+
+// What a scenario drew outside of ImGui in one frame, e.g. its own instanced scene
+struct BenchFrame
+{
+	uint64_t index = 0;
+	uint64_t draw_calls = 0;
+	uint64_t vertices = 0;
+	uint64_t upload_bytes = 0;  // ImGui vertex and index bytes sent to the GPU
+};
+
+// A deterministic workload. frame() is called between ImGui::NewFrame() and ImGui::Render()
+// with the offscreen target bound and cleared, so it can both build UI and draw with GL.
+struct BenchScenario
+{
+	std::string name;
+	std::function<bool()> setup;
+	std::function<void(BenchFrame&)> frame;
+	std::function<void()> teardown;
+};
+
+// Per-frame averages over the measured frames, CPU times in milliseconds
+struct BenchResult
+{
+	std::string scenario;
+	size_t frames = 0;
+	double cpu_mean_ms = 0.0;
+	double cpu_p50_ms = 0.0;
+	double cpu_p95_ms = 0.0;
+	double cpu_p99_ms = 0.0;
+	double cpu_max_ms = 0.0;
+	double draw_calls = 0.0;
+	double vertices = 0.0;
+	double upload_kb = 0.0;
+	double heap_allocations = 0.0;
+	double pool_allocations = 0.0;
+};
+
+// Owns a hidden window and an offscreen target, and runs each scenario in a fresh ImGui context
+// with a fixed io.DeltaTime, fixed display size and no input, so every run builds the same UI.
+class FrameBench
+{
+public:
+	bool init(const HeadlessOptions& options);
+	void shutdown();
+
+	// warmup frames run first and are not measured; they cover first-use allocations and GL object creation
+	bool run(const BenchScenario& scenario, int frames, int warmup, BenchResult& result);
+	// false draws ImGui with the backend's per-command loop, to compare against multi-draw-indirect
+	void setIndirectRendering(bool enabled) { indirect_ = enabled; }
+
+	GLFWwindow* window() const { return window_; }
+	int width() const { return options_.width; }
+	int height() const { return options_.height; }
+
+	static constexpr float kDeltaTime = 1.0f / 60.0f;
+
+private:
+	void frame(const BenchScenario& scenario, BenchFrame& counters);
+
+	HeadlessOptions options_;
+	GLFWwindow* window_ = nullptr;
+	OffscreenTarget offscreen_;
+	SizeClassPool imgui_pool_;
+	FrameProfiler profiler_;
+	ImGuiIndirectRenderer renderer_;
+	bool indirect_ = true;
+};
+
+bool writeBenchCsv(const std::string& filename, const std::vector<BenchResult>& results);
+bool writeBenchJson(const std::string& filename, const std::vector<BenchResult>& results);
+// Reads a file written by writeBenchCsv
+bool readBenchCsv(const std::string& filename, std::vector<BenchResult>& results);
+
+void printBenchResults(FILE* out, const std::vector<BenchResult>& results);
+// Prints every metric that got worse than its baseline by more than threshold_percent;
+// returns false when there is at least one. Scenarios missing on either side are skipped.
+bool compareBenchResults(FILE* out, const std::vector<BenchResult>& results, const std::vector<BenchResult>& baseline, double threshold_percent);
@@ -0,0 +1,860 @@
+#include "frame_capture.h"
+#include "memory_telemetry.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "imgui.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+namespace
+{
+	// read-back frames waiting for an encoder; past this new ones are dropped
+	const size_t kMaxQueuedBytes = 256 << 20;
+	const size_t kSpareBuffers = 4;
+
+	// Palette: a 6x7x6 color cube (green gets the extra level) in 0..251, 255 is transparent
+	const int kRedLevels = 6, kGreenLevels = 7, kBlueLevels = 6;
+	const uint8_t kTransparent = 255;
+
+	// Animated GIF with a fixed palette. Ordered dithering keeps unchanged pixels unchanged from
+	// frame to frame, so each frame only stores the rectangle that changed, with the pixels that
+	// didn't made transparent. Frame delays are in 1/100 s and at least 2, which is what browsers
+	// honor, so at 60 FPS some frames are merged into their successor.
+	class GifWriter
+	{
+	public:
+		~GifWriter() { close(0.0); }
+
+		bool open(const std::string& path);
+		// rgb is width * height * 3 bytes, top row first; seconds since the first frame
+		bool addFrame(const uint8_t* rgb, int width, int height, double seconds);
+		// seconds: when the last frame ends
+		bool close(double seconds);
+		bool isOpen() const { return file_ != nullptr; }
+		uint64_t bytes() const { return bytes_; }
+
+	private:
+		void quantize(const uint8_t* rgb, std::vector<uint8_t>& indices) const;
+		bool writeFrame(int delay);
+		void compress(const uint8_t* indices, size_t count);
+		bool write(const void* data, size_t size);
+
+		FILE* file_ = nullptr;
+		bool failed_ = false;
+		int width_ = 0, height_ = 0;
+		std::vector<uint8_t> previous_;  // canvas after the frames written so far
+		std::vector<uint8_t> pending_;   // frame waiting for its delay
+		std::vector<uint8_t> indices_;
+		std::vector<uint8_t> pixels_;
+		std::vector<uint8_t> out_;
+		std::vector<int32_t> table_;
+		uint8_t levels6_[16][256], levels7_[16][256];  // dithered level by threshold and value
+		bool has_previous_ = false, has_pending_ = false;
+		int written_cs_ = 0;  // where pending_ starts
+		uint64_t frames_ = 0;
+		uint64_t bytes_ = 0;
+	};
+
+	const uint8_t kBayer[16] = { 0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5 };
+
+	bool GifWriter::open(const std::string& path)
+	{
+		file_ = fopen(path.c_str(), "wb");
+		if (!file_)
+		{
+			std::cerr << "Failed to open " << path << " for writing" << std::endl;
+			return false;
+		}
+		// level = floor(v * (levels - 1) / 255 + (threshold + 0.5) / 16)
+		for (int threshold = 0; threshold < 16; threshold++)
+			for (int v = 0; v < 256; v++)
+			{
+				levels6_[threshold][v] = (uint8_t)std::min((32 * v * 5 + (2 * threshold + 1) * 255) / (32 * 255), 5);
+				levels7_[threshold][v] = (uint8_t)std::min((32 * v * 6 + (2 * threshold + 1) * 255) / (32 * 255), 6);
+			}
+		return true;
+	}
+
+	bool GifWriter::write(const void* data, size_t size)
+	{
+		if (!failed_ && fwrite(data, 1, size, file_) != size)
+		{
+			std::cerr << "Failed to write the GIF" << std::endl;
+			failed_ = true;
+		}
+		bytes_ += size;
+		return !failed_;
+	}
+
+	void GifWriter::quantize(const uint8_t* rgb, std::vector<uint8_t>& indices) const
+	{
+		static_assert(kRedLevels == 6 && kGreenLevels == 7 && kBlueLevels == 6, "levels6_ and levels7_ are per channel");
+		indices.resize((size_t)width_ * height_);
+		for (int y = 0; y < height_; y++)
+		{
+			const uint8_t* row = rgb + (size_t)y * width_ * 3;
+			uint8_t* out = indices.data() + (size_t)y * width_;
+			for (int x = 0; x < width_; x++)
+			{
+				int threshold = kBayer[(y & 3) * 4 + (x & 3)];
+				int r = levels6_[threshold][row[x * 3 + 0]];
+				int g = levels7_[threshold][row[x * 3 + 1]];
+				int b = levels6_[threshold][row[x * 3 + 2]];
+				out[x] = (uint8_t)((r * kGreenLevels + g) * kBlueLevels + b);
+			}
+		}
+	}
+
+	bool GifWriter::addFrame(const uint8_t* rgb, int width, int height, double seconds)
+	{
+		if (!file_ || failed_)
+			return false;
+		if (frames_++ == 0)
+		{
+			width_ = width;
+			height_ = height;
+			uint8_t header[13] = { 'G', 'I', 'F', '8', '9', 'a', (uint8_t)width, (uint8_t)(width >> 8), (uint8_t)height, (uint8_t)(height >> 8),
+				0xF7, 0, 0 };  // 256-entry global color table
+			uint8_t palette[256 * 3] = {};
+			for (int r = 0; r < kRedLevels; r++)
+				for (int g = 0; g < kGreenLevels; g++)
+					for (int b = 0; b < kBlueLevels; b++)
+					{
+						uint8_t* color = palette + ((r * kGreenLevels + g) * kBlueLevels + b) * 3;
+						color[0] = (uint8_t)(r * 255 / (kRedLevels - 1));
+						color[1] = (uint8_t)(g * 255 / (kGreenLevels - 1));
+						color[2] = (uint8_t)(b * 255 / (kBlueLevels - 1));
+					}
+			const uint8_t loop[19] = { 0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 0x03, 0x01, 0x00, 0x00, 0x00 };
+			write(header, sizeof(header));
+			write(palette, sizeof(palette));
+			write(loop, sizeof(loop));
+		}
+		if (width != width_ || height != height_)
+			return false;
+
+		quantize(rgb, indices_);
+		int cs = (int)(seconds * 100.0 + 0.5);
+		if (!has_pending_)
+		{
+			pending_.swap(indices_);
+			has_pending_ = true;
+			written_cs_ = cs;
+			return !failed_;
+		}
+		if (indices_ == pending_)
+			return !failed_;
+		int delay = cs - written_cs_;
+		if (delay >= 2)
+		{
+			writeFrame(delay);
+			written_cs_ += delay;
+		}
+		// otherwise the pending frame is replaced and its time goes to this one
+		pending_.swap(indices_);
+		return !failed_;
+	}
+
+	bool GifWriter::close(double seconds)
+	{
+		if (!file_)
+			return false;
+		if (has_pending_)
+		{
+			writeFrame(std::max((int)(seconds * 100.0 + 0.5) - written_cs_, 2));
+			has_pending_ = false;
+		}
+		const uint8_t trailer = 0x3B;
+		write(&trailer, 1);
+		bool ok = !failed_ && fclose(file_) == 0;
+		if (failed_)
+			fclose(file_);
+		file_ = nullptr;
+		return ok;
+	}
+
+	bool GifWriter::writeFrame(int delay)
+	{
+		// the rectangle that differs from the canvas so far
+		int x0 = 0, y0 = 0, x1 = width_, y1 = height_;
+		if (has_previous_)
+		{
+			x0 = width_, y0 = height_, x1 = 0, y1 = 0;
+			for (int y = 0; y < height_; y++)
+			{
+				const uint8_t* a = pending_.data() + (size_t)y * width_;
+				const uint8_t* b = previous_.data() + (size_t)y * width_;
+				if (memcmp(a, b, width_) == 0)
+					continue;
+				int first = 0, last = width_ - 1;
+				while (a[first] == b[first])
+					first++;
+				while (a[last] == b[last])
+					last--;
+				x0 = std::min(x0, first);
+				x1 = std::max(x1, last + 1);
+				y0 = std::min(y0, y);
+				y1 = y + 1;
+			}
+			if (x0 >= x1)
+				x0 = 0, y0 = 0, x1 = 1, y1 = 1;  // nothing changed; a transparent pixel carries the delay
+		}
+		int w = x1 - x0, h = y1 - y0;
+		pixels_.resize((size_t)w * h);
+		for (int y = 0; y < h; y++)
+		{
+			const uint8_t* source = pending_.data() + (size_t)(y0 + y) * width_ + x0;
+			uint8_t* target = pixels_.data() + (size_t)y * w;
+			if (!has_previous_)
+			{
+				memcpy(target, source, w);
+				continue;
+			}
+			uint8_t* canvas = previous_.data() + (size_t)(y0 + y) * width_ + x0;
+			for (int x = 0; x < w; x++)
+			{
+				target[x] = source[x] == canvas[x] ? kTransparent : source[x];
+				canvas[x] = source[x];
+			}
+		}
+		if (!has_previous_)
+		{
+			previous_ = pending_;
+			has_previous_ = true;
+		}
+
+		// graphic control extension: leave the frame in place for the next, index 255 is transparent
+		uint8_t control[8] = { 0x21, 0xF9, 0x04, 1 << 2 | 1, (uint8_t)delay, (uint8_t)(delay >> 8), kTransparent, 0 };
+		uint8_t descriptor[10] = { 0x2C, (uint8_t)x0, (uint8_t)(x0 >> 8), (uint8_t)y0, (uint8_t)(y0 >> 8), (uint8_t)w, (uint8_t)(w >> 8), (uint8_t)h, (uint8_t)(h >> 8), 0 };
+		write(control, sizeof(control));
+		write(descriptor, sizeof(descriptor));
+		compress(pixels_.data(), pixels_.size());
+		return write(out_.data(), out_.size());
+	}
+
+	// LZW with 8-bit minimum code size, packed into 255-byte sub-blocks
+	void GifWriter::compress(const uint8_t* indices, size_t count)
+	{
+		const int kClear = 256, kEnd = 257, kMaxCode = 4096;
+		const size_t kTableSize = 1 << 13;  // open addressing, at most half full
+		table_.assign(kTableSize * 2, -1);  // (prefix << 8 | byte, code) pairs
+		out_.clear();
+		out_.push_back(8);
+		size_t block = out_.size();
+		out_.push_back(0);
+		uint32_t bits = 0;
+		int bit_count = 0;
+		int code_size = 9;
+		int next_code = kEnd + 1;
+
+		auto put = [&](uint8_t byte) {
+			if (out_.size() - block == 256)
+			{
+				out_[block] = 255;
+				block = out_.size();
+				out_.push_back(0);
+			}
+			out_.push_back(byte);
+		};
+		auto emit = [&](int code) {
+			bits |= (uint32_t)code << bit_count;
+			bit_count += code_size;
+			for (; bit_count >= 8; bit_count -= 8, bits >>= 8)
+				put((uint8_t)bits);
+		};
+		auto slot = [&](int32_t key) {
+			size_t at = ((uint32_t)key * 2654435761u) >> 19 & (kTableSize - 1);
+			while (table_[at * 2] != -1 && table_[at * 2] != key)
+				at = (at + 1) & (kTableSize - 1);
+			return at;
+		};
+
+		emit(kClear);
+		int prefix = indices[0];
+		for (size_t i = 1; i < count; i++)
+		{
+			int32_t key = prefix << 8 | indices[i];
+			size_t at = slot(key);
+			if (table_[at * 2] == key)
+			{
+				prefix = table_[at * 2 + 1];
+				continue;
+			}
+			emit(prefix);
+			if (next_code < kMaxCode)
+			{
+				table_[at * 2] = key;
+				table_[at * 2 + 1] = next_code++;
+				// the decoder adds its entries one code behind, so widens after reading this one
+				if (next_code - 1 >= (1 << code_size) && code_size < 12)
+					code_size++;
+			}
+			else
+			{
+				emit(kClear);
+				std::fill(table_.begin(), table_.end(), -1);
+				code_size = 9;
+				next_code = kEnd + 1;
+			}
+			prefix = indices[i];
+		}
+		emit(prefix);
+		if (next_code >= (1 << code_size) && code_size < 12)
+			code_size++;
+		emit(kEnd);
+		if (bit_count > 0)
+			put((uint8_t)bits);
+		if (out_.size() - block == 1)
+			out_.pop_back();  // empty last block
+		else
+			out_[block] = (uint8_t)(out_.size() - block - 1);
+		out_.push_back(0);
+	}
+
+	struct FileWriter
+	{
+		FILE* file;
+		uint64_t bytes = 0;
+		bool failed = false;
+	};
+
+	void writeToFile(void* context, void* data, int size)
+	{
+		FileWriter* writer = (FileWriter*)context;
+		writer->failed = writer->failed || fwrite(data, 1, size, writer->file) != (size_t)size;
+		writer->bytes += size;
+	}
+}
+
+struct FrameCapture::Session
+{
+	struct Frame
+	{
+		uint64_t number = 0;
+		Clock::time_point time;
+		int width = 0, height = 0;
+		std::vector<uint8_t> pixels;  // RGBA, bottom row first as glReadPixels leaves them
+	};
+
+	CaptureOptions options;
+	Clock::time_point started, stopped;  // FrameCapture::mutex_
+	std::atomic<bool> stopping{ false };
+	std::atomic<bool> finished{ false };
+	std::atomic<uint64_t> captured{ 0 };
+	std::atomic<uint64_t> written{ 0 };
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<uint64_t> bytes_written{ 0 };
+	std::atomic<uint64_t> encode_us{ 0 };
+	uint64_t frames_seen = 0;  // GL thread
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<Frame> queue;
+	size_t queued_bytes = 0;
+	std::vector<std::vector<uint8_t>> spare;
+	bool closed = false;
+	int running = 0;
+	std::string error;
+	std::vector<std::thread> encoders;
+
+	// the encoder thread writing GIFs is the only one
+	GifWriter gif;
+	int gif_width = 0, gif_height = 0;
+	Clock::time_point first_time, last_time;
+
+	// GL thread: room for a frame of bytes in the queue and a buffer for it
+	bool acquire(size_t bytes, std::vector<uint8_t>& pixels);
+	void push(Frame&& frame);
+	void release(size_t bytes, std::vector<uint8_t>&& pixels);
+	// no more frames; the encoders finish the queue and exit
+	void close();
+	void fail(const std::string& message);
+
+	void encoderLoop();
+	bool encode(const Frame& frame, std::vector<uint8_t>& rgb);
+};
+
+bool FrameCapture::Session::acquire(size_t bytes, std::vector<uint8_t>& pixels)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (closed || (queued_bytes > 0 && queued_bytes + bytes > kMaxQueuedBytes))
+			return false;
+		queued_bytes += bytes;
+		if (!spare.empty())
+		{
+			pixels = std::move(spare.back());
+			spare.pop_back();
+		}
+	}
+	pixels.resize(bytes);
+	return true;
+}
+
+void FrameCapture::Session::push(Frame&& frame)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	queue.push_back(std::move(frame));
+	wake.notify_one();
+}
+
+void FrameCapture::Session::release(size_t bytes, std::vector<uint8_t>&& pixels)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	queued_bytes -= bytes;
+	if (spare.size() < kSpareBuffers)
+		spare.push_back(std::move(pixels));
+}
+
+void FrameCapture::Session::close()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	closed = true;
+	wake.notify_all();
+}
+
+void FrameCapture::Session::fail(const std::string& message)
+{
+	std::cerr << message << std::endl;
+	std::lock_guard<std::mutex> lock(mutex);
+	if (error.empty())
+		error = message;
+}
+
+void FrameCapture::Session::encoderLoop()
+{
+	std::vector<uint8_t> rgb;
+	for (;;)
+	{
+		Frame frame;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this]() { return !queue.empty() || closed; });
+			if (queue.empty())
+				break;
+			frame = std::move(queue.front());
+			queue.pop_front();
+		}
+		auto start = Clock::now();
+		if (encode(frame, rgb))
+			written++;
+		encode_us += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+		size_t bytes = frame.pixels.size();
+		release(bytes, std::move(frame.pixels));
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (--running > 0)
+		return;
+	if (gif.isOpen())
+	{
+		double seconds = std::chrono::duration<double>(last_time - first_time).count();
+		uint64_t frames = std::max<uint64_t>(written.load(), 1);
+		if (!gif.close(seconds + (frames > 1 ? seconds / (frames - 1) : 0.0)) && error.empty())
+			error = "Failed to write " + options.path;
+		bytes_written = gif.bytes();
+	}
+	finished = true;
+}
+
+// Flips the frame upright, averages downscale x downscale blocks and drops alpha. A GIF keeps the
+// size of its first frame: later frames of another size are cropped or padded with black.
+bool FrameCapture::Session::encode(const Frame& frame, std::vector<uint8_t>& rgb)
+{
+	int scale = options.downscale;
+	bool is_gif = options.format == CaptureFormat::Gif;
+	if (is_gif && gif_width == 0)
+	{
+		gif_width = std::max(frame.width / scale, 1);
+		gif_height = std::max(frame.height / scale, 1);
+		first_time = frame.time;
+	}
+	int width = is_gif ? gif_width : std::max(frame.width / scale, 1);
+	int height = is_gif ? gif_height : std::max(frame.height / scale, 1);
+	rgb.assign((size_t)width * height * 3, 0);
+	for (int y = 0; y < height; y++)
+	{
+		uint8_t* out = rgb.data() + (size_t)y * width * 3;
+		if (scale == 1)
+		{
+			if (y >= frame.height)
+				break;
+			const uint8_t* in = frame.pixels.data() + (size_t)(frame.height - 1 - y) * frame.width * 4;
+			for (int x = 0, w = std::min(width, frame.width); x < w; x++)
+				memcpy(out + x * 3, in + x * 4, 3);
+			continue;
+		}
+		for (int x = 0; x < width; x++)
+		{
+			int sum[3] = {}, count = 0;
+			for (int sy = y * scale; sy < std::min((y + 1) * scale, frame.height); sy++)
+			{
+				const uint8_t* in = frame.pixels.data() + (size_t)(frame.height - 1 - sy) * frame.width * 4;
+				for (int sx = x * scale; sx < std::min((x + 1) * scale, frame.width); sx++, count++)
+					for (int c = 0; c < 3; c++)
+						sum[c] += in[sx * 4 + c];
+			}
+			for (int c = 0; c < 3 && count > 0; c++)
+				out[x * 3 + c] = (uint8_t)((sum[c] + count / 2) / count);
+		}
+	}
+
+	if (is_gif)
+	{
+		last_time = frame.time;
+		double seconds = std::chrono::duration<double>(frame.time - first_time).count();
+		if (!gif.addFrame(rgb.data(), width, height, seconds))
+		{
+			fail("Failed to write " + options.path);
+			return false;
+		}
+		bytes_written = gif.bytes();
+		return true;
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "frame_%06llu.png", (unsigned long long)frame.number);
+	std::string filename = (std::filesystem::path(options.path) / name).string();
+	FileWriter writer{ fopen(filename.c_str(), "wb") };
+	if (!writer.file)
+	{
+		fail("Failed to open " + filename + " for writing");
+		return false;
+	}
+	int ok = stbi_write_png_to_func(&writeToFile, &writer, width, height, 3, rgb.data(), width * 3);
+	writer.failed = fclose(writer.file) != 0 || writer.failed;
+	bytes_written += writer.bytes;
+	if (!ok || writer.failed)
+	{
+		fail("Failed to write " + filename);
+		return false;
+	}
+	return true;
+}
+
+FrameCapture::FrameCapture()
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+	std::shared_ptr<Session> session;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		session = session_;
+	}
+	if (!session)
+		return;
+	stop();
+	session->close();
+	for (std::thread& encoder : session->encoders)
+		encoder.join();
+}
+
+bool FrameCapture::start(const CaptureOptions& options)
+{
+	std::shared_ptr<Session> previous;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		previous = session_;
+	}
+	if (previous && !previous->finished)
+	{
+		std::cerr << (previous->stopping ? "Still writing the previous capture" : "Already capturing") << std::endl;
+		return false;
+	}
+	if (previous)
+		for (std::thread& encoder : previous->encoders)
+			encoder.join();
+
+	auto session = std::make_shared<Session>();
+	session->options = options;
+	session->options.frame_step = std::max(options.frame_step, 1);
+	session->options.downscale = std::max(options.downscale, 1);
+	if (options.path.empty())
+	{
+		std::cerr << "No capture path" << std::endl;
+		return false;
+	}
+	if (options.format == CaptureFormat::PngSequence)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(options.path, error);
+		if (error)
+		{
+			std::cerr << "Failed to create " << options.path << ": " << error.message() << std::endl;
+			return false;
+		}
+	}
+	else if (!session->gif.open(options.path))
+		return false;
+
+	// frames of a GIF depend on the previous one; PNGs encode side by side
+	unsigned int encoders = options.format == CaptureFormat::Gif ? 1 : std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+	session->running = (int)encoders;
+	session->started = Clock::now();
+	for (unsigned int i = 0; i < encoders; i++)
+		session->encoders.emplace_back([session = session.get()]() { session->encoderLoop(); });
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	session_ = session;
+	return true;
+}
+
+void FrameCapture::stop()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (session_ && !session_->stopping)
+	{
+		session_->stopped = Clock::now();
+		session_->stopping = true;
+	}
+}
+
+bool FrameCapture::capturing() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return session_ && !session_->stopping;
+}
+
+CaptureStats FrameCapture::stats() const
+{
+	CaptureStats stats;
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!session_)
+		return stats;
+	Session& session = *session_;
+	stats.capturing = !session.stopping;
+	stats.writing = !session.finished;
+	stats.captured = session.captured;
+	stats.written = session.written;
+	stats.dropped = session.dropped;
+	stats.bytes_written = session.bytes_written;
+	stats.encode_ms = stats.written > 0 ? session.encode_us / 1000.0 / stats.written : 0.0;
+	stats.seconds = std::chrono::duration<double>((stats.capturing ? Clock::now() : session.stopped) - session.started).count();
+	std::lock_guard<std::mutex> session_lock(session.mutex);
+	stats.queued = session.queue.size();
+	stats.error = session.error;
+	return stats;
+}
+
+bool FrameCapture::initGL()
+{
+	gl_initialized_ = true;
+	if (!GLEW_VERSION_3_0)
+	{
+		std::cerr << "FrameCapture needs OpenGL 3.0 for pixel buffers" << std::endl;
+		gl_failed_ = true;
+		return false;
+	}
+	use_fences_ = GLEW_VERSION_3_2 || GLEW_ARB_sync;
+	for (Readback& readback : readbacks_)
+		glGenBuffers(1, &readback.buffer);
+	return true;
+}
+
+void FrameCapture::frame(int width, int height)
+{
+	std::shared_ptr<Session> session;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		session = session_;
+	}
+	if (!session || session->finished)
+		return;
+	if (!gl_initialized_)
+		initGL();
+	if (gl_failed_)
+	{
+		session->fail("Capturing needs OpenGL 3.0");
+		session->close();
+		return;
+	}
+
+	frames_++;
+	collect(false);
+	if (!session->stopping)
+	{
+		if (session->frames_seen++ % session->options.frame_step == 0 && width > 0 && height > 0)
+			read(*session, session, width, height);
+		return;
+	}
+	bool pending = false;
+	for (int i = 0; i < in_flight_; i++)
+		pending = pending || readbacks_[(oldest_ + i) % kReadbackBuffers].session == session;
+	if (!pending)
+		session->close();
+}
+
+void FrameCapture::read(Session& session, const std::shared_ptr<Session>& owner, int width, int height)
+{
+	if (in_flight_ == kReadbackBuffers)
+	{
+		session.dropped++;
+		return;
+	}
+	Readback& readback = readbacks_[(oldest_ + in_flight_) % kReadbackBuffers];
+	size_t bytes = (size_t)width * height * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	if (readback.capacity < bytes)
+	{
+		trackedBufferData(GL_PIXEL_PACK_BUFFER, readback.buffer, bytes, NULL, GL_STREAM_READ, "FrameCapture readback");
+		readback.capacity = bytes;
+	}
+	// into the buffer: returns once the copy is queued
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	if (use_fences_)
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.width = width;
+	readback.height = height;
+	readback.issued = frames_;
+	readback.time = Clock::now();
+	readback.session = owner;
+	in_flight_++;
+}
+
+// Hands finished readbacks to their encoders, oldest first. Without wait it stops at the first
+// one the GPU may still be writing: its fence hasn't signaled or, without fences, it was issued
+// less than kReadbackBuffers - 1 frames ago.
+void FrameCapture::collect(bool wait)
+{
+	while (in_flight_ > 0)
+	{
+		Readback& readback = readbacks_[oldest_];
+		if (readback.fence)
+		{
+			GLenum status = glClientWaitSync(readback.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 : 0);
+			if (status == GL_TIMEOUT_EXPIRED && !wait)
+				break;
+			glDeleteSync(readback.fence);
+			readback.fence = nullptr;
+		}
+		else if (!wait && frames_ - readback.issued < kReadbackBuffers - 1)
+			break;
+
+		Session& session = *readback.session;
+		size_t bytes = (size_t)readback.width * readback.height * 4;
+		Session::Frame frame;
+		if (!session.acquire(bytes, frame.pixels))
+			session.dropped++;
+		else
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+			const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+			if (mapped)
+			{
+				memcpy(frame.pixels.data(), mapped, bytes);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				frame.number = session.captured++;
+				frame.time = readback.time;
+				frame.width = readback.width;
+				frame.height = readback.height;
+				session.push(std::move(frame));
+			}
+			else
+			{
+				session.dropped++;
+				session.release(bytes, std::move(frame.pixels));
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+		readback.session.reset();
+		oldest_ = (oldest_ + 1) % kReadbackBuffers;
+		in_flight_--;
+	}
+}
+
+void FrameCapture::shutdown()
+{
+	stop();
+	std::shared_ptr<Session> session;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		session = session_;
+	}
+	if (gl_initialized_ && !gl_failed_)
+	{
+		collect(true);
+		for (Readback& readback : readbacks_)
+		{
+			trackedDeleteBuffers(1, &readback.buffer);
+			readback = Readback();
+		}
+	}
+	if (session)
+		session->close();
+	gl_initialized_ = false;
+	gl_failed_ = false;
+}
+
+void FrameCapture::draw(bool* open)
+{
+	if (!ImGui::Begin("Capture", open))
+	{
+		ImGui::End();
+		return;
+	}
+	CaptureStats stats = this->stats();
+	bool idle = !stats.capturing && !stats.writing;
+
+	ImGui::BeginDisabled(!idle);
+	int format = (int)options_.format;
+	if (ImGui::Combo("Format", &format, "GIF\0PNG sequence\0"))
+	{
+		options_.format = (CaptureFormat)format;
+		// swap the default names along
+		if (options_.format == CaptureFormat::PngSequence && strcmp(path_, "capture.gif") == 0)
+			snprintf(path_, sizeof(path_), "capture");
+		else if (options_.format == CaptureFormat::Gif && strcmp(path_, "capture") == 0)
+			snprintf(path_, sizeof(path_), "capture.gif");
+	}
+	ImGui::InputText(options_.format == CaptureFormat::Gif ? "File" : "Folder", path_, sizeof(path_));
+	ImGui::SliderInt("Every nth frame", &options_.frame_step, 1, 8);
+	ImGui::SliderInt("Downscale", &options_.downscale, 1, 4);
+	ImGui::EndDisabled();
+
+	if (stats.capturing)
+	{
+		if (ImGui::Button("Stop"))
+			stop();
+	}
+	else
+	{
+		ImGui::BeginDisabled(stats.writing);
+		if (ImGui::Button("Start"))
+		{
+			options_.path = path_;
+			start(options_);
+		}
+		ImGui::EndDisabled();
+	}
+	if (stats.capturing || stats.writing)
+	{
+		ImGui::SameLine();
+		if (stats.capturing)
+			ImGui::TextDisabled("recording %.1f s", stats.seconds);
+		else
+			ImGui::TextDisabled("writing, %zu frames left", stats.queued);
+	}
+
+	if (stats.captured + stats.dropped > 0)
+	{
+		ImGui::Text("%llu captured, %llu dropped, %zu queued", (unsigned long long)stats.captured, (unsigned long long)stats.dropped, stats.queued);
+		ImGui::Text("%llu written, %.1f MB, %.1f ms per frame to encode", (unsigned long long)stats.written, stats.bytes_written / (1024.0 * 1024.0), stats.encode_ms);
+	}
+	if (!stats.error.empty())
+		ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", stats.error.c_str());
+	ImGui::End();
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <GL/glew.h>
+
+enum class CaptureFormat
+{
+	Gif,          // one animated GIF, 6x7x6 color cube with ordered dithering
+	PngSequence   // frame_000000.png, frame_000001.png, ... in a folder
+};
+
+struct CaptureOptions
+{
+	CaptureFormat format = CaptureFormat::Gif;
+	std::string path;      // the .gif file, or the folder for the PNGs
+	int frame_step = 1;    // keep every frame_step-th frame
+	int downscale = 1;     // the output is the framebuffer size divided by this
+};
+
+struct CaptureStats
+{
+	bool capturing = false;  // between start() and stop()
+	bool writing = false;    // until the last captured frame is written
+	uint64_t captured = 0;   // read back from the GPU
+	uint64_t written = 0;
+	// frames skipped because every readback buffer was still in flight or the encoders were
+	// too far behind; the app's frame rate never pays for them
+	uint64_t dropped = 0;
+	size_t queued = 0;       // read back, waiting for an encoder
+	uint64_t bytes_written = 0;
+	double encode_ms = 0.0;  // mean per written frame, on the encoder threads
+	double seconds = 0.0;
+	std::string error;
+};
+
+// Records the framebuffer to image files without stalling frames. Each captured frame is read
+// into one of a ring of pixel pack buffers with an asynchronous glReadPixels and a fence, and
+// only mapped on a later frame once the fence says the copy is done, so neither the read nor
+// the map waits for the GPU. The pixels then go to encoder threads; a frame that finds no free
+// buffer or a full encoder queue is dropped and counted instead of holding up the app.
+//
+// start(), stop(), stats() and draw() are for the UI thread; frame() and shutdown() run on the
+// thread owning the GL context, as with App's threaded rendering.
+class FrameCapture
+{
+public:
+	FrameCapture();
+	// waits for the encoders to write what was captured
+	~FrameCapture();
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	// false after printing the problem, or while the previous capture is still being written
+	bool start(const CaptureOptions& options);
+	// frames already captured are still written
+	void stop();
+	bool capturing() const;
+	CaptureStats stats() const;
+
+	// GL thread, once a frame after drawing and before the swap: captures the bound read
+	// framebuffer, width x height from the bottom-left corner
+	void frame(int width, int height);
+	// GL thread, before the context goes away; finishes the readbacks in flight
+	void shutdown();
+
+	// Format, path and start/stop, with the numbers of the running capture
+	void draw(bool* open = nullptr);
+
+private:
+	using Clock = std::chrono::steady_clock;
+	struct Session;
+
+	static const int kReadbackBuffers = 3;
+
+	struct Readback
+	{
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+		size_t capacity = 0;
+		int width = 0, height = 0;
+		uint64_t issued = 0;  // frame() call, when fences aren't available
+		Clock::time_point time;
+		std::shared_ptr<Session> session;
+	};
+
+	// GL thread
+	bool initGL();
+	void collect(bool wait);
+	void read(Session& session, const std::shared_ptr<Session>& owner, int width, int height);
+
+	mutable std::mutex mutex_;
+	std::shared_ptr<Session> session_;  // current or last capture
+
+	// GL thread
+	bool gl_initialized_ = false;
+	bool gl_failed_ = false;
+	bool use_fences_ = false;
+	uint64_t frames_ = 0;
+	Readback readbacks_[kReadbackBuffers];
+	int oldest_ = 0;
+	int in_flight_ = 0;
+
+	// UI thread
+	CaptureOptions options_;
+	char path_[512] = "capture.gif";
+};
@@ -0,0 +1,271 @@
+#include "frame_pacer.h"
+#include "imgui.h"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+const char* pacingModeName(PacingMode mode)
+{
+	switch (mode)
+	{
+	case PacingMode::VSync: return "VSync";
+	case PacingMode::Adaptive: return "Adaptive VSync";
+	case PacingMode::FixedRate: return "Fixed rate";
+	case PacingMode::Uncapped: return "Uncapped";
+	}
+	return "?";
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	if (fine_timer_)
+		timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::setMode(PacingMode mode, double target_fps)
+{
+	mode_.store(mode, std::memory_order_relaxed);
+	target_fps_.store(std::max(1.0, target_fps), std::memory_order_relaxed);
+	dirty_.store(true, std::memory_order_release);
+}
+
+void FramePacer::applySwapInterval(PacingMode mode)
+{
+	int interval = 0;
+	if (mode == PacingMode::VSync)
+		interval = 1;
+	else if (mode == PacingMode::Adaptive)
+		interval = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear") ? -1 : 1;
+	glfwSwapInterval(interval);
+
+	if (const GLFWvidmode* video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor()))
+		refresh_ms_ = 1000.0 / std::max(1, video_mode->refreshRate);
+
+#ifdef _WIN32
+	// the default 15.6 ms scheduler tick would make every fixed-rate sleep overshoot; the 1 ms
+	// period is system-wide and costs power, so it is only held while in fixed-rate mode
+	if (mode == PacingMode::FixedRate && !fine_timer_)
+	{
+		fine_timer_ = timeBeginPeriod(1) == TIMERR_NOERROR;
+	}
+	else if (mode != PacingMode::FixedRate && fine_timer_)
+	{
+		timeEndPeriod(1);
+		fine_timer_ = false;
+	}
+#endif
+}
+
+double FramePacer::periodMs(PacingMode mode) const
+{
+	switch (mode)
+	{
+	case PacingMode::VSync:
+	case PacingMode::Adaptive: return refresh_ms_;
+	case PacingMode::FixedRate: return 1000.0 / targetFps();
+	case PacingMode::Uncapped: return 0.0;
+	}
+	return 0.0;
+}
+
+bool FramePacer::lowLatencyActive() const
+{
+	return lowLatency() && applied_mode_ != PacingMode::Uncapped;
+}
+
+double FramePacer::sleepUntil(Clock::time_point until)
+{
+	// Sleep through most of the wait, then spin the last stretch, which is about as long as
+	// the scheduler tends to oversleep, so the CPU only busy-waits for a fraction of a millisecond
+	Clock::time_point now = Clock::now();
+	double remaining_ms = std::chrono::duration<double, std::milli>(until - now).count();
+	if (remaining_ms > spin_margin_ms_)
+	{
+		auto wake = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(remaining_ms - spin_margin_ms_));
+		std::this_thread::sleep_until(wake);
+		double overshoot_ms = std::chrono::duration<double, std::milli>(Clock::now() - wake).count();
+		spin_margin_ms_ = std::clamp(spin_margin_ms_ * 0.9 + (overshoot_ms + 0.1) * 0.1, 0.1, 4.0);
+	}
+	Clock::time_point spin_start = Clock::now();
+	while (Clock::now() < until)
+		std::this_thread::yield();
+	return std::chrono::duration<double, std::milli>(Clock::now() - spin_start).count();
+}
+
+void FramePacer::waitForGpu()
+{
+	if (GLEW_VERSION_3_2 || GLEW_ARB_sync)
+	{
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		glDeleteSync(fence);
+	}
+	else
+	{
+		glFinish();
+	}
+}
+
+void FramePacer::waitForFrameStart()
+{
+	Clock::time_point now = Clock::now();
+	double delay_ms = 0.0;
+	if (lowLatencyActive() && have_last_present_)
+	{
+		// the next present is a refresh after the last one (or the next fixed-rate deadline);
+		// start late enough that the frame finishes just ahead of it
+		auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(periodMs(applied_mode_)));
+		Clock::time_point next_present = applied_mode_ == PacingMode::FixedRate ? deadline_ + period : last_present_ + period;
+		auto lead = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(predicted_cost_ms_ + safety_margin_ms_));
+		Clock::time_point start = next_present - lead;
+		if (start > now)
+		{
+			sleepUntil(start);
+			delay_ms = std::chrono::duration<double, std::milli>(Clock::now() - now).count();
+		}
+	}
+	frame_start_ = Clock::now();
+	frame_started_ = true;
+
+	std::lock_guard<std::mutex> lock(stats_mutex_);
+	stats_.start_delay_ms = delay_ms;
+}
+
+void FramePacer::beforeSwap()
+{
+	if (dirty_.exchange(false, std::memory_order_acquire))
+	{
+		applied_mode_ = mode();
+		applySwapInterval(applied_mode_);
+		deadline_ = Clock::now();
+		have_last_swap_ = false;
+		have_last_present_ = false;
+		resetStats();
+	}
+
+	if (lowLatencyActive() && frame_started_)
+	{
+		// CPU + GPU cost of this frame; the estimate rises at once and decays slowly, so one
+		// slow frame makes the next starts earlier instead of missing vblank again
+		waitForGpu();
+		double cost_ms = std::chrono::duration<double, std::milli>(Clock::now() - frame_start_).count();
+		predicted_cost_ms_ = std::max(cost_ms, predicted_cost_ms_ * 0.95 + cost_ms * 0.05);
+	}
+
+	if (applied_mode_ != PacingMode::FixedRate)
+		return;
+
+	auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(periodMs(applied_mode_)));
+	Clock::time_point now = Clock::now();
+	deadline_ += period;
+	// after a stall start over from now rather than releasing a burst of catch-up frames
+	if (deadline_ < now - period)
+		deadline_ = now;
+
+	double spin_ms = sleepUntil(deadline_);
+	std::lock_guard<std::mutex> lock(stats_mutex_);
+	stats_.spin_ms = stats_.spin_ms * 0.95 + spin_ms * 0.05;
+}
+
+void FramePacer::afterSwap()
+{
+	// throttle: with the swap itself finished, nothing is queued behind this frame
+	if (lowLatencyActive())
+		waitForGpu();
+
+	Clock::time_point now = Clock::now();
+	double latency_ms = frame_started_ ? std::chrono::duration<double, std::milli>(now - frame_start_).count() : 0.0;
+	frame_started_ = false;
+	last_present_ = now;
+	have_last_present_ = true;
+	if (!have_last_swap_)
+	{
+		last_swap_ = now;
+		have_last_swap_ = true;
+		return;
+	}
+	double interval_ms = std::chrono::duration<double, std::milli>(now - last_swap_).count();
+	last_swap_ = now;
+
+	double period_ms = periodMs(applied_mode_);
+	std::lock_guard<std::mutex> lock(stats_mutex_);
+	stats_.frames++;
+	stats_.period_ms = period_ms;
+	stats_.last_interval_ms = interval_ms;
+	stats_.mean_interval_ms += (interval_ms - stats_.mean_interval_ms) / stats_.frames;
+	stats_.worst_interval_ms = std::max(stats_.worst_interval_ms, interval_ms);
+	if (period_ms > 0.0 && interval_ms > period_ms * 1.5)
+		stats_.late_frames++;
+	stats_.input_latency_ms = latency_ms;
+	stats_.mean_input_latency_ms += (latency_ms - stats_.mean_input_latency_ms) / stats_.frames;
+	stats_.predicted_cost_ms = predicted_cost_ms_;
+}
+
+PacingStats FramePacer::stats() const
+{
+	std::lock_guard<std::mutex> lock(stats_mutex_);
+	return stats_;
+}
+
+void FramePacer::resetStats()
+{
+	std::lock_guard<std::mutex> lock(stats_mutex_);
+	stats_ = PacingStats();
+}
+
+void FramePacer::draw(bool* open)
+{
+	if (!ImGui::Begin("Frame Pacing", open, ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		ImGui::End();
+		return;
+	}
+	PacingMode current = mode();
+	float target = (float)targetFps();
+	bool changed = false;
+	if (ImGui::BeginCombo("Mode", pacingModeName(current)))
+	{
+		for (PacingMode candidate : { PacingMode::VSync, PacingMode::Adaptive, PacingMode::FixedRate, PacingMode::Uncapped })
+		{
+			if (ImGui::Selectable(pacingModeName(candidate), candidate == current))
+			{
+				current = candidate;
+				changed = true;
+			}
+		}
+		ImGui::EndCombo();
+	}
+	if (current == PacingMode::FixedRate)
+		changed |= ImGui::SliderFloat("Target FPS", &target, 10.0f, 360.0f, "%.0f");
+	if (changed)
+		setMode(current, target);
+	bool low_latency = lowLatency();
+	if (low_latency_available_.load(std::memory_order_relaxed) && ImGui::Checkbox("Low latency", &low_latency))
+		setLowLatency(low_latency);
+
+	PacingStats s = stats();
+	if (s.period_ms > 0.0)
+		ImGui::Text("Target period: %.2f ms", s.period_ms);
+	ImGui::Text("Interval: %.2f ms (mean %.2f, worst %.2f)", s.last_interval_ms, s.mean_interval_ms, s.worst_interval_ms);
+	ImGui::Text("Late frames: %llu of %llu (%.2f%%)", (unsigned long long)s.late_frames, (unsigned long long)s.frames, s.frames ? 100.0 * s.late_frames / s.frames : 0.0);
+	if (current == PacingMode::FixedRate)
+		ImGui::Text("Spin wait: %.3f ms/frame", s.spin_ms);
+	ImGui::Text("Input to present: %.2f ms (mean %.2f)", s.input_latency_ms, s.mean_input_latency_ms);
+	if (low_latency)
+		ImGui::Text("Frame cost: %.2f ms, start held back %.2f ms", s.predicted_cost_ms, s.start_delay_ms);
+	if (ImGui::Button("Reset"))
+		resetStats();
+	ImGui::End();
+}
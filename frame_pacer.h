@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+enum class PacingMode
+{
+	VSync,      // swap interval 1
+	Adaptive,   // swap interval -1: tears instead of waiting a whole refresh when a frame is late
+	FixedRate,  // swap interval 0, frames released at target_fps by a sleep + short spin
+	Uncapped    // swap interval 0, no waiting; for benchmarks
+};
+
+const char* pacingModeName(PacingMode mode);
+
+struct PacingStats
+{
+	uint64_t frames = 0;
+	// frames that took over 1.5 target periods, i.e. missed their vblank or deadline
+	uint64_t late_frames = 0;
+	double period_ms = 0.0;
+	double last_interval_ms = 0.0;
+	double mean_interval_ms = 0.0;
+	double worst_interval_ms = 0.0;
+	// how long the fixed-rate wait spun after sleeping, averaged
+	double spin_ms = 0.0;
+	// From the glfwPollEvents() that sampled the input to the frame being presented. Exact in
+	// low-latency mode, which waits for presentation; otherwise it ends when the swap returns.
+	double input_latency_ms = 0.0;
+	double mean_input_latency_ms = 0.0;
+	// low-latency mode: expected CPU+GPU cost of a frame and how long the last start was held back
+	double predicted_cost_ms = 0.0;
+	double start_delay_ms = 0.0;
+};
+
+// Decides how a frame waits for presentation. Mode changes can come from any thread; the swap
+// interval is applied by beforeSwap() on the thread that owns the GL context, which is what
+// glfwSwapInterval() needs.
+class FramePacer
+{
+public:
+	~FramePacer();
+
+	void setMode(PacingMode mode, double target_fps = 60.0);
+	PacingMode mode() const { return mode_.load(std::memory_order_relaxed); }
+	double targetFps() const { return target_fps_.load(std::memory_order_relaxed); }
+
+	// Low latency: instead of sampling input right after the previous swap and then waiting for
+	// vblank with a finished frame, sleep until the frame can just make the next vblank, and wait
+	// for each frame to be presented so the driver never queues another one behind it.
+	// Only for loops where the same thread polls input and owns the GL context; a threaded
+	// loop calls setLowLatencyAvailable(false), which turns it off and hides it in draw().
+	void setLowLatency(bool enabled) { low_latency_.store(enabled, std::memory_order_relaxed); }
+	bool lowLatency() const { return low_latency_.load(std::memory_order_relaxed) && low_latency_available_.load(std::memory_order_relaxed); }
+	void setLowLatencyAvailable(bool available) { low_latency_available_.store(available, std::memory_order_relaxed); }
+
+	// Call right before glfwPollEvents(); input latency is measured from here
+	void waitForFrameStart();
+	// Both run on the GL thread, around glfwSwapBuffers()
+	void beforeSwap();
+	void afterSwap();
+
+	PacingStats stats() const;
+	void resetStats();
+
+	// Mode selector and the late-frame numbers
+	void draw(bool* open = nullptr);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void applySwapInterval(PacingMode mode);
+	double periodMs(PacingMode mode) const;
+	bool lowLatencyActive() const;
+	// sleeps most of the way to until, spins the rest; returns the spin time
+	double sleepUntil(Clock::time_point until);
+	// waits for the GPU to finish everything submitted so far
+	void waitForGpu();
+
+	std::atomic<PacingMode> mode_{ PacingMode::VSync };
+	std::atomic<double> target_fps_{ 60.0 };
+	std::atomic<bool> dirty_{ true };
+	std::atomic<bool> low_latency_{ false };
+	std::atomic<bool> low_latency_available_{ true };
+
+	// GL thread only
+	PacingMode applied_mode_ = PacingMode::VSync;
+	double refresh_ms_ = 1000.0 / 60.0;
+	Clock::time_point deadline_;
+	Clock::time_point last_swap_;
+	bool have_last_swap_ = false;
+	// sleep overshoot, kept as a running estimate; the wait spins for this long at the end
+	double spin_margin_ms_ = 1.0;
+	Clock::time_point frame_start_;
+	bool frame_started_ = false;
+	Clock::time_point last_present_;
+	bool have_last_present_ = false;
+	double predicted_cost_ms_ = 0.0;
+	// kept between the frame's finish and the predicted vblank, for jitter
+	double safety_margin_ms_ = 1.0;
+	// Windows: a 1 ms timer period is held while in fixed-rate mode
+	bool fine_timer_ = false;
+
+	mutable std::mutex stats_mutex_;
+	PacingStats stats_;
+};
@@ -0,0 +1,165 @@
+#include "frame_profiler.h"
+#include "frame_arena.h"
+#include "frame_pacer.h"
+#include "size_class_pool.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> g_heap_allocations{ 0 };
+	std::atomic<uint64_t> g_heap_bytes{ 0 };
+}
+
+#if defined(FRAME_PROFILER_COUNT_HEAP)
+namespace
+{
+	void* countedAlloc(size_t size)
+	{
+		g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+		g_heap_bytes.fetch_add(size, std::memory_order_relaxed);
+		return malloc(size ? size : 1);
+	}
+
+	void* countedAlignedAlloc(size_t size, std::align_val_t alignment)
+	{
+		g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+		g_heap_bytes.fetch_add(size, std::memory_order_relaxed);
+#if defined(_MSC_VER)
+		return _aligned_malloc(size ? size : 1, (size_t)alignment);
+#else
+		void* pointer = nullptr;
+		size_t align = std::max((size_t)alignment, sizeof(void*));
+		return posix_memalign(&pointer, align, size ? size : 1) == 0 ? pointer : nullptr;
+#endif
+	}
+
+	void alignedFree(void* pointer)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(pointer);
+#else
+		free(pointer);
+#endif
+	}
+}
+
+// Global allocation counting: every new/delete in the process goes through here. Only built
+// with FRAME_PROFILER_COUNT_HEAP (always in dear-imgui-bench, opt-in elsewhere), since it
+// replaces the allocator for everything linked into the executable.
+void* operator new(size_t size)
+{
+	if (void* pointer = countedAlloc(size))
+		return pointer;
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size)
+{
+	if (void* pointer = countedAlloc(size))
+		return pointer;
+	throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	if (void* pointer = countedAlignedAlloc(size, alignment))
+		return pointer;
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	if (void* pointer = countedAlignedAlloc(size, alignment))
+		return pointer;
+	throw std::bad_alloc();
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return countedAlignedAlloc(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return countedAlignedAlloc(size, alignment); }
+
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete[](void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { alignedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { alignedFree(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { alignedFree(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { alignedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(pointer); }
+#endif
+
+uint64_t FrameProfiler::heapAllocations()
+{
+	return g_heap_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t FrameProfiler::heapBytes()
+{
+	return g_heap_bytes.load(std::memory_order_relaxed);
+}
+
+bool FrameProfiler::countsHeap()
+{
+#if defined(FRAME_PROFILER_COUNT_HEAP)
+	return true;
+#else
+	return false;
+#endif
+}
+
+void FrameProfiler::beginFrame()
+{
+	begin_time_ = std::chrono::steady_clock::now();
+	begin_.heap_allocations = heapAllocations();
+	begin_.heap_bytes = heapBytes();
+	begin_.pool_allocations = pool_ ? pool_->allocations() : 0;
+	begin_.pool_bytes = pool_ ? pool_->allocatedBytes() : 0;
+	begin_pool_system_ = pool_ ? pool_->systemAllocations() : 0;
+	begin_arena_system_ = arena_ ? arena_->systemAllocations() : 0;
+}
+
+void FrameProfiler::endFrame()
+{
+	last_.cpu_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin_time_).count();
+	last_.heap_allocations = heapAllocations() - begin_.heap_allocations;
+	last_.heap_bytes = heapBytes() - begin_.heap_bytes;
+	last_.pool_allocations = 0;
+	last_.pool_bytes = 0;
+	if (pool_)
+	{
+		// slabs the pool had to malloc are real heap traffic too
+		last_.heap_allocations += pool_->systemAllocations() - begin_pool_system_;
+		last_.pool_allocations = pool_->allocations() - begin_.pool_allocations;
+		last_.pool_bytes = pool_->allocatedBytes() - begin_.pool_bytes;
+	}
+	// and so are the blocks the arena grew by
+	if (arena_)
+		last_.heap_allocations += arena_->systemAllocations() - begin_arena_system_;
+	last_.arena_bytes = arena_ ? arena_->bytesUsed() : 0;
+	last_.input_latency_ms = pacer_ ? pacer_->stats().input_latency_ms : 0.0;
+}
+
+void FrameProfiler::draw(bool* open) const
+{
+	if (!ImGui::Begin("Frame Profiler", open, ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		ImGui::End();
+		return;
+	}
+	ImGui::Text("CPU frame: %.3f ms", last_.cpu_ms);
+	if (countsHeap())
+		ImGui::Text("Heap allocations/frame: %llu (%llu bytes)", (unsigned long long)last_.heap_allocations, (unsigned long long)last_.heap_bytes);
+	else
+		ImGui::TextDisabled("Heap allocations/frame: not counted (build with FRAME_PROFILER_COUNT_HEAP)");
+	ImGui::Text("ImGui pool allocations/frame: %llu (%llu bytes)", (unsigned long long)last_.pool_allocations, (unsigned long long)last_.pool_bytes);
+	ImGui::Text("Frame arena: %zu bytes", last_.arena_bytes);
+	if (pacer_)
+		ImGui::Text("Input to present: %.2f ms", last_.input_latency_ms);
+	ImGui::End();
+}
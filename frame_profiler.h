@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+class FrameArena;
+class FramePacer;
+class SizeClassPool;
+
+// Numbers for one frame. Heap counts come from the global operator new/delete
+// replacements in frame_profiler.cpp plus the pool's slab and the arena's block mallocs,
+// across all threads; without FRAME_PROFILER_COUNT_HEAP only those mallocs are counted.
+struct FrameStats
+{
+	double cpu_ms = 0.0;
+	uint64_t heap_allocations = 0;
+	uint64_t heap_bytes = 0;
+	uint64_t pool_allocations = 0;
+	uint64_t pool_bytes = 0;
+	size_t arena_bytes = 0;
+	// input sampling to present, as the pacer measured it for the last presented frame
+	double input_latency_ms = 0.0;
+};
+
+class FrameProfiler
+{
+public:
+	void setPool(const SizeClassPool* pool) { pool_ = pool; }
+	void setArena(const FrameArena* arena) { arena_ = arena; }
+	void setPacer(const FramePacer* pacer) { pacer_ = pacer; }
+
+	void beginFrame();
+	void endFrame();
+	const FrameStats& lastFrame() const { return last_; }
+
+	// Small ImGui window with the last frame's numbers
+	void draw(bool* open = nullptr) const;
+
+	static uint64_t heapAllocations();
+	static uint64_t heapBytes();
+	// Whether operator new is replaced, i.e. the build defines FRAME_PROFILER_COUNT_HEAP
+	static bool countsHeap();
+
+private:
+	const SizeClassPool* pool_ = nullptr;
+	const FrameArena* arena_ = nullptr;
+	const FramePacer* pacer_ = nullptr;
+	FrameStats begin_;
+	FrameStats last_;
+	uint64_t begin_pool_system_ = 0;
+	uint64_t begin_arena_system_ = 0;
+	std::chrono::steady_clock::time_point begin_time_;
+};
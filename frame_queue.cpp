@@ -0,0 +1,57 @@
+#include "frame_queue.h"
+
+FrameQueue::FrameQueue(size_t slot_count)
+	: free_(slot_count)
+{
+	for (size_t i = 0; i < slot_count; i++)
+		slots_.push_back(std::make_unique<RenderFrame>());
+}
+
+RenderFrame* FrameQueue::beginWrite()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	changed_.wait(lock, [this] { return free_ > 0 || stopped_; });
+	if (stopped_)
+		return nullptr;
+	free_--;
+	return slots_[write_].get();
+}
+
+void FrameQueue::endWrite()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		write_ = (write_ + 1) % slots_.size();
+		ready_++;
+	}
+	changed_.notify_all();
+}
+
+RenderFrame* FrameQueue::beginRead()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	changed_.wait(lock, [this] { return ready_ > 0 || stopped_; });
+	if (ready_ == 0)
+		return nullptr;
+	return slots_[read_].get();
+}
+
+void FrameQueue::endRead()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		read_ = (read_ + 1) % slots_.size();
+		ready_--;
+		free_++;
+	}
+	changed_.notify_all();
+}
+
+void FrameQueue::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopped_ = true;
+	}
+	changed_.notify_all();
+}
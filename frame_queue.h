@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "imgui.h"
+#include "draw_data_snapshot.h"
+
+// Everything the render thread needs to present one UI frame.
+struct RenderFrame
+{
+	DrawDataSnapshot draw_data;
+	int framebuffer_width = 0;
+	int framebuffer_height = 0;
+	ImVec4 clear_color;
+	uint64_t index = 0;
+};
+
+// Fixed ring of RenderFrames handed from the UI thread to the render thread in order.
+// The writer blocks while every slot is in flight, which bounds how many frames the
+// UI can run ahead of presentation (3 slots: one rendering, one queued, one building).
+class FrameQueue
+{
+public:
+	explicit FrameQueue(size_t slot_count = 3);
+
+	// nullptr once stop() was called
+	RenderFrame* beginWrite();
+	void endWrite();
+	// nullptr once stopped and drained
+	RenderFrame* beginRead();
+	void endRead();
+
+	void stop();
+
+private:
+	std::vector<std::unique_ptr<RenderFrame>> slots_;
+	size_t write_ = 0, read_ = 0;
+	size_t ready_ = 0, free_;
+	bool stopped_ = false;
+	std::mutex mutex_;
+	std::condition_variable changed_;
+};
@@ -0,0 +1,221 @@
+#include "frustum_culling.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define FRUSTUM_CULLING_AVX 1
+#define FRUSTUM_CULLING_AVX_TARGET
+#elif defined(__GNUC__) || defined(__clang__)
+#define FRUSTUM_CULLING_AVX 1
+#define FRUSTUM_CULLING_AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+Frustum Frustum::fromMatrix(const glm::mat4& m)
+{
+	// Gribb/Hartmann: planes are sums/differences of the matrix rows
+	glm::vec4 row[4];
+	for (int i = 0; i < 4; i++)
+		row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+	Frustum frustum;
+	frustum.planes[0] = row[3] + row[0]; // left
+	frustum.planes[1] = row[3] - row[0]; // right
+	frustum.planes[2] = row[3] + row[1]; // bottom
+	frustum.planes[3] = row[3] - row[1]; // top
+	frustum.planes[4] = row[3] + row[2]; // near
+	frustum.planes[5] = row[3] - row[2]; // far
+	for (glm::vec4& plane : frustum.planes)
+		plane = plane * (1.0f / glm::length(glm::vec3(plane)));
+	return frustum;
+}
+
+void BoundsSoA::resize(size_t count)
+{
+	center_x.resize(count);
+	center_y.resize(count);
+	center_z.resize(count);
+	extent_x.resize(count);
+	extent_y.resize(count);
+	extent_z.resize(count);
+}
+
+void BoundsSoA::set(size_t index, const glm::vec3& center, const glm::vec3& extent)
+{
+	center_x[index] = center.x;
+	center_y[index] = center.y;
+	center_z[index] = center.z;
+	extent_x[index] = extent.x;
+	extent_y[index] = extent.y;
+	extent_z[index] = extent.z;
+}
+
+void BoundsSoA::setTransformedBox(size_t index, const glm::mat4& m, const glm::vec3& local_center, const glm::vec3& local_extent)
+{
+	// half extents of the transformed box are the absolute rows of m weighted by the local half extents
+	const glm::vec3& e = local_extent;
+	glm::vec3 extent(
+		std::fabs(m[0][0]) * e.x + std::fabs(m[1][0]) * e.y + std::fabs(m[2][0]) * e.z,
+		std::fabs(m[0][1]) * e.x + std::fabs(m[1][1]) * e.y + std::fabs(m[2][1]) * e.z,
+		std::fabs(m[0][2]) * e.x + std::fabs(m[1][2]) * e.y + std::fabs(m[2][2]) * e.z);
+	set(index, glm::vec3(m * glm::vec4(local_center, 1.0f)), extent);
+}
+
+size_t cullBoxesScalar(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible, size_t begin, size_t end)
+{
+	size_t count = 0;
+	for (size_t i = begin; i < end; i++)
+	{
+		bool inside = true;
+		for (const glm::vec4& p : frustum.planes)
+		{
+			// box is outside when even its most positive corner is behind the plane
+			float distance = p.x * bounds.center_x[i] + p.y * bounds.center_y[i] + p.z * bounds.center_z[i] + p.w;
+			float radius = std::fabs(p.x) * bounds.extent_x[i] + std::fabs(p.y) * bounds.extent_y[i] + std::fabs(p.z) * bounds.extent_z[i];
+			if (distance < -radius)
+			{
+				inside = false;
+				break;
+			}
+		}
+		visible[count] = (uint32_t)i;
+		count += inside ? 1 : 0;
+	}
+	return count;
+}
+
+#if defined(FRUSTUM_CULLING_AVX)
+
+namespace
+{
+	bool cpuHasAvx()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+		return __builtin_cpu_supports("avx");
+#endif
+	}
+
+	FRUSTUM_CULLING_AVX_TARGET
+	size_t cullBoxesAvx(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible, size_t begin, size_t end)
+	{
+		__m256 plane_x[6], plane_y[6], plane_z[6], plane_w[6], abs_x[6], abs_y[6], abs_z[6];
+		for (int p = 0; p < 6; p++)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			plane_x[p] = _mm256_set1_ps(plane.x);
+			plane_y[p] = _mm256_set1_ps(plane.y);
+			plane_z[p] = _mm256_set1_ps(plane.z);
+			plane_w[p] = _mm256_set1_ps(plane.w);
+			abs_x[p] = _mm256_set1_ps(std::fabs(plane.x));
+			abs_y[p] = _mm256_set1_ps(std::fabs(plane.y));
+			abs_z[p] = _mm256_set1_ps(std::fabs(plane.z));
+		}
+
+		size_t count = 0;
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 cx = _mm256_loadu_ps(&bounds.center_x[i]);
+			__m256 cy = _mm256_loadu_ps(&bounds.center_y[i]);
+			__m256 cz = _mm256_loadu_ps(&bounds.center_z[i]);
+			__m256 ex = _mm256_loadu_ps(&bounds.extent_x[i]);
+			__m256 ey = _mm256_loadu_ps(&bounds.extent_y[i]);
+			__m256 ez = _mm256_loadu_ps(&bounds.extent_z[i]);
+
+			__m256 outside = _mm256_setzero_ps();
+			for (int p = 0; p < 6; p++)
+			{
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_x[p], cx), _mm256_mul_ps(plane_y[p], cy)),
+												_mm256_add_ps(_mm256_mul_ps(plane_z[p], cz), plane_w[p]));
+				__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(abs_x[p], ex), _mm256_mul_ps(abs_y[p], ey)), _mm256_mul_ps(abs_z[p], ez));
+				// distance < -radius  <=>  distance + radius < 0
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+
+			// branch-free compaction: always store, advance only for visible lanes
+			int mask = ~_mm256_movemask_ps(outside) & 0xFF;
+			for (uint32_t lane = 0; lane < 8; lane++)
+			{
+				visible[count] = (uint32_t)i + lane;
+				count += (mask >> lane) & 1;
+			}
+		}
+		// GCC normally puts a vzeroupper before calls and returns in target("avx") code, but GCC 12
+		// at -O2 leaves it out of this function (see the -S output). Cleared here so CPUs with an
+		// AVX-SSE transition penalty don't pay it in the SSE code that follows; one instruction.
+		_mm256_zeroupper();
+		return count + cullBoxesScalar(frustum, bounds, visible + count, i, end);
+	}
+
+	const bool kUseAvx = cpuHasAvx();
+}
+
+bool cullingUsesAvx()
+{
+	return kUseAvx;
+}
+
+size_t cullBoxes(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible, size_t begin, size_t end)
+{
+	if (kUseAvx)
+		return cullBoxesAvx(frustum, bounds, visible, begin, end);
+	return cullBoxesScalar(frustum, bounds, visible, begin, end);
+}
+
+#else
+
+bool cullingUsesAvx()
+{
+	return false;
+}
+
+size_t cullBoxes(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible, size_t begin, size_t end)
+{
+	return cullBoxesScalar(frustum, bounds, visible, begin, end);
+}
+
+#endif
+
+size_t cullBoxes(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible)
+{
+	return cullBoxes(frustum, bounds, visible, 0, bounds.size());
+}
+
+size_t cullBoxes(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible, JobSystem& jobs)
+{
+	const size_t chunk_size = 16384;
+	size_t chunk_count = (bounds.size() + chunk_size - 1) / chunk_size;
+	if (chunk_count <= 1 || jobs.threadCount() <= 1)
+		return cullBoxes(frustum, bounds, visible);
+
+	// each chunk writes its survivors to the start of its own slice of visible
+	std::vector<size_t> chunk_visible(chunk_count);
+	jobs.parallelFor(chunk_count, 1, [&](size_t begin, size_t end) {
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			size_t first = chunk * chunk_size;
+			size_t last = std::min(first + chunk_size, bounds.size());
+			chunk_visible[chunk] = cullBoxes(frustum, bounds, visible + first, first, last);
+		}
+	});
+
+	size_t count = chunk_visible[0];
+	for (size_t chunk = 1; chunk < chunk_count; chunk++)
+	{
+		memmove(visible + count, visible + chunk * chunk_size, chunk_visible[chunk] * sizeof(uint32_t));
+		count += chunk_visible[chunk];
+	}
+	return count;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+// View frustum as 6 inward-facing planes (xyz = normal, w = distance), extracted from
+// a view-projection matrix.
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	static Frustum fromMatrix(const glm::mat4& view_projection);
+};
+
+// Axis-aligned boxes in structure-of-arrays form so 8 boxes load as 6 AVX registers.
+struct BoundsSoA
+{
+	std::vector<float> center_x, center_y, center_z;
+	std::vector<float> extent_x, extent_y, extent_z;
+
+	size_t size() const { return center_x.size(); }
+	void resize(size_t count);
+	void set(size_t index, const glm::vec3& center, const glm::vec3& extent);
+	// Bounds of the local box (center, half extents) after the given transform.
+	void setTransformedBox(size_t index, const glm::mat4& transform, const glm::vec3& local_center, const glm::vec3& local_extent);
+};
+
+// Writes the indices of boxes in [begin, end) that intersect the frustum to visible
+// and returns how many were written. Uses AVX (8 boxes per iteration) when the CPU has it.
+size_t cullBoxes(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible, size_t begin, size_t end);
+size_t cullBoxes(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible);
+size_t cullBoxesScalar(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible, size_t begin, size_t end);
+bool cullingUsesAvx();
+// Culls fixed-size chunks as jobs, then compacts the per-chunk results into visible.
+size_t cullBoxes(const Frustum& frustum, const BoundsSoA& bounds, uint32_t* visible, JobSystem& jobs);
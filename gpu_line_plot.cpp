@@ -0,0 +1,289 @@
+#include "gpu_line_plot.h"
+#include "memory_telemetry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+namespace
+{
+	// Built in so the plot never depends on the working directory
+	const char* kVertexShader = R"(#version 330 core
+
+// No vertex attributes: six vertices per segment between samples i and i + 1,
+// expanded into a quad across the line in screen space.
+
+uniform samplerBuffer samples; // R32F ring of samples
+uniform int firstSlot;         // ring slot of the first drawn sample
+uniform int capacity;
+uniform float xStep;           // framebuffer pixels per sample
+uniform vec4 rect;             // plot area in framebuffer pixels: x0, y0, x1, y1, y down
+uniform vec2 valueRange;       // values at the bottom and the top edge
+uniform vec2 framebufferSize;
+uniform float thickness;
+
+out float edgeDistance;        // pixels from the centre of the line
+
+const int ends[6] = int[6](0, 1, 0, 0, 1, 1);
+const float sides[6] = float[6](-1.0, -1.0, 1.0, 1.0, -1.0, 1.0);
+
+vec2 point(int i) {
+    float value = texelFetch(samples, (firstSlot + i) % capacity).r;
+    float t = (value - valueRange.x) / (valueRange.y - valueRange.x);
+    return vec2(rect.x + float(i) * xStep, mix(rect.w, rect.y, t));
+}
+
+void main() {
+    int segment = gl_VertexID / 6;
+    int corner = gl_VertexID % 6;
+    vec2 a = point(segment);
+    vec2 b = point(segment + 1);
+    vec2 direction = b - a;
+    float len = length(direction);
+    direction = len > 0.0 ? direction / len : vec2(1.0, 0.0);
+    vec2 normal = vec2(-direction.y, direction.x);
+
+    // one extra pixel on each side for the antialiased edge, and half a pixel past
+    // both ends so neighbouring segments overlap instead of leaving gaps at the joints
+    float halfWidth = thickness * 0.5 + 1.0;
+    vec2 end = ends[corner] == 0 ? a - direction * 0.5 : b + direction * 0.5;
+    vec2 position = end + normal * sides[corner] * halfWidth;
+    edgeDistance = sides[corner] * halfWidth;
+    gl_Position = vec4(position.x / framebufferSize.x * 2.0 - 1.0, 1.0 - position.y / framebufferSize.y * 2.0, 0.0, 1.0);
+}
+)";
+
+	const char* kFragmentShader = R"(#version 330 core
+
+in float edgeDistance;
+
+out vec4 FragColor;
+
+uniform float thickness;
+uniform vec4 color;
+
+void main() {
+    float coverage = clamp(thickness * 0.5 + 0.5 - abs(edgeDistance), 0.0, 1.0);
+    FragColor = vec4(color.rgb, color.a * coverage);
+}
+)";
+}
+
+GpuLinePlot::GpuLinePlot(size_t capacity, size_t ring_capacity)
+	: capacity_(std::max<size_t>(capacity, 2)), ring_(ring_capacity)
+{
+}
+
+void GpuLinePlot::setValueRange(float lo, float hi)
+{
+	fixed_range_ = true;
+	fixed_lo_ = lo;
+	fixed_hi_ = hi;
+}
+
+void GpuLinePlot::draw(const char* label, ImVec2 size, float thickness)
+{
+	ImVec2 available_size = ImGui::GetContentRegionAvail();
+	if (size.x <= 0.0f)
+		size.x = std::max(available_size.x + size.x, 64.0f);
+	if (size.y <= 0.0f)
+		size.y = std::max(available_size.y + size.y, 32.0f);
+	ImVec2 p0 = ImGui::GetCursorScreenPos();
+	ImVec2 p1(p0.x + size.x, p0.y + size.y);
+	ImGui::InvisibleButton(label, size);
+
+	double kept = (double)shown_kept_.load(std::memory_order_relaxed);
+	if (ImGui::IsItemHovered())
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		if (io.MouseWheel != 0.0f && kept >= 2.0)
+		{
+			double visible = visible_ > 0.0 ? std::min(visible_, kept) : kept;
+			visible_ = std::clamp(visible * std::pow(0.8, (double)io.MouseWheel), 2.0, kept);
+		}
+		if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+			visible_ = 0.0;
+	}
+
+	ImDrawList* draw_list = ImGui::GetWindowDrawList();
+	draw_list->AddRectFilled(p0, p1, ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+	DrawParams& params = params_[next_slot_];
+	next_slot_ = (next_slot_ + 1) % kSlots;
+	params.plot = this;
+	params.rect = ImVec4(p0.x, p0.y, p1.x, p1.y);
+	// what the draw data will carry as DisplayPos and DisplaySize
+	params.display_pos = ImGui::GetMainViewport()->Pos;
+	params.display_size = ImGui::GetMainViewport()->Size;
+	params.visible = visible_;
+	params.fixed_range = fixed_range_;
+	params.lo = fixed_lo_;
+	params.hi = fixed_hi_;
+	params.color = ImGui::GetColorU32(ImGuiCol_PlotLines);
+	params.thickness = thickness;
+	draw_list->PushClipRect(p0, p1, true);
+	draw_list->AddCallback(&GpuLinePlot::renderCallback, &params);
+	draw_list->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+
+	float lo = fixed_range_ ? fixed_lo_ : shown_lo_.load(std::memory_order_relaxed);
+	float hi = fixed_range_ ? fixed_hi_ : shown_hi_.load(std::memory_order_relaxed);
+	char text[256];
+	const char* label_end = strstr(label, "##");
+	int label_length = label_end ? (int)(label_end - label) : (int)strlen(label);
+	snprintf(text, sizeof(text), "%.*s  [%.4g, %.4g]  %.0f of %llu samples", label_length, label, lo, hi,
+		visible_ > 0.0 ? std::min(visible_, kept) : kept, (unsigned long long)shown_total_.load(std::memory_order_relaxed));
+	draw_list->AddText(ImVec2(p0.x + 4.0f, p0.y + 2.0f), ImGui::GetColorU32(ImGuiCol_Text), text);
+	draw_list->PopClipRect();
+}
+
+void GpuLinePlot::renderCallback(const ImDrawList*, const ImDrawCmd* cmd)
+{
+	const DrawParams& params = *(const DrawParams*)cmd->UserCallbackData;
+	params.plot->render(params, cmd->ClipRect);
+}
+
+bool GpuLinePlot::init()
+{
+	initialized_ = true;
+	if (!GLEW_VERSION_3_1 && !GLEW_ARB_texture_buffer_object)
+	{
+		std::cerr << "GpuLinePlot needs texture buffers (GL 3.1)" << std::endl;
+		failed_ = true;
+		return false;
+	}
+	if (!shader_.init(kVertexShader, kFragmentShader))
+	{
+		std::cerr << "GpuLinePlot shader failed" << std::endl;
+		failed_ = true;
+		return false;
+	}
+
+	GLint max_texels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+	if (max_texels < 2)
+	{
+		std::cerr << "GpuLinePlot: no usable texture buffer size" << std::endl;
+		failed_ = true;
+		return false;
+	}
+	if (capacity_ > (size_t)max_texels)
+	{
+		std::cerr << "GpuLinePlot: keeping " << max_texels << " samples, the texture buffer limit, instead of " << capacity_ << std::endl;
+		capacity_ = (size_t)max_texels;
+	}
+
+	// the vertex shader fetches everything itself, but core profile still wants a VAO bound
+	glGenVertexArrays(1, &vao_);
+	glGenBuffers(1, &buffer_);
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer_);
+	trackedBufferData(GL_TEXTURE_BUFFER, buffer_, capacity_ * sizeof(float), NULL, GL_DYNAMIC_DRAW, "GpuLinePlot samples");
+	glGenTextures(1, &texture_);
+	glBindTexture(GL_TEXTURE_BUFFER, texture_);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, buffer_);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	return true;
+}
+
+void GpuLinePlot::shutdown()
+{
+	if (!initialized_ || failed_)
+		return;
+	glDeleteTextures(1, &texture_);
+	trackedDeleteBuffers(1, &buffer_);
+	glDeleteVertexArrays(1, &vao_);
+	shader_.destroy();
+	vao_ = buffer_ = texture_ = 0;
+	initialized_ = false;
+}
+
+// Only what arrived since the last frame goes to the GPU, into the ring at total_ % capacity_
+void GpuLinePlot::upload()
+{
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer_);
+	ring_.drain([this](const float* values, size_t count) {
+		for (size_t i = 0; i < count; i++)
+		{
+			if (total_ == 0 && i == 0)
+				lo_ = hi_ = values[0];
+			lo_ = std::min(lo_, values[i]);
+			hi_ = std::max(hi_, values[i]);
+		}
+		if (count > capacity_)
+		{
+			total_ += count - capacity_;
+			values += count - capacity_;
+			count = capacity_;
+		}
+		while (count > 0)
+		{
+			size_t slot = (size_t)(total_ % capacity_);
+			size_t piece = std::min(count, capacity_ - slot);
+			glBufferSubData(GL_TEXTURE_BUFFER, slot * sizeof(float), piece * sizeof(float), values);
+			total_ += piece;
+			values += piece;
+			count -= piece;
+		}
+	});
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	shown_total_.store(total_, std::memory_order_relaxed);
+	shown_kept_.store(std::min<uint64_t>(total_, capacity_), std::memory_order_relaxed);
+	shown_lo_.store(lo_, std::memory_order_relaxed);
+	shown_hi_.store(hi_, std::memory_order_relaxed);
+}
+
+void GpuLinePlot::render(const DrawParams& params, const ImVec4& clip)
+{
+	if (!initialized_ && !init())
+		return;
+	if (failed_)
+		return;
+	upload();
+
+	uint64_t kept = std::min<uint64_t>(total_, capacity_);
+	uint64_t count = params.visible > 0.0 ? std::min<uint64_t>((uint64_t)params.visible, kept) : kept;
+	if (count < 2)
+		return;
+	uint64_t first = total_ - count;
+	float lo = params.fixed_range ? params.lo : lo_;
+	float hi = params.fixed_range ? params.hi : hi_;
+	if (hi <= lo)
+	{
+		lo -= 1.0f;
+		hi += 1.0f;
+	}
+
+	// the renderer set the viewport to the framebuffer, which gives the display-to-pixel scale
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	float sx = params.display_size.x > 0.0f ? viewport[2] / params.display_size.x : 1.0f;
+	float sy = params.display_size.y > 0.0f ? viewport[3] / params.display_size.y : 1.0f;
+	// clip and rect are in display coordinates, which start at DisplayPos
+	ImVec2 origin = params.display_pos;
+	glScissor((int)((clip.x - origin.x) * sx), (int)(viewport[3] - (clip.w - origin.y) * sy), (int)((clip.z - clip.x) * sx), (int)((clip.w - clip.y) * sy));
+
+	ImVec4 color = ImGui::ColorConvertU32ToFloat4(params.color);
+	float x0 = (params.rect.x - origin.x) * sx, y0 = (params.rect.y - origin.y) * sy;
+	float x1 = (params.rect.z - origin.x) * sx, y1 = (params.rect.w - origin.y) * sy;
+	shader_.use();
+	shader_.setUniform("samples", 0);
+	shader_.setUniform("firstSlot", (int)(first % capacity_));
+	shader_.setUniform("capacity", (int)capacity_);
+	shader_.setUniform("xStep", (x1 - x0) / (float)(count - 1));
+	shader_.setUniform("rect", x0, y0, x1, y1);
+	shader_.setUniform("valueRange", lo, hi);
+	shader_.setUniform("framebufferSize", (float)viewport[2], (float)viewport[3]);
+	shader_.setUniform("thickness", params.thickness * sx);
+	shader_.setUniform("color", color.x, color.y, color.z, color.w);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_BUFFER, texture_);
+	glBindVertexArray(vao_);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)((count - 1) * 6));
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "imgui.h"
+#include "opengl_shader.h"
+#include "telemetry_plot.h"
+
+// Line plot drawn entirely on the GPU. Samples live in a texture buffer that only receives the
+// new ones each frame, and a vertex shader turns each pair of neighbours into a screen-space quad
+// with an antialiased edge. draw() only records an ImDrawList callback, so the CPU cost of a
+// frame does not depend on how many points are visible.
+//
+// The callback runs inside the ImGui renderer (the OpenGL3 backend or ImGuiIndirectRenderer) on
+// the thread that owns the GL context. That is also where the GL objects get created and the
+// samples uploaded, so the plot works with App's threaded rendering. Call draw() at most once
+// a frame: the parameters of the last kSlots draws are kept for frames still in flight.
+class GpuLinePlot
+{
+public:
+	// capacity is cut down to GL_MAX_TEXTURE_BUFFER_SIZE, which GL 3.1 only guarantees to be 65536
+	explicit GpuLinePlot(size_t capacity = 1 << 24, size_t ring_capacity = 1 << 18);
+
+	// Producer side, one thread
+	SampleRing& input() { return ring_; }
+
+	// Values at the bottom and top edge; by default the extremes of everything seen so far
+	void setValueRange(float lo, float hi);
+	void clearValueRange() { fixed_range_ = false; }
+
+	// Shows the newest samples, as many as the mouse wheel zoomed to; double-click shows all.
+	// A size.x or size.y <= 0 fills the available space, less that much.
+	void draw(const char* label, ImVec2 size = ImVec2(0.0f, 150.0f), float thickness = 1.0f);
+
+	// On the GL thread, before the context goes away
+	void shutdown();
+
+private:
+	static const int kSlots = 4;
+
+	struct DrawParams
+	{
+		GpuLinePlot* plot;
+		ImVec4 rect;
+		ImVec2 display_pos, display_size;
+		double visible;  // 0: everything kept
+		bool fixed_range;
+		float lo, hi;
+		ImU32 color;
+		float thickness;
+	};
+
+	static void renderCallback(const ImDrawList* list, const ImDrawCmd* cmd);
+	bool init();
+	void upload();
+	void render(const DrawParams& params, const ImVec4& clip);
+
+	size_t capacity_;  // GL thread once init() has clamped it to the driver's limit
+	SampleRing ring_;
+
+	// UI thread
+	DrawParams params_[kSlots];
+	int next_slot_ = 0;
+	double visible_ = 0.0;
+	bool fixed_range_ = false;
+	float fixed_lo_ = 0.0f, fixed_hi_ = 1.0f;
+
+	// GL thread
+	bool initialized_ = false;
+	bool failed_ = false;
+	Shader shader_;
+	unsigned int vao_ = 0, buffer_ = 0, texture_ = 0;
+	uint64_t total_ = 0;
+	float lo_ = 0.0f, hi_ = 0.0f;
+
+	// what the GL thread last saw, for the UI's caption
+	std::atomic<uint64_t> shown_total_{ 0 };
+	std::atomic<uint64_t> shown_kept_{ 0 };
+	std::atomic<float> shown_lo_{ 0.0f }, shown_hi_{ 0.0f };
+};
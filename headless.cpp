@@ -0,0 +1,169 @@
+#include "headless.h"
+#include "memory_telemetry.h"
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+bool parseHeadlessOptions(int argc, char** argv, HeadlessOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (strcmp(arg, "--headless") == 0)
+		{
+			options.enabled = true;
+		}
+		else if (strcmp(arg, "--frames") == 0)
+		{
+			if (!value || (options.frames = atoi(value)) <= 0)
+			{
+				std::cerr << "--frames needs a positive frame count\n";
+				return false;
+			}
+			i++;
+		}
+		else if (strcmp(arg, "--size") == 0)
+		{
+			if (!value || sscanf(value, "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0)
+			{
+				std::cerr << "--size needs WIDTHxHEIGHT, e.g. 1280x720\n";
+				return false;
+			}
+			i++;
+		}
+		else if (strcmp(arg, "--context") == 0)
+		{
+			if (value && strcmp(value, "native") == 0)
+				options.context = HeadlessContext::Native;
+			else if (value && strcmp(value, "egl") == 0)
+				options.context = HeadlessContext::EGL;
+			else if (value && strcmp(value, "osmesa") == 0)
+				options.context = HeadlessContext::OSMesa;
+			else
+			{
+				std::cerr << "--context needs native, egl or osmesa\n";
+				return false;
+			}
+			i++;
+		}
+	}
+	return true;
+}
+
+void applyHeadlessWindowHints(const HeadlessOptions& options)
+{
+	if (!options.enabled)
+		return;
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_FOCUSED, GLFW_FALSE);
+	switch (options.context)
+	{
+	case HeadlessContext::Native: glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API); break;
+	case HeadlessContext::EGL: glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API); break;
+	case HeadlessContext::OSMesa: glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API); break;
+	}
+}
+
+bool initGlew()
+{
+	glewExperimental = GL_TRUE;
+	GLenum result = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if (result == GLEW_ERROR_NO_GLX_DISPLAY)
+		return true;
+#endif
+	if (result != GLEW_OK)
+	{
+		std::cerr << "Failed to initialize GLEW: " << glewGetErrorString(result) << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool OffscreenTarget::create(int width, int height)
+{
+	destroy();
+	width_ = width;
+	height_ = height;
+
+	GLint previous_texture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+
+	glGenTextures(1, &color_);
+	glBindTexture(GL_TEXTURE_2D, color_);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	trackedTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr, "Offscreen color");
+
+	glGenTextures(1, &depth_);
+	glBindTexture(GL_TEXTURE_2D, depth_);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	trackedTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr, "Offscreen depth");
+	glBindTexture(GL_TEXTURE_2D, (GLuint)previous_texture);
+
+	glGenFramebuffers(1, &framebuffer_);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Offscreen framebuffer incomplete: 0x" << std::hex << status << std::dec << "\n";
+		destroy();
+		return false;
+	}
+	return true;
+}
+
+void OffscreenTarget::destroy()
+{
+	if (framebuffer_)
+		glDeleteFramebuffers(1, &framebuffer_);
+	if (color_)
+		trackedDeleteTextures(1, &color_);
+	if (depth_)
+		trackedDeleteTextures(1, &depth_);
+	framebuffer_ = color_ = depth_ = 0;
+}
+
+void OffscreenTarget::bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+}
+
+double FrameTimeStats::mean() const
+{
+	if (frame_ms_.empty())
+		return 0.0;
+	double sum = 0.0;
+	for (double ms : frame_ms_)
+		sum += ms;
+	return sum / frame_ms_.size();
+}
+
+double FrameTimeStats::percentile(double p) const
+{
+	if (frame_ms_.empty())
+		return 0.0;
+	std::vector<double> sorted = frame_ms_;
+	size_t index = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+	std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+	return sorted[index];
+}
+
+void FrameTimeStats::print(FILE* out, const char* name, double total_ms) const
+{
+	if (frame_ms_.empty())
+	{
+		fprintf(out, "%s: no frames\n", name);
+		return;
+	}
+	fprintf(out, "%s: %zu frames in %.1f ms (%.1f fps)\n", name, frames(), total_ms, frames() * 1000.0 / total_ms);
+	fprintf(out, "%8s %8s %8s %8s %8s %8s\n", "min", "mean", "p50", "p95", "p99", "max");
+	fprintf(out, "%8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n", percentile(0.0), mean(), percentile(0.50), percentile(0.95), percentile(0.99), percentile(1.0));
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+#include <GL/glew.h>
+
+struct GLFWwindow;
+
+// How the GL context of a headless run is created. Native is whatever the platform's
+// windowing system uses (GLX/WGL/NSGL); EGL and OSMesa let Mesa's llvmpipe run without a GPU.
+enum class HeadlessContext
+{
+	Native,
+	EGL,
+	OSMesa
+};
+
+struct HeadlessOptions
+{
+	bool enabled = false;
+	int frames = 1000;
+	int width = 1280;
+	int height = 720;
+	HeadlessContext context = HeadlessContext::Native;
+};
+
+// Reads --headless, --frames N, --size WxH and --context native|egl|osmesa; anything else
+// is left for the entry point. Returns false after printing the problem on a bad value.
+bool parseHeadlessOptions(int argc, char** argv, HeadlessOptions& options);
+
+// Call between glfwInit() and glfwCreateWindow(): hides the window and picks the context API
+void applyHeadlessWindowHints(const HeadlessOptions& options);
+
+// glewInit() for any context API. GLEW built for GLX reports GLEW_ERROR_NO_GLX_DISPLAY on
+// EGL/OSMesa contexts after it has already loaded every GL entry point, so that one is accepted.
+bool initGlew();
+
+// Color + depth framebuffer that stands in for the invisible window's back buffer,
+// whose pixels are undefined because nothing on screen owns them
+class OffscreenTarget
+{
+public:
+	~OffscreenTarget() { destroy(); }
+
+	bool create(int width, int height);
+	void destroy();
+	void bind() const;
+
+	GLuint framebuffer() const { return framebuffer_; }
+	int width() const { return width_; }
+	int height() const { return height_; }
+
+private:
+	GLuint framebuffer_ = 0;
+	GLuint color_ = 0;
+	GLuint depth_ = 0;
+	int width_ = 0;
+	int height_ = 0;
+};
+
+// Per-frame times of a headless run, summarized as min/mean/percentiles/max
+class FrameTimeStats
+{
+public:
+	void reserve(size_t frames) { frame_ms_.reserve(frames); }
+	void add(double ms) { frame_ms_.push_back(ms); }
+	size_t frames() const { return frame_ms_.size(); }
+	void clear() { frame_ms_.clear(); }
+
+	double mean() const;
+	// p in [0, 1]; 0 for no frames
+	double percentile(double p) const;
+
+	// total_ms is the wall time of the whole run, including the final glFinish()
+	void print(FILE* out, const char* name, double total_ms) const;
+
+private:
+	std::vector<double> frame_ms_;
+};
@@ -0,0 +1,397 @@
+#include "imgui_indirect_renderer.h"
+#include "content_hash.h"
+#include "memory_telemetry.h"
+#include "bindings/imgui_impl_opengl3.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+namespace
+{
+	const GLenum kIndexType = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	// Built in, like the OpenGL3 backend's, so the UI never depends on the working directory
+	const char* kVertexShader = R"(#version 330 core
+layout(location = 0) in vec2 aPos;   // ImDrawVert::pos, in display coordinates
+layout(location = 1) in vec2 aUV;
+layout(location = 2) in vec4 aColor; // RGBA8, normalized
+out vec2 fragUV;
+out vec4 fragColor;
+uniform mat4 projection;
+void main() {
+    fragUV = aUV;
+    fragColor = aColor;
+    gl_Position = projection * vec4(aPos, 0.0, 1.0);
+}
+)";
+
+	const char* kFragmentShader = R"(#version 330 core
+in vec2 fragUV;
+in vec4 fragColor;
+out vec4 FragColor;
+uniform sampler2D tex;
+void main() {
+    FragColor = fragColor * texture(tex, fragUV);
+}
+)";
+
+	// Clip rect in framebuffer pixels; false when nothing of the command is visible.
+	// Both passes of render() must skip exactly the same commands, so they share this.
+	bool framebufferClip(const ImDrawData* draw_data, const ImDrawCmd& cmd, ImVec4& clip)
+	{
+		if (cmd.ElemCount == 0)
+			return false;
+		ImVec2 offset = draw_data->DisplayPos;
+		ImVec2 scale = draw_data->FramebufferScale;
+		clip = ImVec4((cmd.ClipRect.x - offset.x) * scale.x, (cmd.ClipRect.y - offset.y) * scale.y,
+			(cmd.ClipRect.z - offset.x) * scale.x, (cmd.ClipRect.w - offset.y) * scale.y);
+		return clip.z > clip.x && clip.w > clip.y;
+	}
+}
+
+bool ImGuiIndirectRenderer::init()
+{
+	if (!GLEW_VERSION_4_3 && !GLEW_ARB_multi_draw_indirect)
+	{
+		std::cerr << "No multi-draw-indirect, ImGui draws one command at a time" << std::endl;
+		return false;
+	}
+	if (!shader_.init(kVertexShader, kFragmentShader))
+	{
+		std::cerr << "ImGui indirect shader failed, ImGui draws one command at a time" << std::endl;
+		return false;
+	}
+
+	glGenVertexArrays(1, &vao_);
+	glGenBuffers(1, &vbo_);
+	glGenBuffers(1, &ebo_);
+	glGenBuffers(1, &indirect_buffer_);
+	glBindVertexArray(vao_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (void *)offsetof(ImDrawVert, pos));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (void *)offsetof(ImDrawVert, uv));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (void *)offsetof(ImDrawVert, col));
+	glEnableVertexAttribArray(2);
+	// the index buffer binding is VAO state, so it stays attached
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	available_ = true;
+	return true;
+}
+
+void ImGuiIndirectRenderer::shutdown()
+{
+	if (!available_)
+		return;
+	trackedDeleteBuffers(1, &indirect_buffer_);
+	trackedDeleteBuffers(1, &ebo_);
+	trackedDeleteBuffers(1, &vbo_);
+	glDeleteVertexArrays(1, &vao_);
+	shader_.destroy();
+	vao_ = vbo_ = ebo_ = indirect_buffer_ = 0;
+	vertex_capacity_ = index_capacity_ = command_capacity_ = 0;
+	written_.clear();
+	vertex_top_ = index_top_ = 0;
+	available_ = false;
+}
+
+void ImGuiIndirectRenderer::setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height)
+{
+	// same state as the OpenGL3 backend, so callbacks written for it behave the same
+	glEnable(GL_BLEND);
+	glBlendEquation(GL_FUNC_ADD);
+	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_STENCIL_TEST);
+	glEnable(GL_SCISSOR_TEST);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glViewport(0, 0, fb_width, fb_height);
+
+	float l = draw_data->DisplayPos.x;
+	float r = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
+	float t = draw_data->DisplayPos.y;
+	float b = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
+	float projection[16] = {
+		2.0f / (r - l), 0.0f, 0.0f, 0.0f,
+		0.0f, 2.0f / (t - b), 0.0f, 0.0f,
+		0.0f, 0.0f, -1.0f, 0.0f,
+		(r + l) / (l - r), (t + b) / (b - t), 0.0f, 1.0f,
+	};
+	shader_.use();
+	shader_.setUniform("projection", &projection[0]);
+	shader_.setUniform("tex", 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindSampler(0, 0);
+
+	glBindVertexArray(vao_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+}
+
+void ImGuiIndirectRenderer::drawRun(size_t first, size_t count)
+{
+	if (count == 0)
+		return;
+	glMultiDrawElementsIndirect(GL_TRIANGLES, kIndexType, (const void *)(first * sizeof(DrawCommand)), (GLsizei)count, 0);
+	last_.draw_calls++;
+}
+
+// Orphans both buffers, at twice the frame's size at least so later frames have room for what
+// changes, and forgets what was in them
+void ImGuiIndirectRenderer::repack(size_t vertices, size_t indices)
+{
+	vertex_capacity_ = std::max(vertex_capacity_, vertices * 2);
+	index_capacity_ = std::max(index_capacity_, indices * 2);
+	trackedBufferData(GL_ARRAY_BUFFER, vbo_, vertex_capacity_ * sizeof(ImDrawVert), NULL, GL_DYNAMIC_DRAW, "ImGui indirect vertices");
+	trackedBufferData(GL_ELEMENT_ARRAY_BUFFER, ebo_, index_capacity_ * sizeof(ImDrawIdx), NULL, GL_DYNAMIC_DRAW, "ImGui indirect indices");
+	written_.clear();
+	vertex_top_ = index_top_ = 0;
+	last_.repacked = true;
+}
+
+const ImGuiIndirectRenderer::Region* ImGuiIndirectRenderer::findWritten(uint64_t hash, const ImDrawList& list) const
+{
+	auto it = std::lower_bound(written_.begin(), written_.end(), hash, [](const Written& written, uint64_t value) { return written.hash < value; });
+	for (; it != written_.end() && it->hash == hash; ++it)
+		if (it->region.vertex_count == (uint32_t)list.VtxBuffer.Size && it->region.index_count == (uint32_t)list.IdxBuffer.Size)
+			return &it->region;
+	return nullptr;
+}
+
+void ImGuiIndirectRenderer::uploadLists(ImDrawData* draw_data)
+{
+	int count = draw_data->CmdListsCount;
+	regions_.resize(count);
+	hashes_.resize(count);
+	pending_.clear();
+	size_t new_vertices = 0, new_indices = 0;
+	for (int n = 0; n < count; n++)
+	{
+		const ImDrawList* list = draw_data->CmdLists[n];
+		hashes_[n] = contentHash(list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx),
+			contentHash(list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert)));
+		if (const Region* region = findWritten(hashes_[n], *list))
+		{
+			regions_[n] = *region;
+			continue;
+		}
+		pending_.push_back(n);
+		new_vertices += list->VtxBuffer.Size;
+		new_indices += list->IdxBuffer.Size;
+	}
+	if (vertex_top_ + new_vertices > vertex_capacity_ || index_top_ + new_indices > index_capacity_)
+	{
+		repack((size_t)draw_data->TotalVtxCount, (size_t)draw_data->TotalIdxCount);
+		pending_.clear();
+		for (int n = 0; n < count; n++)
+			pending_.push_back(n);
+	}
+
+	// the new lists go above the tops, in order, where the GPU isn't reading
+	size_t vertex_base = vertex_top_, index_base = index_top_;
+	int written = 0;
+	for (int n : pending_)
+	{
+		const ImDrawList* list = draw_data->CmdLists[n];
+		// a list with the same content earlier in the frame was just written
+		if (const Region* region = findWritten(hashes_[n], *list))
+		{
+			regions_[n] = *region;
+			continue;
+		}
+		Region& region = regions_[n];
+		region.vertex_offset = (uint32_t)vertex_top_;
+		region.vertex_count = (uint32_t)list->VtxBuffer.Size;
+		region.index_offset = (uint32_t)index_top_;
+		region.index_count = (uint32_t)list->IdxBuffer.Size;
+		vertex_top_ += region.vertex_count;
+		index_top_ += region.index_count;
+		Written entry = { hashes_[n], region };
+		written_.insert(std::upper_bound(written_.begin(), written_.end(), entry, [](const Written& a, const Written& b) { return a.hash < b.hash; }), entry);
+		pending_[written++] = n;
+	}
+	pending_.resize(written);
+
+	// one unsynchronized map per buffer for the range, which no draw uses yet
+	if (vertex_top_ > vertex_base)
+	{
+		void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, vertex_base * sizeof(ImDrawVert), (vertex_top_ - vertex_base) * sizeof(ImDrawVert),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		for (int n : pending_)
+		{
+			const ImDrawList* list = draw_data->CmdLists[n];
+			size_t offset = (regions_[n].vertex_offset - vertex_base) * sizeof(ImDrawVert);
+			if (mapped)
+				memcpy((char*)mapped + offset, list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert));
+			else
+				glBufferSubData(GL_ARRAY_BUFFER, regions_[n].vertex_offset * sizeof(ImDrawVert), list->VtxBuffer.Size * sizeof(ImDrawVert), list->VtxBuffer.Data);
+		}
+		if (mapped)
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	if (index_top_ > index_base)
+	{
+		void* mapped = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, index_base * sizeof(ImDrawIdx), (index_top_ - index_base) * sizeof(ImDrawIdx),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		for (int n : pending_)
+		{
+			const ImDrawList* list = draw_data->CmdLists[n];
+			size_t offset = (regions_[n].index_offset - index_base) * sizeof(ImDrawIdx);
+			if (mapped)
+				memcpy((char*)mapped + offset, list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx));
+			else
+				glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, regions_[n].index_offset * sizeof(ImDrawIdx), list->IdxBuffer.Size * sizeof(ImDrawIdx), list->IdxBuffer.Data);
+		}
+		if (mapped)
+			glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+	}
+
+	uint64_t total = (uint64_t)draw_data->TotalVtxCount * sizeof(ImDrawVert) + (uint64_t)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+	last_.bytes_uploaded = (uint64_t)(vertex_top_ - vertex_base) * sizeof(ImDrawVert) + (uint64_t)(index_top_ - index_base) * sizeof(ImDrawIdx);
+	last_.bytes_skipped = total - std::min(total, last_.bytes_uploaded);
+}
+
+void ImGuiIndirectRenderer::render(ImDrawData* draw_data)
+{
+	last_ = IndirectRenderStats();
+	int fb_width = (int)(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
+	int fb_height = (int)(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+	if (fb_width <= 0 || fb_height <= 0)
+		return;
+
+	if (!available_)
+	{
+		ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+		for (int n = 0; n < draw_data->CmdListsCount; n++)
+			for (const ImDrawCmd& cmd : draw_data->CmdLists[n]->CmdBuffer)
+				if (!cmd.UserCallback && cmd.ElemCount > 0)
+					last_.commands++;
+		last_.draw_calls = last_.commands;
+		last_.bytes_uploaded = (uint64_t)draw_data->TotalVtxCount * sizeof(ImDrawVert) + (uint64_t)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+		return;
+	}
+
+	GLint last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, &last_active_texture);
+	glActiveTexture(GL_TEXTURE0);
+	GLint last_program; glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
+	GLint last_texture; glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+	GLint last_sampler; glGetIntegerv(GL_SAMPLER_BINDING, &last_sampler);
+	GLint last_array_buffer; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
+	GLint last_vertex_array; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
+	GLint last_indirect_buffer; glGetIntegerv(GL_DRAW_INDIRECT_BUFFER_BINDING, &last_indirect_buffer);
+	GLint last_polygon_mode[2]; glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode);
+	GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
+	GLint last_scissor_box[4]; glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
+	GLint last_blend_src_rgb; glGetIntegerv(GL_BLEND_SRC_RGB, &last_blend_src_rgb);
+	GLint last_blend_dst_rgb; glGetIntegerv(GL_BLEND_DST_RGB, &last_blend_dst_rgb);
+	GLint last_blend_src_alpha; glGetIntegerv(GL_BLEND_SRC_ALPHA, &last_blend_src_alpha);
+	GLint last_blend_dst_alpha; glGetIntegerv(GL_BLEND_DST_ALPHA, &last_blend_dst_alpha);
+	GLint last_blend_equation_rgb; glGetIntegerv(GL_BLEND_EQUATION_RGB, &last_blend_equation_rgb);
+	GLint last_blend_equation_alpha; glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &last_blend_equation_alpha);
+	GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
+	GLboolean last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
+	GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean last_enable_stencil_test = glIsEnabled(GL_STENCIL_TEST);
+	GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+
+	setupRenderState(draw_data, fb_width, fb_height);
+	uploadLists(draw_data);
+
+	// One command per visible ImDrawCmd, indexing into its list's region of the buffers
+	commands_.clear();
+	for (int n = 0; n < draw_data->CmdListsCount; n++)
+	{
+		for (const ImDrawCmd& cmd : draw_data->CmdLists[n]->CmdBuffer)
+		{
+			ImVec4 clip;
+			if (cmd.UserCallback || !framebufferClip(draw_data, cmd, clip))
+				continue;
+			DrawCommand command;
+			command.count = cmd.ElemCount;
+			command.instance_count = 1;
+			command.first_index = regions_[n].index_offset + cmd.IdxOffset;
+			command.base_vertex = (int32_t)(regions_[n].vertex_offset + cmd.VtxOffset);
+			command.base_instance = 0;
+			commands_.push_back(command);
+		}
+	}
+	last_.commands = (uint32_t)commands_.size();
+
+	// the commands are rewritten every frame; orphan them so the driver never waits on last frame's draws
+	// (only a new size goes through the telemetry)
+	if (commands_.size() > command_capacity_)
+	{
+		command_capacity_ = std::max(commands_.size(), command_capacity_ * 2);
+		trackedBufferData(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_, command_capacity_ * sizeof(DrawCommand), NULL, GL_STREAM_DRAW, "ImGui indirect commands");
+	}
+	else
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, command_capacity_ * sizeof(DrawCommand), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands_.size() * sizeof(DrawCommand), commands_.data());
+
+	// Walk the commands again in the same order; a run ends where the texture or clip rect
+	// changes or a callback comes up, and goes out as one multi-draw
+	size_t next = 0, run_first = 0;
+	ImTextureID run_texture = 0;
+	ImVec4 run_clip;
+	for (int n = 0; n < draw_data->CmdListsCount; n++)
+	{
+		const ImDrawList* list = draw_data->CmdLists[n];
+		for (const ImDrawCmd& cmd : list->CmdBuffer)
+		{
+			if (cmd.UserCallback)
+			{
+				drawRun(run_first, next - run_first);
+				run_first = next;
+				if (cmd.UserCallback == ImDrawCallback_ResetRenderState)
+					setupRenderState(draw_data, fb_width, fb_height);
+				else
+					cmd.UserCallback(list, &cmd);
+				continue;
+			}
+			ImVec4 clip;
+			if (!framebufferClip(draw_data, cmd, clip))
+				continue;
+			if (next > run_first && (cmd.GetTexID() != run_texture || memcmp(&clip, &run_clip, sizeof(clip)) != 0))
+			{
+				drawRun(run_first, next - run_first);
+				run_first = next;
+			}
+			if (next == run_first)
+			{
+				run_texture = cmd.GetTexID();
+				run_clip = clip;
+				glScissor((int)clip.x, (int)((float)fb_height - clip.w), (int)(clip.z - clip.x), (int)(clip.w - clip.y));
+				glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)run_texture);
+			}
+			next++;
+		}
+	}
+	drawRun(run_first, next - run_first);
+
+	glUseProgram(last_program);
+	glBindTexture(GL_TEXTURE_2D, last_texture);
+	glBindSampler(0, last_sampler);
+	glActiveTexture(last_active_texture);
+	glBindVertexArray(last_vertex_array);
+	glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, last_indirect_buffer);
+	glBlendEquationSeparate(last_blend_equation_rgb, last_blend_equation_alpha);
+	glBlendFuncSeparate(last_blend_src_rgb, last_blend_dst_rgb, last_blend_src_alpha, last_blend_dst_alpha);
+	if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+	if (last_enable_cull_face) glEnable(GL_CULL_FACE); else glDisable(GL_CULL_FACE);
+	if (last_enable_depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+	if (last_enable_stencil_test) glEnable(GL_STENCIL_TEST); else glDisable(GL_STENCIL_TEST);
+	if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
+	glPolygonMode(GL_FRONT_AND_BACK, (GLenum)last_polygon_mode[0]);
+	glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
+	glScissor(last_scissor_box[0], last_scissor_box[1], (GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
+}
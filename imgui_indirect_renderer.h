@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "imgui.h"
+#include "opengl_shader.h"
+
+struct IndirectRenderStats
+{
+	uint32_t commands = 0;    // ImDrawCmds that drew something
+	uint32_t draw_calls = 0;  // GL draw calls issued for them
+	// vertex and index bytes written to the GPU, and those of draw lists drawn from what an
+	// earlier frame left in the buffers
+	uint64_t bytes_uploaded = 0;
+	uint64_t bytes_skipped = 0;
+	bool repacked = false;    // the buffers were refilled from scratch
+};
+
+// Renders ImDrawData with one glMultiDrawElementsIndirect per run of commands that share a
+// texture and clip rect, instead of the backend's glDrawElementsBaseVertex per command. All
+// draw lists go into one vertex and one index buffer; the commands point into them
+// through base vertex and first index. User callbacks end a run and are called in order.
+//
+// Draw lists are hashed every frame, and one whose vertices and indices are already in the
+// buffers, from this or an earlier frame, is drawn from there instead of being uploaded again:
+// a mostly static UI sends only what changed. New data goes above everything written since the
+// buffers were last orphaned, so the GPU is never reading where it lands; once that space runs
+// out, the buffers are orphaned and refilled with just the current frame.
+//
+// Needs GL 4.3 or ARB_multi_draw_indirect. Without it, if its shader fails to build, or if init()
+// was never called, render() hands the frame to ImGui_ImplOpenGL3_RenderDrawData(). The font
+// texture still comes from the OpenGL3 backend, so its NewFrame() has to run as usual.
+class ImGuiIndirectRenderer
+{
+public:
+	// Returns false and leaves the backend loop in charge when the driver can't do it
+	bool init();
+	void shutdown();
+	bool available() const { return available_; }
+
+	void render(ImDrawData* draw_data);
+	const IndirectRenderStats& lastFrame() const { return last_; }
+
+private:
+	// layout fixed by GL
+	struct DrawCommand
+	{
+		uint32_t count;
+		uint32_t instance_count;
+		uint32_t first_index;
+		int32_t base_vertex;
+		uint32_t base_instance;
+	};
+
+	// Where a draw list's data sits in the buffers, in vertices and indices
+	struct Region
+	{
+		uint32_t vertex_offset = 0, vertex_count = 0;
+		uint32_t index_offset = 0, index_count = 0;
+	};
+
+	struct Written
+	{
+		uint64_t hash;
+		Region region;
+	};
+
+	void setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height);
+	void drawRun(size_t first, size_t count);
+	// finds or uploads every list of the frame, filling regions_
+	void uploadLists(ImDrawData* draw_data);
+	void repack(size_t vertices, size_t indices);
+	const Region* findWritten(uint64_t hash, const ImDrawList& list) const;
+
+	bool available_ = false;
+	Shader shader_;
+	unsigned int vao_ = 0, vbo_ = 0, ebo_ = 0, indirect_buffer_ = 0;
+	size_t vertex_capacity_ = 0, index_capacity_ = 0, command_capacity_ = 0;
+	std::vector<DrawCommand> commands_;
+	std::vector<Region> regions_;     // of each list of the frame
+	std::vector<uint64_t> hashes_;    // likewise
+	std::vector<int> pending_;        // lists not found in the buffers
+	// every region written since the buffers were last orphaned, sorted by content hash, and the
+	// top of them; nothing below the tops is overwritten until the next orphaning
+	std::vector<Written> written_;
+	size_t vertex_top_ = 0, index_top_ = 0;
+	IndirectRenderStats last_;
+};
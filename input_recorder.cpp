@@ -0,0 +1,277 @@
+#include "input_recorder.h"
+#include "imgui.h"
+#include "bindings/imgui_impl_glfw.h"
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	const char kMagic[4] = { 'I', 'R', 'E', 'C' };
+	const uint32_t kVersion = 1;
+}
+
+InputRecorder* InputRecorder::active_ = nullptr;
+
+bool parseInputRecordingOptions(int argc, char** argv, InputRecordingOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		bool record = strcmp(argv[i], "--record") == 0;
+		if (!record && strcmp(argv[i], "--replay") != 0)
+			continue;
+		if (i + 1 >= argc)
+		{
+			std::cerr << argv[i] << " needs a file name\n";
+			return false;
+		}
+		(record ? options.record_file : options.replay_file) = argv[++i];
+	}
+	if (!options.record_file.empty() && !options.replay_file.empty())
+	{
+		std::cerr << "--record and --replay can't be combined\n";
+		return false;
+	}
+	return true;
+}
+
+bool InputRecorder::start(GLFWwindow* window, const InputRecordingOptions& options)
+{
+	if (!options.record_file.empty())
+		return startRecording(window, options.record_file);
+	if (!options.replay_file.empty())
+		return startReplay(window, options.replay_file, options.replay_delta_time);
+	return true;
+}
+
+bool InputRecorder::startRecording(GLFWwindow* window, const std::string& filename)
+{
+	stop();
+	if (active_)
+	{
+		std::cerr << "Another InputRecorder is already running\n";
+		return false;
+	}
+	active_ = this;
+	mode_ = Mode::Record;
+	window_ = window;
+	filename_ = filename;
+	events_.clear();
+	frame_ = 0;
+	start_time_ = glfwGetTime();
+
+	Callbacks callbacks;
+	callbacks.cursor_pos = onCursorPos;
+	callbacks.mouse_button = onMouseButton;
+	callbacks.scroll = onScroll;
+	callbacks.key = onKey;
+	callbacks.character = onChar;
+	callbacks.cursor_enter = onCursorEnter;
+	callbacks.window_focus = onWindowFocus;
+	previous_ = install(callbacks);
+
+	// The backend also reads state it never gets a callback for: where the cursor already is,
+	// and whether the window is focused. Put that state at the start of the recording.
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	record(InputEventType::WindowFocus, 0, 0, glfwGetWindowAttrib(window, GLFW_FOCUSED), 0);
+	record(InputEventType::CursorEnter, 0, 0, glfwGetWindowAttrib(window, GLFW_HOVERED), 0);
+	record(InputEventType::CursorPos, (float)x, (float)y);
+	return true;
+}
+
+bool InputRecorder::startReplay(GLFWwindow* window, const std::string& filename, float delta_time)
+{
+	stop();
+	if (active_)
+	{
+		std::cerr << "Another InputRecorder is already running\n";
+		return false;
+	}
+
+	std::ifstream file(filename, std::ios::binary);
+	InputRecordingHeader header;
+	if (!file.read((char*)&header, sizeof(header)) || memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion)
+	{
+		std::cerr << "Not an input recording: " << filename << "\n";
+		return false;
+	}
+	events_.resize(header.event_count);
+	if (!file.read((char*)events_.data(), events_.size() * sizeof(InputEvent)))
+	{
+		std::cerr << "Truncated input recording: " << filename << "\n";
+		events_.clear();
+		return false;
+	}
+
+	active_ = this;
+	mode_ = Mode::Replay;
+	window_ = window;
+	filename_ = filename;
+	next_event_ = 0;
+	frame_ = 0;
+	frame_count_ = header.frame_count;
+	delta_time_ = delta_time;
+	// live input is muted so it can't mix with the recording
+	previous_ = install(Callbacks());
+	return true;
+}
+
+void InputRecorder::stop()
+{
+	if (mode_ == Mode::Off)
+		return;
+	install(previous_);
+	previous_ = Callbacks();
+
+	if (mode_ == Mode::Record)
+	{
+		std::ofstream file(filename_, std::ios::binary | std::ios::trunc);
+		InputRecordingHeader header;
+		memcpy(header.magic, kMagic, sizeof(kMagic));
+		header.version = kVersion;
+		header.frame_count = frame_;
+		header.event_count = (uint32_t)events_.size();
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)events_.data(), events_.size() * sizeof(InputEvent));
+		if (!file)
+			std::cerr << "Failed to write input recording " << filename_ << "\n";
+	}
+
+	events_.clear();
+	mode_ = Mode::Off;
+	window_ = nullptr;
+	active_ = nullptr;
+}
+
+void InputRecorder::newFrame()
+{
+	if (mode_ == Mode::Replay)
+	{
+		while (next_event_ < events_.size() && events_[next_event_].frame <= frame_)
+			dispatchInputEvent(window_, events_[next_event_++]);
+	}
+	if (mode_ != Mode::Off)
+		frame_++;
+}
+
+void InputRecorder::applyReplayDeltaTime() const
+{
+	if (mode_ == Mode::Replay)
+		ImGui::GetIO().DeltaTime = delta_time_;
+}
+
+InputRecorder::Callbacks InputRecorder::install(const Callbacks& callbacks)
+{
+	Callbacks previous;
+	previous.cursor_pos = glfwSetCursorPosCallback(window_, callbacks.cursor_pos);
+	previous.mouse_button = glfwSetMouseButtonCallback(window_, callbacks.mouse_button);
+	previous.scroll = glfwSetScrollCallback(window_, callbacks.scroll);
+	previous.key = glfwSetKeyCallback(window_, callbacks.key);
+	previous.character = glfwSetCharCallback(window_, callbacks.character);
+	previous.cursor_enter = glfwSetCursorEnterCallback(window_, callbacks.cursor_enter);
+	previous.window_focus = glfwSetWindowFocusCallback(window_, callbacks.window_focus);
+	return previous;
+}
+
+void InputRecorder::record(InputEventType type, uint8_t action, uint16_t mods, int32_t a, int32_t b)
+{
+	InputEvent event;
+	event.frame = frame_;
+	event.time_us = (uint32_t)((glfwGetTime() - start_time_) * 1e6);
+	event.type = type;
+	event.action = action;
+	event.mods = mods;
+	event.i[0] = a;
+	event.i[1] = b;
+	events_.push_back(event);
+}
+
+void InputRecorder::record(InputEventType type, float x, float y)
+{
+	record(type, 0, 0, 0, 0);
+	events_.back().f[0] = x;
+	events_.back().f[1] = y;
+}
+
+void dispatchInputEvent(GLFWwindow* window, const InputEvent& event)
+{
+	switch (event.type)
+	{
+	case InputEventType::CursorPos: ImGui_ImplGlfw_CursorPosCallback(window, event.f[0], event.f[1]); break;
+	case InputEventType::MouseButton: ImGui_ImplGlfw_MouseButtonCallback(window, event.i[0], event.action, event.mods); break;
+	case InputEventType::Scroll: ImGui_ImplGlfw_ScrollCallback(window, event.f[0], event.f[1]); break;
+	case InputEventType::Key: ImGui_ImplGlfw_KeyCallback(window, event.i[0], event.i[1], event.action, event.mods); break;
+	case InputEventType::Char: ImGui_ImplGlfw_CharCallback(window, (unsigned int)event.i[0]); break;
+	case InputEventType::CursorEnter: ImGui_ImplGlfw_CursorEnterCallback(window, event.i[0]); break;
+	case InputEventType::WindowFocus: ImGui_ImplGlfw_WindowFocusCallback(window, event.i[0]); break;
+	}
+	if (event.type != InputEventType::MouseButton && event.type != InputEventType::Key)
+		return;
+
+	// The backend reads the modifiers with glfwGetKey(), i.e. from whoever types into this
+	// window, which during a replay or for a remote viewer is nobody. Queued after the backend's
+	// events, these win. A modifier key's own event carries the state from before it.
+	int key = event.type == InputEventType::Key ? event.i[0] : GLFW_KEY_UNKNOWN;
+	auto modifier = [&](int mod, int left, int right) {
+		if (key == left || key == right)
+			return event.action != GLFW_RELEASE;
+		return (event.mods & mod) != 0;
+	};
+	ImGuiIO& io = ImGui::GetIO();
+	io.AddKeyEvent(ImGuiMod_Ctrl, modifier(GLFW_MOD_CONTROL, GLFW_KEY_LEFT_CONTROL, GLFW_KEY_RIGHT_CONTROL));
+	io.AddKeyEvent(ImGuiMod_Shift, modifier(GLFW_MOD_SHIFT, GLFW_KEY_LEFT_SHIFT, GLFW_KEY_RIGHT_SHIFT));
+	io.AddKeyEvent(ImGuiMod_Alt, modifier(GLFW_MOD_ALT, GLFW_KEY_LEFT_ALT, GLFW_KEY_RIGHT_ALT));
+	io.AddKeyEvent(ImGuiMod_Super, modifier(GLFW_MOD_SUPER, GLFW_KEY_LEFT_SUPER, GLFW_KEY_RIGHT_SUPER));
+}
+
+void InputRecorder::onCursorPos(GLFWwindow* window, double x, double y)
+{
+	active_->record(InputEventType::CursorPos, (float)x, (float)y);
+	if (active_->previous_.cursor_pos)
+		active_->previous_.cursor_pos(window, x, y);
+}
+
+void InputRecorder::onMouseButton(GLFWwindow* window, int button, int action, int mods)
+{
+	active_->record(InputEventType::MouseButton, (uint8_t)action, (uint16_t)mods, button, 0);
+	if (active_->previous_.mouse_button)
+		active_->previous_.mouse_button(window, button, action, mods);
+}
+
+void InputRecorder::onScroll(GLFWwindow* window, double x, double y)
+{
+	active_->record(InputEventType::Scroll, (float)x, (float)y);
+	if (active_->previous_.scroll)
+		active_->previous_.scroll(window, x, y);
+}
+
+void InputRecorder::onKey(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	active_->record(InputEventType::Key, (uint8_t)action, (uint16_t)mods, key, scancode);
+	if (active_->previous_.key)
+		active_->previous_.key(window, key, scancode, action, mods);
+}
+
+void InputRecorder::onChar(GLFWwindow* window, unsigned int codepoint)
+{
+	active_->record(InputEventType::Char, 0, 0, (int32_t)codepoint, 0);
+	if (active_->previous_.character)
+		active_->previous_.character(window, codepoint);
+}
+
+void InputRecorder::onCursorEnter(GLFWwindow* window, int entered)
+{
+	active_->record(InputEventType::CursorEnter, 0, 0, entered, 0);
+	if (active_->previous_.cursor_enter)
+		active_->previous_.cursor_enter(window, entered);
+}
+
+void InputRecorder::onWindowFocus(GLFWwindow* window, int focused)
+{
+	active_->record(InputEventType::WindowFocus, 0, 0, focused, 0);
+	if (active_->previous_.window_focus)
+		active_->previous_.window_focus(window, focused);
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct GLFWwindow;
+
+enum class InputEventType : uint8_t
+{
+	CursorPos,
+	MouseButton,
+	Scroll,
+	Key,
+	Char,
+	CursorEnter,
+	WindowFocus
+};
+
+// One GLFW input callback, stamped with the frame whose glfwPollEvents() delivered it and the
+// microseconds since recording started. Written to disk as is: little-endian, 20 bytes.
+struct InputEvent
+{
+	uint32_t frame;
+	uint32_t time_us;
+	InputEventType type;
+	uint8_t action;
+	uint16_t mods;
+	union
+	{
+		int32_t i[2];   // button; key, scancode; entered/focused; codepoint
+		float f[2];     // cursor position; scroll offsets
+	};
+};
+static_assert(sizeof(InputEvent) == 20, "InputEvent is stored as raw bytes");
+
+struct InputRecordingHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t frame_count;
+	uint32_t event_count;
+};
+
+struct InputRecordingOptions
+{
+	std::string record_file;
+	std::string replay_file;
+	float replay_delta_time = 1.0f / 60.0f;
+};
+
+// Reads --record FILE and --replay FILE; anything else is left for the entry point
+bool parseInputRecordingOptions(int argc, char** argv, InputRecordingOptions& options);
+
+// Feeds an event to the ImGui GLFW backend as if window had received it, which forwards it to
+// the app's own callbacks. The modifier keys come from the event, not the window's keyboard.
+void dispatchInputEvent(GLFWwindow* window, const InputEvent& event);
+
+// Records the GLFW input callbacks of a window into a compact binary file, or replays such a
+// file into the ImGui GLFW backend frame by frame with a fixed delta time and live input muted.
+//
+// Recording wraps whatever callbacks are installed (normally the ImGui backend's, which chain
+// to the app's) and forwards every event. Start after ImGui_ImplGlfw_InitForOpenGL() and stop
+// before ImGui_ImplGlfw_Shutdown(), so the callback chain unwinds in order. One at a time.
+class InputRecorder
+{
+public:
+	~InputRecorder() { stop(); }
+
+	// Starts recording or replay as options ask; true when neither is requested
+	bool start(GLFWwindow* window, const InputRecordingOptions& options);
+	bool startRecording(GLFWwindow* window, const std::string& filename);
+	bool startReplay(GLFWwindow* window, const std::string& filename, float delta_time = 1.0f / 60.0f);
+	// Writes the recording out, or restores live input after a replay
+	void stop();
+
+	// Call every frame right after glfwPollEvents(): closes the frame's recorded events,
+	// or feeds the recorded events of the frame to the backend
+	void newFrame();
+	// Call after ImGui_ImplGlfw_NewFrame(): during a replay replaces the measured delta time
+	void applyReplayDeltaTime() const;
+
+	bool recording() const { return mode_ == Mode::Record; }
+	bool replaying() const { return mode_ == Mode::Replay; }
+	// All recorded frames were fed back
+	bool replayFinished() const { return mode_ == Mode::Replay && frame_ >= frame_count_; }
+	uint32_t frame() const { return frame_; }
+
+private:
+	enum class Mode
+	{
+		Off,
+		Record,
+		Replay
+	};
+
+	struct Callbacks
+	{
+		void (*cursor_pos)(GLFWwindow*, double, double) = nullptr;
+		void (*mouse_button)(GLFWwindow*, int, int, int) = nullptr;
+		void (*scroll)(GLFWwindow*, double, double) = nullptr;
+		void (*key)(GLFWwindow*, int, int, int, int) = nullptr;
+		void (*character)(GLFWwindow*, unsigned int) = nullptr;
+		void (*cursor_enter)(GLFWwindow*, int) = nullptr;
+		void (*window_focus)(GLFWwindow*, int) = nullptr;
+	};
+
+	// returns what was installed before
+	Callbacks install(const Callbacks& callbacks);
+	void record(InputEventType type, uint8_t action, uint16_t mods, int32_t a, int32_t b);
+	void record(InputEventType type, float x, float y);
+
+	static void onCursorPos(GLFWwindow* window, double x, double y);
+	static void onMouseButton(GLFWwindow* window, int button, int action, int mods);
+	static void onScroll(GLFWwindow* window, double x, double y);
+	static void onKey(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void onChar(GLFWwindow* window, unsigned int codepoint);
+	static void onCursorEnter(GLFWwindow* window, int entered);
+	static void onWindowFocus(GLFWwindow* window, int focused);
+
+	static InputRecorder* active_;
+
+	Mode mode_ = Mode::Off;
+	GLFWwindow* window_ = nullptr;
+	std::string filename_;
+	// what was installed before start(); recording forwards to these, stop() puts them back
+	Callbacks previous_;
+	std::vector<InputEvent> events_;
+	size_t next_event_ = 0;
+	uint32_t frame_ = 0;
+	uint32_t frame_count_ = 0;
+	double start_time_ = 0.0;
+	float delta_time_ = 1.0f / 60.0f;
+};
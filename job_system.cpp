@@ -0,0 +1,201 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+namespace
+{
+	thread_local const JobSystem* tls_job_system = nullptr;
+	thread_local unsigned int tls_worker_index = 0;
+}
+
+bool JobSystem::init(unsigned int thread_count)
+{
+	shutdown();
+	if (thread_count == 0)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned int i = 0; i < thread_count; i++)
+		queues_.push_back(std::make_unique<Queue>());
+	running_ = true;
+	for (unsigned int i = 1; i < thread_count; i++)
+		workers_.emplace_back(&JobSystem::workerLoop, this, i);
+	return true;
+}
+
+void JobSystem::shutdown()
+{
+	if (!running_)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex_);
+		running_ = false;
+	}
+	wake_.notify_all();
+	for (std::thread& worker : workers_)
+		worker.join();
+	workers_.clear();
+	// run() jobs own their callable, which executeFunction would have freed
+	for (const std::unique_ptr<Queue>& queue : queues_)
+	{
+		for (const Job& job : queue->jobs)
+		{
+			if (job.execute == &JobSystem::executeFunction)
+				delete (std::function<void()>*)job.context;
+		}
+	}
+	queues_.clear();
+	queued_ = 0;
+}
+
+void JobSystem::run(std::function<void()> job, JobCounter* counter)
+{
+	Job queued;
+	queued.execute = &JobSystem::executeFunction;
+	queued.context = new std::function<void()>(std::move(job));
+	queued.counter = counter;
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	push(queued);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	unsigned int index = currentIndex();
+	// workers may run anything; other threads only help with what they wait for
+	const JobCounter* only = tls_job_system == this ? nullptr : &counter;
+	while (counter.pending.load(std::memory_order_acquire) > 0)
+	{
+		if (!runOne(index, only))
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, RangeFunction function, void* context)
+{
+	grain = std::max<size_t>(grain, 1);
+	if (count <= grain || queues_.size() <= 1)
+	{
+		if (count > 0)
+			function(context, 0, count);
+		return;
+	}
+
+	JobCounter counter;
+	Job job;
+	job.execute = &JobSystem::executeRange;
+	job.function = function;
+	job.context = context;
+	job.begin = 0;
+	job.end = count;
+	job.grain = grain;
+	job.counter = &counter;
+	counter.pending = 1;
+	executeRange(*this, job);
+	counter.pending.fetch_sub(1, std::memory_order_release);
+	wait(counter);
+}
+
+void JobSystem::executeFunction(JobSystem&, const Job& job)
+{
+	std::function<void()>* function = (std::function<void()>*)job.context;
+	(*function)();
+	delete function;
+}
+
+void JobSystem::executeRange(JobSystem& jobs, const Job& job)
+{
+	// keep the front half, offer the back half to thieves, until the range fits the grain
+	size_t begin = job.begin, end = job.end;
+	while (end - begin > job.grain)
+	{
+		size_t middle = begin + (end - begin) / 2;
+		Job half = job;
+		half.begin = middle;
+		half.end = end;
+		job.counter->pending.fetch_add(1, std::memory_order_relaxed);
+		jobs.push(half);
+		end = middle;
+	}
+	job.function(job.context, begin, end);
+}
+
+unsigned int JobSystem::currentIndex() const
+{
+	// threads that are not workers of this system share the owner's queue
+	return tls_job_system == this ? tls_worker_index : 0;
+}
+
+void JobSystem::push(const Job& job)
+{
+	Queue& queue = *queues_[currentIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+	queued_.fetch_add(1);
+	if (sleeping_.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex_);
+		wake_.notify_one();
+	}
+}
+
+bool JobSystem::runOne(unsigned int index, const JobCounter* counter)
+{
+	// own queue from the back, other queues from the front
+	auto take = [counter](Queue& queue, bool from_back, Job& job) {
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+			return false;
+		if (!counter)
+		{
+			job = from_back ? queue.jobs.back() : queue.jobs.front();
+			if (from_back)
+				queue.jobs.pop_back();
+			else
+				queue.jobs.pop_front();
+			return true;
+		}
+		size_t count = queue.jobs.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			auto it = queue.jobs.begin() + (from_back ? count - 1 - i : i);
+			if (it->counter == counter)
+			{
+				job = *it;
+				queue.jobs.erase(it);
+				return true;
+			}
+		}
+		return false;
+	};
+
+	Job job;
+	bool found = take(*queues_[index], true, job);
+	for (size_t offset = 1; !found && offset < queues_.size(); offset++)
+		found = take(*queues_[(index + offset) % queues_.size()], false, job);
+	if (!found)
+		return false;
+
+	queued_.fetch_sub(1);
+	job.execute(*this, job);
+	if (job.counter)
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+	tls_job_system = this;
+	tls_worker_index = index;
+	while (running_)
+	{
+		if (runOne(index))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleep_mutex_);
+		sleeping_.fetch_add(1);
+		wake_.wait(lock, [this] { return queued_.load() > 0 || !running_; });
+		sleeping_.fetch_sub(1);
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts outstanding jobs; a job system wait() on it returns once they all finished.
+// A wait counter only: nothing is scheduled when it reaches zero, so ordering between
+// jobs comes from the thread that waits and then queues the next ones.
+struct JobCounter
+{
+	std::atomic<size_t> pending{ 0 };
+};
+
+// Work-stealing job system: every thread (the owner thread included, as index 0) has
+// its own deque, pushes and pops at the back and steals from the front of the others.
+// Waiting threads run jobs instead of blocking, so jobs may spawn and wait on jobs. A thread
+// that is not one of the workers (the UI thread, say) only runs jobs of the counter it waits
+// on, so its wait never picks up someone else's long sort or scan.
+class JobSystem
+{
+public:
+	using RangeFunction = void (*)(void* context, size_t begin, size_t end);
+
+	~JobSystem() { shutdown(); }
+
+	// thread_count includes the calling thread; 0 uses all hardware threads
+	bool init(unsigned int thread_count = 0);
+	// Jobs still queued are dropped without running.
+	void shutdown();
+	unsigned int threadCount() const { return (unsigned int)queues_.size(); }
+
+	// Queues job; counter, if given, is incremented now and decremented when it finishes.
+	void run(std::function<void()> job, JobCounter* counter = nullptr);
+	void wait(JobCounter& counter);
+
+	// Calls body(begin, end) over [0, count), halving ranges down to grain items so idle
+	// threads can steal the other halves. Returns when the whole range is done.
+	template <typename Body>
+	void parallelFor(size_t count, size_t grain, const Body& body)
+	{
+		parallelFor(count, grain, [](void* context, size_t begin, size_t end) { (*(const Body*)context)(begin, end); }, (void*)&body);
+	}
+	void parallelFor(size_t count, size_t grain, RangeFunction function, void* context);
+
+private:
+	struct Job
+	{
+		void (*execute)(JobSystem& jobs, const Job& job) = nullptr;
+		RangeFunction function = nullptr;
+		void* context = nullptr;
+		size_t begin = 0, end = 0, grain = 0;
+		JobCounter* counter = nullptr;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	static void executeFunction(JobSystem& jobs, const Job& job);
+	static void executeRange(JobSystem& jobs, const Job& job);
+
+	unsigned int currentIndex() const;
+	void push(const Job& job);
+	// runs a job from index's queue or stolen from another; only jobs of counter when it is given
+	bool runOne(unsigned int index, const JobCounter* counter = nullptr);
+	void workerLoop(unsigned int index);
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> workers_;
+	std::atomic<bool> running_{ false };
+	std::atomic<size_t> queued_{ 0 };
+	std::atomic<unsigned int> sleeping_{ 0 };
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_;
+};
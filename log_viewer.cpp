@@ -0,0 +1,326 @@
+#include "log_viewer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOG_VIEWER_SSE2 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+	// Bytes scanned between two publishes of the index: small at first so the first screen shows
+	// up before much of a cold file is read, doubling up to the maximum
+	const size_t kFirstIndexChunk = 64 << 10;
+	const size_t kIndexChunk = 8 << 20;
+	const auto kPollInterval = std::chrono::milliseconds(250);
+	const size_t kMaxDrawnLine = 4096;   // longer lines are cut when drawn
+
+#if defined(LOG_VIEWER_SSE2)
+	int lowestBit(uint64_t mask)
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return (int)index;
+#else
+		return __builtin_ctzll(mask);
+#endif
+	}
+#endif
+
+	// Appends base + i + 1 for every '\n' at data[i]. 64 bytes per step: four 16-byte compares
+	// folded into one mask, so newline-free stretches cost a few instructions per cache line.
+	void findLineStarts(const uint8_t* data, size_t size, uint64_t base, std::vector<uint64_t>& starts)
+	{
+		size_t i = 0;
+#if defined(LOG_VIEWER_SSE2)
+		const __m128i newline = _mm_set1_epi8('\n');
+		for (; i + 64 <= size; i += 64)
+		{
+			const __m128i* block = (const __m128i*)(data + i);
+			uint64_t mask = (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block), newline))
+				| (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block + 1), newline)) << 16
+				| (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block + 2), newline)) << 32
+				| (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block + 3), newline)) << 48;
+			while (mask)
+			{
+				starts.push_back(base + i + lowestBit(mask) + 1);
+				mask &= mask - 1;
+			}
+		}
+#endif
+		while (i < size)
+		{
+			const uint8_t* found = (const uint8_t*)memchr(data + i, '\n', size - i);
+			if (!found)
+				break;
+			i = (size_t)(found - data) + 1;
+			starts.push_back(base + i);
+		}
+	}
+}
+
+void LogViewer::LineIndex::push(uint64_t start)
+{
+	if (blocks_.empty() || blocks_.back().size() == kBlock)
+	{
+		blocks_.emplace_back();
+		blocks_.back().reserve(kBlock);
+	}
+	blocks_.back().push_back(start);
+}
+
+uint64_t LogViewer::LineIndex::find(uint64_t offset) const
+{
+	auto block = std::upper_bound(blocks_.begin(), blocks_.end(), offset,
+		[](uint64_t value, const std::vector<uint64_t>& starts) { return value < starts.front(); });
+	if (block == blocks_.begin())
+		return 0;
+	--block;
+	auto start = std::upper_bound(block->begin(), block->end(), offset) - 1;
+	return (uint64_t)(block - blocks_.begin()) * kBlock + (uint64_t)(start - block->begin());
+}
+
+LogViewer::~LogViewer()
+{
+	close();
+}
+
+bool LogViewer::open(const std::string& filename)
+{
+	close();
+	auto file = std::make_shared<MappedFile>();
+	if (!file->open(filename))
+		return false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		file_ = file;
+		line_starts_.clear();
+		indexed_bytes_ = 0;
+	}
+	scroll_to_end_ = follow_;
+	highlight_line_ = UINT64_MAX;
+	indexer_ = std::thread(&LogViewer::indexLoop, this, filename);
+	return true;
+}
+
+void LogViewer::close()
+{
+	if (indexer_.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		wake_.notify_all();
+		indexer_.join();
+		stop_ = false;
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	file_.reset();
+	line_starts_.clear();
+	indexed_bytes_ = 0;
+}
+
+uint64_t LogViewer::lineCountLocked() const
+{
+	// the last start opens a line only if something follows it
+	uint64_t count = line_starts_.size();
+	return line_starts_.back() == indexed_bytes_ ? count - 1 : count;
+}
+
+uint64_t LogViewer::lineCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return lineCountLocked();
+}
+
+uint64_t LogViewer::indexedBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return indexed_bytes_;
+}
+
+uint64_t LogViewer::fileSize() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return file_ ? file_->size() : 0;
+}
+
+std::shared_ptr<const MappedFile> LogViewer::file() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return file_;
+}
+
+uint64_t LogViewer::lineOf(uint64_t offset) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return line_starts_.find(offset);
+}
+
+void LogViewer::scrollToOffset(uint64_t offset)
+{
+	scroll_to_offset_ = offset;
+	follow_ = false;
+}
+
+void LogViewer::indexLoop(std::string filename)
+{
+	std::shared_ptr<const MappedFile> file;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		file = file_;
+	}
+	uint64_t scanned = 0;
+	size_t chunk = kFirstIndexChunk;
+	std::vector<uint8_t> buffer;
+	std::vector<uint64_t> found;
+	while (!stop_)
+	{
+		if (scanned < file->size())
+		{
+			size_t count = (size_t)std::min<uint64_t>(chunk, file->size() - scanned);
+			chunk = std::min(chunk * 2, kIndexChunk);
+			buffer.resize(count);
+			// short when the file was truncated since it was mapped; the poll below sees that
+			size_t got = file->read(scanned, buffer.data(), count);
+			found.clear();
+			findLineStarts(buffer.data(), got, scanned, found);
+			scanned += got;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				for (uint64_t start : found)
+					line_starts_.push(start);
+				indexed_bytes_ = scanned;
+			}
+			if (got == count)
+				continue;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait_for(lock, kPollInterval, [this]() { return stop_.load(); });
+		}
+		std::error_code error;
+		uint64_t size = std::filesystem::file_size(filename, error);
+		if (stop_ || error || size == file->size())
+			continue;
+
+		// A mapping can't grow, so map the file again; the UI keeps reading through the old
+		// one until it picks up the new one
+		auto next = std::make_shared<MappedFile>();
+		if (!next->open(filename))
+			continue;
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (next->size() < scanned)
+		{
+			line_starts_.clear();
+			indexed_bytes_ = 0;
+			scanned = 0;
+		}
+		file_ = next;
+		file = next;
+	}
+}
+
+void LogViewer::draw(const char* label, ImVec2 size)
+{
+	std::shared_ptr<const MappedFile> file;
+	uint64_t lines = 0, indexed = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		file = file_;
+		indexed = indexed_bytes_;
+		lines = lineCountLocked();
+	}
+	ImGui::PushID(label);
+	if (!file)
+	{
+		ImGui::TextDisabled("No file open");
+		ImGui::PopID();
+		return;
+	}
+
+	ImGui::Text("%s  %.1f MB  %llu lines", file->filename().c_str(), file->size() / (1024.0 * 1024.0), (unsigned long long)lines);
+	if (indexed < file->size())
+	{
+		ImGui::SameLine();
+		ImGui::TextDisabled("indexing %.0f%%", 100.0 * indexed / file->size());
+	}
+	ImGui::SameLine();
+	if (ImGui::Checkbox("Follow", &follow_) && follow_)
+		scroll_to_end_ = true;
+
+	ImVec2 available_size = ImGui::GetContentRegionAvail();
+	if (size.x <= 0.0f)
+		size.x = std::max(available_size.x + size.x, 64.0f);
+	if (size.y <= 0.0f)
+		size.y = std::max(available_size.y + size.y, 32.0f);
+	if (ImGui::BeginChild(label, size, ImGuiChildFlags_Border, ImGuiWindowFlags_HorizontalScrollbar))
+	{
+		if (scroll_to_offset_ != UINT64_MAX)
+		{
+			highlight_line_ = lineOf(scroll_to_offset_);
+			scroll_to_offset_ = UINT64_MAX;
+			float line_height = ImGui::GetTextLineHeightWithSpacing();
+			ImGui::SetScrollY(std::max(0.0f, highlight_line_ * line_height - ImGui::GetWindowHeight() * 0.5f));
+		}
+
+		int digits = 1;
+		for (uint64_t n = lines; n >= 10; n /= 10)
+			digits++;
+
+		ImGuiListClipper clipper;
+		clipper.Begin((int)std::min<uint64_t>(lines, INT_MAX));
+		while (clipper.Step())
+		{
+			// the line after the last visible one gives its end
+			visible_starts_.clear();
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				uint64_t last = std::min<uint64_t>(line_starts_.size(), (uint64_t)clipper.DisplayEnd + 1);
+				for (uint64_t line = clipper.DisplayStart; line < last; line++)
+					visible_starts_.push_back(line_starts_[line]);
+			}
+			// offsets are clamped to what was indexed in this mapping, and a read comes up short
+			// where the file was truncated since
+			uint64_t limit = std::min<uint64_t>(indexed, file->size());
+			line_text_.resize(kMaxDrawnLine);
+			const char* text = line_text_.data();
+			for (size_t i = 0; i < visible_starts_.size() && clipper.DisplayStart + i < (size_t)clipper.DisplayEnd; i++)
+			{
+				uint64_t begin = std::min(visible_starts_[i], limit);
+				uint64_t end = i + 1 < visible_starts_.size() ? visible_starts_[i + 1] - 1 : limit;
+				end = std::max(begin, std::min(std::min(end, limit), begin + kMaxDrawnLine));
+				size_t length = file->read(begin, line_text_.data(), (size_t)(end - begin));
+				if (length > 0 && text[length - 1] == '\r')
+					length--;
+				if (clipper.DisplayStart + i == highlight_line_)
+				{
+					ImVec2 p0 = ImGui::GetCursorScreenPos();
+					ImVec2 p1(p0.x + ImGui::GetWindowWidth() + ImGui::GetScrollX(), p0.y + ImGui::GetTextLineHeight());
+					ImGui::GetWindowDrawList()->AddRectFilled(p0, p1, ImGui::GetColorU32(ImGuiCol_TextSelectedBg));
+				}
+				ImGui::TextDisabled("%*llu", digits, (unsigned long long)(clipper.DisplayStart + i + 1));
+				ImGui::SameLine();
+				ImGui::TextUnformatted(text, text + length);
+			}
+		}
+		clipper.End();
+
+		if (scroll_to_end_ || (follow_ && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()))
+			ImGui::SetScrollHereY(1.0f);
+		scroll_to_end_ = false;
+	}
+	ImGui::EndChild();
+	ImGui::PopID();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "imgui.h"
+#include "mapped_file.h"
+
+// Log file panel for files of any size. The file is never read in whole: a worker thread indexes
+// the line starts a chunk at a time while the first lines are already on screen, and only the
+// visible lines are read each frame. Both go through MappedFile::read() rather than the mapping,
+// since a log can be truncated under us and a mapped page past the new end faults. When the
+// worker reaches the end it polls the file: growth is indexed as it comes (tail-follow), a
+// shrink (truncation, rotation) starts the index over.
+class LogViewer
+{
+public:
+	LogViewer() = default;
+	~LogViewer();
+	LogViewer(const LogViewer&) = delete;
+	LogViewer& operator=(const LogViewer&) = delete;
+
+	bool open(const std::string& filename);
+	void close();
+	bool isOpen() const { return indexer_.joinable(); }
+
+	uint64_t lineCount() const;
+	// Bytes indexed so far and the size of the file as last mapped
+	uint64_t indexedBytes() const;
+	uint64_t fileSize() const;
+	// The current mapping, e.g. for a TextSearch; stays valid while held, but reading it faults
+	// if the file is truncated meanwhile
+	std::shared_ptr<const MappedFile> file() const;
+
+	// Zero-based line holding the byte at offset, as far as indexed
+	uint64_t lineOf(uint64_t offset) const;
+	// Scrolls the line holding offset into the middle of the view and highlights it
+	void scrollToOffset(uint64_t offset);
+
+	// Keep the newest line in view while the file grows, for as long as the view stays scrolled
+	// to the end
+	void setFollow(bool follow) { follow_ = follow; scroll_to_end_ = follow; }
+
+	// A size.x or size.y <= 0 fills the available space, less that much
+	void draw(const char* label, ImVec2 size = ImVec2(0.0f, 0.0f));
+
+private:
+	// Line starts in fixed-size blocks, so appending never copies what is already indexed
+	// (and never stalls the UI, which reads it under the same mutex)
+	class LineIndex
+	{
+	public:
+		LineIndex() { clear(); }
+		void clear() { blocks_.clear(); push(0); }
+		void push(uint64_t start);
+		uint64_t size() const { return blocks_.empty() ? 0 : (blocks_.size() - 1) * kBlock + blocks_.back().size(); }
+		uint64_t operator[](uint64_t line) const { return blocks_[line / kBlock][line % kBlock]; }
+		uint64_t back() const { return blocks_.back().back(); }
+		// index of the last start <= offset
+		uint64_t find(uint64_t offset) const;
+
+	private:
+		static const size_t kBlock = 1 << 16;
+		std::vector<std::vector<uint64_t>> blocks_;
+	};
+
+	void indexLoop(std::string filename);
+	uint64_t lineCountLocked() const;
+
+	mutable std::mutex mutex_;
+	std::shared_ptr<const MappedFile> file_;  // replaced, never modified, when the file changes size
+	LineIndex line_starts_;  // 0, then the offset just past each newline
+	uint64_t indexed_bytes_ = 0;
+
+	std::thread indexer_;
+	std::atomic<bool> stop_{ false };
+	std::condition_variable wake_;
+
+	// UI thread
+	bool follow_ = true;
+	bool scroll_to_end_ = false;
+	uint64_t scroll_to_offset_ = UINT64_MAX;
+	uint64_t highlight_line_ = UINT64_MAX;
+	std::vector<uint64_t> visible_starts_;
+	std::vector<char> line_text_;
+};
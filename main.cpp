@@ -7,20 +7,32 @@
 #include "main_draggable3.cpp"
 #include "main_draggable4.cpp"
 #include "main_draggable5.cpp"
+#include "main_bench_mesh_import.cpp"
+#include "main_bench_culling.cpp"
+#include "main_bench_jobs.cpp"
 
-int main(int, char**) {
+int main(int argc, char** argv) {
 
-    // Instructions: comment in/out the entry points below to swap apps
-    // main_app(0, nullptr); 
+    // Instructions: comment in/out the entry points below to swap apps.
+    // main_app, main_demo and main_draggable5 take --headless [--frames N] [--size WxH]
+    // [--context native|egl|osmesa] to run a fixed number of offscreen frames and print frame times,
+    // and main_app and main_draggable5 take --record FILE / --replay FILE for their input.
+    // main_app takes --remote ADDRESS to be shown and driven from dear-imgui-viewer.
+    // main_app(argc, argv);
     // main_app_crtp(0, nullptr);
 
-    // main_demo::main(0, nullptr);
+    // main_demo::main(argc, argv);
     // main_triangle::main(0, nullptr);
     // main_draggable::main();
     // main_draggable2::main();
     // main_draggable3::main();
     // main_draggable4::main();
-    main_draggable5::main();
+    main_draggable5::main(argc, argv);
+
+    // Benchmarks
+    // main_bench_mesh_import::main();
+    // main_bench_culling::main();
+    // main_bench_jobs::main();
 
     return 0;
 }
\ No newline at end of file
@@ -1,15 +1,70 @@
 #include "app.hpp"
+#include "telemetry_plot.h"
+#include "gpu_line_plot.h"
+#include "columnar_table.h"
+#include "job_system.h"
+#include "log_viewer.h"
+#include "text_search.h"
+#include "texture_manager.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
 class MyApp : public App
 {
 public:
-    MyApp() {};
-    ~MyApp() {};
+    MyApp(const HeadlessOptions &headless, const InputRecordingOptions &input) : App(headless, input) {};
+    ~MyApp()
+    {
+        producing = false;
+        if (producer.joinable())
+            producer.join();
+        gpu_plot.shutdown();
+        textures.shutdown();
+    };
 
     virtual void Startup() final
     {
+        threaded_rendering = true;
+
+        // A million rows to sort and filter; the table does both on the job system
+        jobs.init();
+        TableColumn &ids = table.addColumn("id", ColumnType::Int64);
+        TableColumn &values = table.addColumn("value", ColumnType::Double);
+        TableColumn &names = table.addColumn("name", ColumnType::String);
+        char name[32];
+        for (uint32_t i = 0; i < 1000000; i++)
+        {
+            uint32_t hash = i * 2654435761u;
+            ids.push((int64_t)i);
+            values.push((double)(hash % 1000000) * 1e-3);
+            names.push(name, (size_t)snprintf(name, sizeof(name), "item %u", hash % 100000));
+        }
+
+        // Stand-in for a telemetry source: a noisy sine at a million samples per second,
+        // pushed from its own thread without ever waiting on the UI
+        producer = std::thread([this]() {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t n = 0;
+            uint32_t noise = 1;
+            while (producing.load(std::memory_order_relaxed))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                uint64_t due = (uint64_t)(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6);
+                for (; n < due; n++)
+                {
+                    noise = noise * 1664525u + 1013904223u;
+                    float sample = (float)std::sin(n * 2e-5) + (float)(noise >> 8) * (0.2f / 16777216.0f);
+                    telemetry.input().push(sample);
+                    gpu_plot.input().push(sample);
+                }
+            }
+        });
     }
     virtual void Update() final
     {
+        textures.newFrame();
 
         // TODO(jh): figure out how to assign this to a class field
         // Setup Dear ImGui context
@@ -32,6 +87,7 @@ public:
             ImGui::Text("This is some useful text.");          // Display some text (you can use a format strings too)
             ImGui::Checkbox("Demo Window", &show_demo_window); // Edit bools storing our window open/close state
             ImGui::Checkbox("Another Window", &show_another_window);
+            ImGui::Checkbox("Capture", &show_capture);
 
             ImGui::SliderFloat("float", &f, 0.0f, 1.0f);             // Edit 1 float using a slider from 0.0f to 1.0f
             ImGui::ColorEdit3("clear color", (float *)&clear_color); // Edit 3 floats representing a color
@@ -55,16 +111,112 @@ public:
                 show_another_window = false;
             ImGui::End();
         }
+
+        // 4. Live telemetry, 2^24 samples of history: min/max bars built on the CPU, and the same
+        // signal as a line the GPU draws from its own copy of the samples
+        telemetry.update();
+        ImGui::SetNextWindowSize(ImVec2(600.0f, 400.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Telemetry");
+        telemetry.draw("Signal", ImVec2(0.0f, 150.0f));
+        gpu_plot.draw("Signal (GPU lines)", ImVec2(0.0f, -1.0f));
+        ImGui::End();
+
+        // 5. A million-row table: click headers to sort (shift-click for more keys), type to filter
+        ImGui::SetNextWindowSize(ImVec2(600.0f, 400.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Table");
+        table.draw("Rows");
+        ImGui::End();
+
+        // 6. Any log file, however large: mapped, indexed in the background, followed as it grows,
+        // and searched on every core with the hits listed as they are found
+        ImGui::SetNextWindowSize(ImVec2(700.0f, 500.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Log");
+        ImGui::SetNextItemWidth(-80.0f);
+        bool open_log = ImGui::InputText("##path", log_path, sizeof(log_path), ImGuiInputTextFlags_EnterReturnsTrue);
+        ImGui::SameLine();
+        if (ImGui::Button("Open") || open_log)
+        {
+            log_viewer.open(log_path);
+            // the hits were for the previous file; look for the same query in this one
+            log_search.restart(log_viewer.file());
+        }
+        log_viewer.draw("Lines", ImVec2(0.0f, -160.0f));
+        SearchHit hit;
+        if (log_search.draw("Search", log_viewer.file(), hit))
+            log_viewer.scrollToOffset(hit.offset);
+        ImGui::End();
+
+        // 7. Every image in a folder as thumbnails: only the visible rows load, textures that
+        // scrolled away are evicted once the budget is reached
+        ImGui::SetNextWindowSize(ImVec2(600.0f, 500.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Gallery");
+        ImGui::SetNextItemWidth(-80.0f);
+        bool open_folder = ImGui::InputText("##folder", gallery_folder, sizeof(gallery_folder), ImGuiInputTextFlags_EnterReturnsTrue);
+        ImGui::SameLine();
+        if (ImGui::Button("List") || open_folder)
+        {
+            gallery.clear();
+            std::error_code error;
+            for (const auto &file : std::filesystem::directory_iterator(gallery_folder, error))
+            {
+                std::string extension = file.path().extension().string();
+                std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+                if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" || extension == ".tga" || extension == ".gif")
+                    gallery.push_back(file.path().string());
+            }
+            std::sort(gallery.begin(), gallery.end());
+        }
+        TextureManager::Stats texture_stats = textures.stats();
+        ImGui::Text("%zu images, %zu resident (%.1f MB), %zu loading, %llu evicted", gallery.size(), texture_stats.resident_count,
+                    texture_stats.resident_bytes / (1024.0 * 1024.0), texture_stats.queued + texture_stats.in_flight, (unsigned long long)texture_stats.evictions);
+        ImGui::BeginChild("##thumbnails");
+        const float thumbnail = 128.0f;
+        int columns = std::max(1, (int)(ImGui::GetContentRegionAvail().x / (thumbnail + ImGui::GetStyle().ItemSpacing.x)));
+        ImGuiListClipper clipper;
+        clipper.Begin((int)(gallery.size() + columns - 1) / columns, thumbnail + ImGui::GetStyle().ItemSpacing.y);
+        while (clipper.Step())
+        {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+            {
+                for (int column = 0; column < columns && row * columns + column < (int)gallery.size(); column++)
+                {
+                    if (column > 0)
+                        ImGui::SameLine();
+                    textures.image(gallery[row * columns + column], ImVec2(thumbnail, thumbnail));
+                }
+            }
+        }
+        ImGui::EndChild();
+        ImGui::End();
     }
 
 private:
     bool show_demo_window = true;
     bool show_another_window = false;
+    TelemetryPlot telemetry{1 << 24};
+    GpuLinePlot gpu_plot{1 << 24};
+    std::atomic<bool> producing{true};
+    std::thread producer;
+    JobSystem jobs;
+    ColumnarTable table{jobs};
+    LogViewer log_viewer;
+    TextSearch log_search{jobs};
+    TextureManager textures{jobs};
+    std::vector<std::string> gallery;
+    char gallery_folder[512] = ".";
+    char log_path[512] = "imgui.log";
 };
 
-int main_app(int, char **)
+int main_app(int argc, char **argv)
 {
-    MyApp myApp;
+    HeadlessOptions headless;
+    InputRecordingOptions input;
+    RemoteOptions remote;
+    if (!parseHeadlessOptions(argc, argv, headless) || !parseInputRecordingOptions(argc, argv, input) || !parseRemoteOptions(argc, argv, remote))
+        return 1;
+    MyApp myApp(headless, input);
+    if (!remote.listen_address.empty() && !myApp.ServeRemote(remote.listen_address))
+        return 1;
     myApp.Run();
 
     return 0;
@@ -0,0 +1,52 @@
+#include "frustum_culling.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace main_bench_culling
+{
+    // Times scalar and AVX frustum culling of randomly scattered boxes
+    int main(std::vector<size_t> box_counts = { 100000, 1000000 })
+    {
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum = Frustum::fromMatrix(projection * view);
+        const int iterations = 20;
+
+        printf("AVX path: %s\n", cullingUsesAvx() ? "yes" : "no");
+        printf("%10s %10s %12s %12s %8s\n", "boxes", "visible", "scalar ms", "dispatch ms", "speedup");
+        for (size_t count : box_counts)
+        {
+            std::mt19937 rng(1234);
+            std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+            std::uniform_real_distribution<float> size(0.1f, 2.0f);
+            BoundsSoA bounds;
+            bounds.resize(count);
+            for (size_t i = 0; i < count; i++)
+                bounds.set(i, glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(size(rng), size(rng), size(rng)));
+            std::vector<uint32_t> visible(count);
+
+            auto time = [&](auto cull) {
+                size_t result = 0;
+                auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterations; i++)
+                    result = cull();
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+                return std::make_pair(result, ms);
+            };
+            auto scalar = time([&] { return cullBoxesScalar(frustum, bounds, visible.data(), 0, count); });
+            auto dispatch = time([&] { return cullBoxes(frustum, bounds, visible.data()); });
+            if (scalar.first != dispatch.first)
+            {
+                fprintf(stderr, "Visible count mismatch: %zu vs %zu\n", scalar.first, dispatch.first);
+                return 1;
+            }
+            printf("%10zu %10zu %12.3f %12.3f %8.2f\n", count, dispatch.first, scalar.second, dispatch.second, scalar.second / dispatch.second);
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,101 @@
+#include "job_system.h"
+#include "scene_graph.h"
+#include "frustum_culling.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace main_bench_jobs
+{
+    // Root with node_count children, either directly (flat) or spread under group_count groups
+    SceneNode build_scene(SceneGraph &scene, size_t node_count, size_t group_count, std::vector<SceneNode> &leaves)
+    {
+        scene.clear();
+        leaves.clear();
+        SceneNode root = scene.create();
+        std::vector<SceneNode> groups;
+        for (size_t g = 0; g < group_count; g++)
+            groups.push_back(scene.create(root));
+        for (size_t i = 0; i < node_count; i++)
+        {
+            SceneNode leaf = scene.create(group_count ? groups[i % group_count] : root);
+            scene.setTranslation(leaf, glm::vec3((float)(i % 1000), (float)(i / 1000 % 1000), (float)(i / 1000000)) * 1.5f);
+            scene.setRotation(leaf, glm::vec3((float)(i % 360), 0.0f, 0.0f));
+            leaves.push_back(leaf);
+        }
+        scene.update();
+        return root;
+    }
+
+    template <typename F>
+    double time_ms(int iterations, F &&f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+            f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+
+    // Full transform update, culling and instance fill at 1/2/4/8/16 threads
+    int main(std::vector<size_t> node_counts = { 100000, 1000000 })
+    {
+        const unsigned int thread_counts[] = { 1, 2, 4, 8, 16 };
+        const int iterations = 10;
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 2000.0f);
+        glm::mat4 view = glm::lookAt(glm::vec3(500.0f, 75.0f, -100.0f), glm::vec3(500.0f, 75.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum = Frustum::fromMatrix(projection * view);
+
+        printf("%10s %8s %8s %12s %10s %10s %8s\n", "nodes", "shape", "threads", "transform ms", "cull ms", "fill ms", "speedup");
+        for (size_t nodes : node_counts)
+        {
+            for (size_t groups : { (size_t)0, (size_t)1000 })
+            {
+                SceneGraph scene;
+                std::vector<SceneNode> leaves;
+                SceneNode root = build_scene(scene, nodes, groups, leaves);
+                BoundsSoA bounds;
+                bounds.resize(leaves.size());
+                std::vector<uint32_t> visible(leaves.size());
+                std::vector<glm::mat4> instances(leaves.size());
+
+                double single_thread_ms = 0.0;
+                for (unsigned int threads : thread_counts)
+                {
+                    JobSystem jobs;
+                    jobs.init(threads);
+
+                    // nudging the root dirties every node below it
+                    float offset = 0.0f;
+                    double transform_ms = time_ms(iterations, [&] {
+                        scene.setTranslation(root, glm::vec3(0.0f, 0.0f, offset += 0.001f));
+                        scene.update(&jobs);
+                    });
+                    jobs.parallelFor(leaves.size(), 4096, [&](size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; i++)
+                            bounds.setTransformedBox(i, scene.world(leaves[i]), glm::vec3(0.0f), glm::vec3(0.5f));
+                    });
+
+                    size_t visible_count = 0;
+                    double cull_ms = time_ms(iterations, [&] { visible_count = cullBoxes(frustum, bounds, visible.data(), jobs); });
+                    double fill_ms = time_ms(iterations, [&] {
+                        jobs.parallelFor(visible_count, 4096, [&](size_t begin, size_t end) {
+                            for (size_t i = begin; i < end; i++)
+                                instances[i] = scene.world(leaves[visible[i]]);
+                        });
+                    });
+
+                    double total_ms = transform_ms + cull_ms + fill_ms;
+                    if (threads == 1)
+                        single_thread_ms = total_ms;
+                    printf("%10zu %8s %8u %12.2f %10.2f %10.2f %8.2f\n", nodes, groups ? "grouped" : "flat", threads,
+                           transform_ms, cull_ms, fill_ms, single_thread_ms / total_ms);
+                }
+            }
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,116 @@
+#include "mesh_importer.h"
+
+#include <chrono>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace main_bench_mesh_import
+{
+    // Writes a wavy grid with per-vertex normals as an OBJ with (at least) face_count triangles
+    bool write_grid_obj(const std::string &filename, size_t face_count)
+    {
+        size_t n = (size_t)std::ceil(std::sqrt(face_count / 2.0));
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        std::vector<char> buffer;
+        buffer.reserve(1 << 20);
+        char number[32];
+        auto append_float = [&](float value) {
+            auto result = std::to_chars(number, number + sizeof(number), value);
+            buffer.insert(buffer.end(), number, result.ptr);
+        };
+        auto append_int = [&](size_t value) {
+            auto result = std::to_chars(number, number + sizeof(number), value);
+            buffer.insert(buffer.end(), number, result.ptr);
+        };
+        auto flush = [&](bool force) {
+            if (force || buffer.size() > (1 << 20) - 256)
+            {
+                file.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        };
+
+        for (size_t y = 0; y <= n; y++)
+        {
+            for (size_t x = 0; x <= n; x++)
+            {
+                float fx = (float)x / n, fy = (float)y / n;
+                float h = 0.05f * std::sin(fx * 40.0f) * std::cos(fy * 40.0f);
+                buffer.insert(buffer.end(), { 'v', ' ' });
+                append_float(fx); buffer.push_back(' ');
+                append_float(fy); buffer.push_back(' ');
+                append_float(h); buffer.push_back('\n');
+                buffer.insert(buffer.end(), { 'v', 'n', ' ' });
+                append_float(-2.0f * std::cos(fx * 40.0f) * std::cos(fy * 40.0f)); buffer.push_back(' ');
+                append_float(2.0f * std::sin(fx * 40.0f) * std::sin(fy * 40.0f)); buffer.insert(buffer.end(), { ' ', '1', '\n' });
+                flush(false);
+            }
+        }
+
+        auto append_corner = [&](size_t index) {
+            buffer.push_back(' ');
+            append_int(index);
+            buffer.insert(buffer.end(), { '/', '/' });
+            append_int(index);
+        };
+        for (size_t y = 0; y < n; y++)
+        {
+            for (size_t x = 0; x < n; x++)
+            {
+                size_t i = y * (n + 1) + x + 1;
+                buffer.push_back('f'); append_corner(i); append_corner(i + 1); append_corner(i + n + 2); buffer.push_back('\n');
+                buffer.push_back('f'); append_corner(i); append_corner(i + n + 2); append_corner(i + n + 1); buffer.push_back('\n');
+                flush(false);
+            }
+        }
+        flush(true);
+        return (bool)file;
+    }
+
+    // Times importObj on generated meshes at 1, 2, 4, ... hardware threads
+    int main(std::vector<size_t> face_counts = { 1000000, 10000000, 50000000 })
+    {
+        unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned int> thread_counts;
+        for (unsigned int threads = 1; threads < max_threads; threads *= 2)
+            thread_counts.push_back(threads);
+        thread_counts.push_back(max_threads);
+        std::string filename = (std::filesystem::temp_directory_path() / "bench_mesh_import.obj").string();
+
+        printf("%12s %8s %10s %10s %8s\n", "faces", "threads", "ms", "MB/s", "speedup");
+        for (size_t faces : face_counts)
+        {
+            if (!write_grid_obj(filename, faces))
+            {
+                fprintf(stderr, "Failed to write %s\n", filename.c_str());
+                return 1;
+            }
+            double megabytes = std::filesystem::file_size(filename) / (1024.0 * 1024.0);
+
+            double single_thread_ms = 0.0;
+            for (unsigned int threads : thread_counts)
+            {
+                MeshData mesh;
+                auto start = std::chrono::steady_clock::now();
+                if (!importObj(filename, mesh, threads))
+                    return 1;
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                if (threads == 1)
+                    single_thread_ms = ms;
+                printf("%12zu %8u %10.1f %10.1f %8.2f\n", mesh.indices.size() / 3, threads, ms, megabytes / (ms / 1000.0), single_thread_ms / ms);
+            }
+        }
+
+        std::filesystem::remove(filename);
+        return 0;
+    }
+}
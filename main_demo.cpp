@@ -6,7 +6,9 @@
 #include "imgui.h"
 #include "bindings/imgui_impl_glfw.h"
 #include "bindings/imgui_impl_opengl3.h"
+#include "headless.h"
 #include <stdio.h>
+#include <chrono>
 #define GL_SILENCE_DEPRECATION
 #if defined(IMGUI_IMPL_OPENGL_ES2)
 #include <GLES2/gl2.h>
@@ -35,8 +37,12 @@ static void glfw_error_callback1(int error, const char* description)
 }
 
 // Main code
-int main(int, char**)
+int main(int argc, char** argv)
 {
+    HeadlessOptions headless;
+    if (!parseHeadlessOptions(argc, argv, headless))
+        return 1;
+
     glfwSetErrorCallback(glfw_error_callback1);
     if (!glfwInit())
         return 1;
@@ -65,16 +71,26 @@ int main(int, char**)
 #endif
 
     // Create window with graphics context
-    GLFWwindow* window = glfwCreateWindow(1280, 720, "Dear ImGui GLFW+OpenGL3 example", NULL, NULL);
+    applyHeadlessWindowHints(headless);
+    int width = headless.enabled ? headless.width : 1280;
+    int height = headless.enabled ? headless.height : 720;
+    GLFWwindow* window = glfwCreateWindow(width, height, "Dear ImGui GLFW+OpenGL3 example", NULL, NULL);
     if (window == NULL)
         return 1;
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(1); // Enable vsync
+    glfwSwapInterval(headless.enabled ? 0 : 1); // Enable vsync, unless running as fast as possible
+
+    // Headless: hidden window, render into an offscreen framebuffer
+    OffscreenTarget offscreen;
+    if (headless.enabled && (!initGlew() || !offscreen.create(width, height)))
+        return 1;
 
     // Setup ImGui context
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
+    if (headless.enabled)
+        io.IniFilename = NULL;
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
 
@@ -107,6 +123,9 @@ int main(int, char**)
     bool show_demo_window = true;
     bool show_another_window = false;
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
+    FrameTimeStats frame_times;
+    frame_times.reserve(headless.frames);
+    auto run_start = std::chrono::steady_clock::now();
 
     // Main loop
 #ifdef __EMSCRIPTEN__
@@ -115,9 +134,11 @@ int main(int, char**)
     io.IniFilename = NULL;
     EMSCRIPTEN_MAINLOOP_BEGIN
 #else
-    while (!glfwWindowShouldClose(window))
+    while (headless.enabled ? frame_times.frames() < (size_t)headless.frames : !glfwWindowShouldClose(window))
 #endif
     {
+        auto frame_start = std::chrono::steady_clock::now();
+
         // Poll and handle events (inputs, window resize, etc.)
         // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
         // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application, or clear/overwrite your copy of the mouse data.
@@ -171,18 +192,29 @@ int main(int, char**)
         ImGui::Render();
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
+        if (headless.enabled)
+            offscreen.bind();
         glViewport(0, 0, display_w, display_h);
         glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
+        if (headless.enabled)
+            frame_times.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
     }
 #ifdef __EMSCRIPTEN__
     EMSCRIPTEN_MAINLOOP_END;
 #endif
 
+    if (headless.enabled)
+    {
+        glFinish();
+        frame_times.print(stdout, "main_demo", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run_start).count());
+    }
+
     // Cleanup
+    offscreen.destroy();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -146,6 +146,8 @@ namespace main_draggable
         glfwSwapInterval(1); // Enable vsync
 
         // Initialize GLEW (must be called after making the context current)
+        // core profile: without this GLEW leaves entry points like glGenVertexArrays null
+        glewExperimental = GL_TRUE;
         if (glewInit() != GLEW_OK)
         {
             std::cerr << "GLEW initialization failed!" << std::endl;
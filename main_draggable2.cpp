@@ -1,25 +1,35 @@
+#include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "dynamic_batch.h"
+#include "frame_arena.h"
+
 namespace main_draggable2
 {
     float objectX = 0.0f, objectY = 0.0f; // Object position
     float delta = 0.9f;
     bool isDragging = false;
 
-    // Vertex data for the quad
+    // Vertex data for the quad (model space, positioned by mvpMatrix)
     std::vector<glm::vec3> quadVertices = {
         glm::vec3(-0.1f, -0.1f, 0.0f),
         glm::vec3(0.1f, -0.1f, 0.0f),
         glm::vec3(0.1f, 0.1f, 0.0f),
         glm::vec3(-0.1f, 0.1f, 0.0f)};
 
-    // MVP matrix (identity for simplicity)
+    // MVP matrix (just the object translation for simplicity)
     glm::mat4 mvpMatrix = glm::mat4(1.0f);
 
+    DynamicBatch batch;
+
+    // Per-frame temporaries (hit testing) live here; reset at the top of every frame
+    FrameArena frameArena;
+    FrameArenaResource frameMemory(frameArena);
+
     // Project a 3D point into 2D screen coordinates using the MVP matrix
     glm::vec2 project_to_ndc(const glm::vec3 &vertex, const glm::mat4 &mvpMatrix)
     {
@@ -32,7 +42,8 @@ namespace main_draggable2
     bool is_point_inside_3d_object(double xpos, double ypos, const std::vector<glm::vec3> &vertices, const glm::mat4 &mvpMatrix)
     {
         // Project all vertices to NDC
-        std::vector<glm::vec2> projectedVertices;
+        std::pmr::vector<glm::vec2> projectedVertices(&frameMemory);
+        projectedVertices.reserve(vertices.size());
         for (const auto &vertex : vertices)
         {
             projectedVertices.push_back(project_to_ndc(vertex, mvpMatrix));
@@ -102,6 +113,12 @@ namespace main_draggable2
         if (!glfwInit())
             return -1;
 
+        // GL 3.2 core, the batch renders with shaders instead of glBegin/glEnd
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); // 3.2+ only
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);           // Required on Mac
+
         GLFWwindow *window = glfwCreateWindow(800, 600, "Drag and Drop", NULL, NULL);
         if (!window)
         {
@@ -110,33 +127,40 @@ namespace main_draggable2
         }
         glfwMakeContextCurrent(window);
 
+        // core profile: without this GLEW leaves entry points like glGenVertexArrays null
+        glewExperimental = GL_TRUE;
+        if (glewInit() != GLEW_OK)
+        {
+            glfwTerminate();
+            return -1;
+        }
+
+        batch.init();
+
         // Set callbacks
         glfwSetMouseButtonCallback(window, mouseButtonCallback);
         glfwSetCursorPosCallback(window, cursorPosCallback);
 
         while (!glfwWindowShouldClose(window))
         {
+            frameArena.reset();
             glClear(GL_COLOR_BUFFER_BIT);
 
-            // Update quad vertices based on object position
-            quadVertices = {
-                glm::vec3(objectX - 0.1f, objectY - 0.1f, 0.0f),
-                glm::vec3(objectX + 0.1f, objectY - 0.1f, 0.0f),
-                glm::vec3(objectX + 0.1f, objectY + 0.1f, 0.0f),
-                glm::vec3(objectX - 0.1f, objectY + 0.1f, 0.0f)};
+            // Move the object by its transform, the quad vertices stay untouched
+            mvpMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(objectX, objectY, 0.0f));
 
             // Render the object
-            glBegin(GL_QUADS);
-            for (const auto &vertex : quadVertices)
-            {
-                glVertex3f(vertex.x, vertex.y, vertex.z);
-            }
-            glEnd();
+            batch.begin(glm::mat4(1.0f));
+            uint32_t transform = batch.pushTransform(mvpMatrix);
+            batch.addQuad(quadVertices[0], quadVertices[1], quadVertices[2], quadVertices[3], glm::vec4(1.0f), transform);
+            batch.end();
 
             glfwSwapBuffers(window);
             glfwPollEvents();
         }
 
+        batch.shutdown();
+
         glfwDestroyWindow(window);
         glfwTerminate();
         return 0;
@@ -1,3 +1,4 @@
+#include <GL/glew.h>
 #include <GLFW/glfw3.h> // Will drag system OpenGL headers
 
 #include <vector>
@@ -8,6 +9,8 @@
 #include "imgui.h"
 #include "bindings/imgui_impl_glfw.h"
 #include "bindings/imgui_impl_opengl3.h"
+#include "dynamic_batch.h"
+#include "frame_arena.h"
 
 namespace main_draggable3
 {
@@ -20,6 +23,15 @@ namespace main_draggable3
     float objectX = 0.0f, objectY = 0.0f; // Object position
     bool isDragging = false;
 
+    // Extra handles drawn in a grid around the quad, all in the same draw call
+    int handleCount = 0;
+
+    DynamicBatch batch;
+
+    // Per-frame temporaries (hit testing) live here; reset at the top of every frame
+    FrameArena frameArena;
+    FrameArenaResource frameMemory(frameArena);
+
     // Vertex data for the quad
     std::vector<glm::vec3> quadVertices = {
         glm::vec3(-0.1f, -0.1f, 0.0f),
@@ -42,7 +54,8 @@ namespace main_draggable3
     bool is_point_inside_3d_object(double xpos, double ypos, const std::vector<glm::vec3> &vertices, const glm::mat4 &mvpMatrix)
     {
         // Project all vertices to NDC
-        std::vector<glm::vec2> projectedVertices;
+        std::pmr::vector<glm::vec2> projectedVertices(&frameMemory);
+        projectedVertices.reserve(vertices.size());
         for (const auto &vertex : vertices)
         {
             projectedVertices.push_back(project_to_ndc(vertex, mvpMatrix));
@@ -116,15 +129,19 @@ namespace main_draggable3
         model = glm::translate(model, translation);
         model = glm::scale(model, scale);
 
-        glColor4f(color.r, color.g, color.b, color.a);
+        // the vertex shader applies the model matrix, the vertices are submitted as-is
+        batch.begin(glm::mat4(1.0f));
+        uint32_t transform = batch.pushTransform(model);
+        batch.addQuad(quadVertices[0], quadVertices[1], quadVertices[2], quadVertices[3], color, transform);
 
-        glBegin(GL_QUADS);
-        for (const auto &vertex : quadVertices)
+        int columns = 64;
+        for (int i = 0; i < handleCount; i++)
         {
-            glm::vec4 transformedVertex = model * glm::vec4(vertex, 1.0f);
-            glVertex3f(transformedVertex.x, transformedVertex.y, transformedVertex.z);
+            glm::vec3 offset(-0.95f + 0.03f * (i % columns), -0.95f + 0.03f * (i / columns), 0.0f);
+            uint32_t handle = batch.pushTransform(glm::scale(glm::translate(glm::mat4(1.0f), offset), glm::vec3(0.1f)));
+            batch.addQuad(quadVertices[0], quadVertices[1], quadVertices[2], quadVertices[3], glm::vec4(1.0f, 0.6f, 0.0f, 1.0f), handle);
         }
-        glEnd();
+        batch.end();
     }
 
     int main()
@@ -150,6 +167,16 @@ namespace main_draggable3
         }
         glfwMakeContextCurrent(window);
 
+        // core profile: without this GLEW leaves entry points like glGenVertexArrays null
+        glewExperimental = GL_TRUE;
+        if (glewInit() != GLEW_OK)
+        {
+            glfwTerminate();
+            return -1;
+        }
+
+        batch.init();
+
         // Initialize ImGui
         IMGUI_CHECKVERSION();
         ImGui::CreateContext();
@@ -164,6 +191,7 @@ namespace main_draggable3
 
         while (!glfwWindowShouldClose(window))
         {
+            frameArena.reset();
             // Start new ImGui frame
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
@@ -175,6 +203,8 @@ namespace main_draggable3
             ImGui::SliderFloat3("Rotation", &rotation.x, 0.0f, 360.0f);
             ImGui::SliderFloat3("Scale", &scale.x, 0.1f, 3.0f);
             // ImGui::ColorEdit4("Color", &color.r);
+            ImGui::SliderInt("Handles", &handleCount, 0, 4096);
+            ImGui::Text("Batched vertices: %d", (int)batch.vertexCount());
             ImGui::End();
 
             // Clear and render
@@ -194,6 +224,8 @@ namespace main_draggable3
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
 
+        batch.shutdown();
+
         glfwDestroyWindow(window);
         glfwTerminate();
         return 0;
@@ -5,6 +5,7 @@
 #include "imgui.h"
 #include "bindings/imgui_impl_glfw.h"
 #include "bindings/imgui_impl_opengl3.h"
+#include "mesh_file.h"
 #include <iostream>
 #include <vector>
 #include <fstream>
@@ -13,15 +14,6 @@
 namespace main_draggable4
 {
 
-    // Vertex and index data for a cuboid
-    std::vector<float> vertices = {
-        -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f,
-        -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, 0.5f, 0.5f};
-    std::vector<unsigned int> indices = {
-        0, 1, 2, 2, 3, 0, 4, 5, 6, 6, 7, 4,
-        4, 5, 1, 1, 0, 4, 3, 2, 6, 6, 7, 3,
-        4, 0, 3, 3, 7, 4, 1, 5, 6, 6, 2, 1};
-
     // Controls
     glm::vec3 translation(0.0f, 0.0f, 0.0f);
     glm::vec3 rotation(0.0f, 0.0f, 0.0f);
@@ -139,6 +131,8 @@ namespace main_draggable4
         glfwMakeContextCurrent(window);
 
         // Initialize GLEW
+        // core profile: without this GLEW leaves entry points like glGenVertexArrays null
+        glewExperimental = GL_TRUE;
         if (glewInit() != GLEW_OK)
         {
             std::cerr << "Failed to initialize GLEW\n";
@@ -161,21 +155,13 @@ namespace main_draggable4
         if (!shaderProgram)
             return -1;
 
-        // OpenGL Buffers
-        GLuint VAO, VBO, EBO;
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-        glEnableVertexAttribArray(0);
+        // Shared with main_draggable5; this shader only reads the positions
+        GpuMesh mesh;
+        if (!loadMesh("cuboid.obj", "cuboid.mesh", mesh))
+        {
+            std::cerr << "Failed to load cuboid mesh\n";
+            return -1;
+        }
 
         while (!glfwWindowShouldClose(window))
         {
@@ -216,6 +202,7 @@ namespace main_draggable4
             model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
             model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
             model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+            model = model * mesh.dequantization;
 
             glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
             glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
@@ -237,8 +224,7 @@ namespace main_draggable4
             glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
             glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
 
-            glBindVertexArray(VAO);
-            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+            mesh.draw();
 
             // Render ImGui
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -250,9 +236,7 @@ namespace main_draggable4
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
 
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        mesh.destroy();
 
         glfwDestroyWindow(window);
         glfwTerminate();
@@ -5,6 +5,17 @@
 #include "imgui.h"
 #include "bindings/imgui_impl_glfw.h"
 #include "bindings/imgui_impl_opengl3.h"
+#include "mesh_file.h"
+#include "frustum_culling.h"
+#include "scene_graph.h"
+#include "job_system.h"
+#include "memory_telemetry.h"
+#include "size_class_pool.h"
+#include "headless.h"
+#include "input_recorder.h"
+#include "imgui_indirect_renderer.h"
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <vector>
 #include <fstream>
@@ -13,53 +24,24 @@
 namespace main_draggable5
 {
 
-    // Vertex and index data for a cuboid
-    std::vector<float> vertices = {
-    // Positions          // Normals
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, // Back face
-     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
-
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f, // Front face
-     0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-
-    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, // Left face
-    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
-    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
-
-     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, // Right face
-     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
-     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
-
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, // Bottom face
-     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
-     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
-
-    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, // Top face
-     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
-     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f
-};
-
-std::vector<unsigned int> indices = {
-    0, 1, 2, 2, 3, 0,       // Back face
-    4, 5, 6, 6, 7, 4,       // Front face
-    8, 9, 10, 10, 11, 8,    // Left face
-    12, 13, 14, 14, 15, 12, // Right face
-    16, 17, 18, 18, 19, 16, // Bottom face
-    20, 21, 22, 22, 23, 20  // Top face
-};
-
     // Controls
     glm::vec3 translation(0.0f, 0.0f, 0.0f);
     glm::vec3 rotation(0.0f, 0.0f, 0.0f);
 
+    // Scene: a grid of cuboids that all hang off the transform above
+    int objectCount = 1;
+    float objectSpacing = 1.5f;
+    int spinningObjects = 0;
+
+    // Orbit camera
+    float cameraDistance = 3.0f;
+    float cameraYaw = 0.0f;
+    float cameraPitch = 0.0f;
+
+    // ImGui allocates from here, counted under the ImGui memory tag
+    SizeClassPool imguiPool;
+    bool showMemory = true;
+
     // Light properties
     glm::vec3 lightDir(-0.2f, -1.0f, -0.3f); // Directional light direction
     glm::vec3 lightColor(1.0f, 1.0f, 1.0f); // Light color
@@ -135,23 +117,40 @@ std::vector<unsigned int> indices = {
                       << infoLog << std::endl;
             glDeleteShader(vertexShader);
             glDeleteShader(fragmentShader);
+            glDeleteProgram(program);
             return 0;
         }
 
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
+        trackProgram(program, vertexPath.c_str());
 
         return program;
     }
 
+    // Offset of object index in the smallest cube-shaped grid holding count objects, centered on the origin
+    glm::vec3 GridOffset(int index, int count)
+    {
+        int side = std::max(1, (int)std::cbrt((double)count));
+        while (side * side * side < count)
+            side++;
+        glm::vec3 cell((float)(index % side), (float)(index / side % side), (float)(index / (side * side)));
+        return (cell - glm::vec3((side - 1) * 0.5f)) * objectSpacing;
+    }
+
     // Window resize callback
     void framebuffer_size_callback(GLFWwindow *window, int width, int height)
     {
         glViewport(0, 0, width, height);
     }
 
-    int main()
+    int main(int argc, char **argv)
     {
+        HeadlessOptions headless;
+        InputRecordingOptions inputOptions;
+        if (!parseHeadlessOptions(argc, argv, headless) || !parseInputRecordingOptions(argc, argv, inputOptions))
+            return -1;
+
         // Initialize GLFW and OpenGL
         if (!glfwInit())
         {
@@ -160,14 +159,17 @@ std::vector<unsigned int> indices = {
         }
 
         // Decide GL+GLSL versions
-        // GL 3.2 + GLSL 150
-        const char *glsl_version = "#version 150";
+        // GL 3.3 + GLSL 330: the cuboid shaders use layout(location) and the normals GL_INT_2_10_10_10_REV
+        const char *glsl_version = "#version 330";
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); // 3.2+ only
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);           // Required on Mac
 
-        GLFWwindow *window = glfwCreateWindow(800, 600, "Cuboid App", nullptr, nullptr);
+        applyHeadlessWindowHints(headless);
+        int width = headless.enabled ? headless.width : 800;
+        int height = headless.enabled ? headless.height : 600;
+        GLFWwindow *window = glfwCreateWindow(width, height, "Cuboid App", nullptr, nullptr);
         if (!window)
         {
             std::cerr << "Failed to create GLFW window\n";
@@ -175,11 +177,20 @@ std::vector<unsigned int> indices = {
             return -1;
         }
         glfwMakeContextCurrent(window);
+        if (headless.enabled)
+            glfwSwapInterval(0);
 
         // Initialize GLEW
-        if (glewInit() != GLEW_OK)
+        if (!initGlew())
+        {
+            glfwTerminate();
+            return -1;
+        }
+
+        // Headless: hidden window, render into an offscreen framebuffer
+        OffscreenTarget offscreen;
+        if (headless.enabled && !offscreen.create(width, height))
         {
-            std::cerr << "Failed to initialize GLEW\n";
             glfwTerminate();
             return -1;
         }
@@ -191,45 +202,79 @@ std::vector<unsigned int> indices = {
 
         // Set up ImGui
         IMGUI_CHECKVERSION();
+        ImGui::SetAllocatorFunctions(&MemoryTelemetry::imguiAlloc, &MemoryTelemetry::imguiFree, &imguiPool);
         ImGui::CreateContext();
+        if (headless.enabled)
+            ImGui::GetIO().IniFilename = nullptr;
         ImGui_ImplGlfw_InitForOpenGL(window, true);
         ImGui_ImplOpenGL3_Init("#version 330");
 
+        // --record / --replay: drags and scrolls captured here replay identically, also headless
+        InputRecorder inputRecorder;
+        if (!inputRecorder.start(window, inputOptions))
+            return -1;
+        ImGui_ImplOpenGL3_CreateDeviceObjects();
+        trackImGuiFontTexture();
+        ImGuiIndirectRenderer imguiRenderer;
+        imguiRenderer.init();
+
         // Swap these to try different lighting fragment shaders
-        GLuint shaderProgram = CreateShaderProgram("vertex-shader-1.glsl", "fragment-shader-1.glsl");
-        // GLuint shaderProgram = CreateShaderProgram("vertex-shader-1.glsl", "fragment-shader-2.glsl");
+        GLuint shaderProgram = CreateShaderProgram("vertex-shader-instanced.glsl", "fragment-shader-1.glsl");
+        // GLuint shaderProgram = CreateShaderProgram("vertex-shader-instanced.glsl", "fragment-shader-2.glsl");
         
         if (!shaderProgram)
             return -1;
 
-        // OpenGL Buffers
-        GLuint VAO, VBO, EBO;
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        // Vertex positions
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
-        glEnableVertexAttribArray(0);
-
-        // Vertex normals
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
+        // The cuboid is converted once from cuboid.obj into a binary mesh in its final GL layout:
+        // half float positions + 2_10_10_10 normals (12 bytes per vertex) and 16-bit indices.
+        // Later runs just map cuboid.mesh and upload straight from the mapping.
+        GpuMesh mesh;
+        if (!loadMesh("cuboid.obj", "cuboid.mesh", mesh))
+        {
+            std::cerr << "Failed to load cuboid mesh\n";
+            return -1;
+        }
 
-        while (!glfwWindowShouldClose(window))
+        // World matrices of the visible objects, fed to attributes 2-5 of the mesh VAO once per instance
+        GLuint instanceBuffer;
+        size_t instanceCapacity = 0;
+        glGenBuffers(1, &instanceBuffer);
+        glBindVertexArray(mesh.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        for (int column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(2 + column);
+            glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(sizeof(glm::vec4) * column));
+            glVertexAttribDivisor(2 + column, 1);
+        }
+        glBindVertexArray(0);
+
+        // The root node carries the Object Controls transform, with one child node per cuboid.
+        // Only subtrees whose transforms changed get their world matrices and bounds recomputed.
+        SceneGraph scene;
+        JobSystem jobs;
+        jobs.init();
+        SceneNode rootNode = kInvalidNode;
+        std::vector<SceneNode> objectNodes;
+        BoundsSoA bounds;
+        std::vector<uint32_t> visible;
+        int builtCount = 0;
+        float builtSpacing = 0.0f;
+
+        FrameTimeStats frameTimes;
+        frameTimes.reserve(headless.frames);
+        auto runStart = std::chrono::steady_clock::now();
+
+        while (!inputRecorder.replayFinished() && (headless.enabled ? frameTimes.frames() < (size_t)headless.frames : !glfwWindowShouldClose(window)))
         {
+            auto frameStart = std::chrono::steady_clock::now();
             glfwPollEvents();
+            inputRecorder.newFrame();
 
             // Render UI
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
+            inputRecorder.applyReplayDeltaTime();
             ImGui::NewFrame();
 
             ImGui::Begin("Object Controls");
@@ -250,21 +295,108 @@ std::vector<unsigned int> indices = {
                 rotation = glm::vec3(0.0f);
             }
 
+            ImGui::SliderInt("Objects", &objectCount, 1, 1000000, "%d", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Spacing", &objectSpacing, 1.0f, 4.0f);
+            ImGui::SliderInt("Spinning Objects", &spinningObjects, 0, 1000);
+            ImGui::SliderFloat("Camera Distance", &cameraDistance, 1.0f, 100.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Camera Yaw", &cameraYaw, -180.0f, 180.0f);
+            ImGui::SliderFloat("Camera Pitch", &cameraPitch, -89.0f, 89.0f);
+
+            ImGui::Text("Vertex: %u bytes, Index: %d-bit", mesh.stride, mesh.index_type == GL_UNSIGNED_SHORT ? 16 : 32);
+
+            ImGui::End();
+
+            if (objectCount != builtCount || objectSpacing != builtSpacing)
+            {
+                scene.clear();
+                rootNode = scene.create();
+                objectNodes.resize(objectCount);
+                for (int i = 0; i < objectCount; i++)
+                {
+                    objectNodes[i] = scene.create(rootNode);
+                    scene.setTranslation(objectNodes[i], GridOffset(i, objectCount));
+                }
+                bounds.resize(objectCount);
+                visible.resize(objectCount);
+                builtCount = objectCount;
+                builtSpacing = objectSpacing;
+            }
+
+            if (scene.translation(rootNode) != translation)
+                scene.setTranslation(rootNode, translation);
+            if (scene.rotation(rootNode) != rotation)
+                scene.setRotation(rootNode, rotation);
+
+            // spin a few objects spread across the grid; the rest stay untouched
+            int spinning = std::min(spinningObjects, objectCount);
+            // ImGui time advances by the fixed step during a replay, so the spin replays too
+            float angle = (float)std::fmod(ImGui::GetTime() * 90.0, 360.0);
+            for (int i = 0; i < spinning; i++)
+                scene.setRotation(objectNodes[(size_t)i * objectCount / spinning], glm::vec3(0.0f, angle, 0.0f));
+
+            // transform update, bounds refresh, culling and instance fill all run as jobs
+            size_t transformsUpdated = scene.update(&jobs);
+            for (const auto &range : scene.updatedRanges())
+            {
+                jobs.parallelFor(range.second - range.first, 4096, [&](size_t begin, size_t end) {
+                    for (size_t position = range.first + begin; position < range.first + end; position++)
+                    {
+                        // object handles are allocated consecutively right after the root
+                        SceneNode node = scene.nodeAt((uint32_t)position);
+                        if (node != rootNode)
+                            bounds.setTransformedBox(node - objectNodes.front(), scene.worldMatrices()[position], mesh.bounds_center, mesh.bounds_extent);
+                    }
+                });
+            }
+
+            glm::vec3 eye = cameraDistance * glm::vec3(std::sin(glm::radians(cameraYaw)) * std::cos(glm::radians(cameraPitch)),
+                                                       std::sin(glm::radians(cameraPitch)),
+                                                       std::cos(glm::radians(cameraYaw)) * std::cos(glm::radians(cameraPitch)));
+            glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+
+            // Cull against the camera frustum, then write only the survivors into the instance buffer
+            auto cullStart = std::chrono::steady_clock::now();
+            size_t visibleCount = cullBoxes(Frustum::fromMatrix(projection * view), bounds, visible.data(), jobs);
+            double cullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+
+            glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+            if (visibleCount > instanceCapacity)
+            {
+                instanceCapacity = std::max(visibleCount, instanceCapacity * 2);
+                trackedBufferData(GL_ARRAY_BUFFER, instanceBuffer, instanceCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW, "Cuboid instances");
+            }
+            if (visibleCount > 0)
+            {
+                glm::mat4 *instances = (glm::mat4 *)glMapBufferRange(GL_ARRAY_BUFFER, 0, visibleCount * sizeof(glm::mat4), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+                jobs.parallelFor(visibleCount, 4096, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++)
+                        instances[i] = scene.world(objectNodes[visible[i]]);
+                });
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+
+            ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 10.0f, 10.0f), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+            ImGui::SetNextWindowBgAlpha(0.35f);
+            ImGui::Begin("Culling", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoInputs);
+            ImGui::Text("Transforms updated: %zu", transformsUpdated);
+            ImGui::Text("Drawn: %zu", visibleCount);
+            ImGui::Text("Culled: %zu", (size_t)objectCount - visibleCount);
+            ImGui::Text("Cull: %.3f ms (%s)", cullMs, cullingUsesAvx() ? "AVX" : "scalar");
             ImGui::End();
 
+            if (showMemory)
+                memoryTelemetry().draw(&showMemory);
+
             ImGui::Render();
 
             // Render Scene
+            if (headless.enabled)
+                offscreen.bind();
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glUseProgram(shaderProgram);
 
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), translation);
-            model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-
-            glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-            glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+            glm::mat4 model = mesh.dequantization;
 
             // get the uniform locations
             GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
@@ -289,22 +421,34 @@ std::vector<unsigned int> indices = {
             glUniform3fv(lightDirLoc, 1, &lightDir[0]);
 
 
-            glBindVertexArray(VAO);
-            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+            mesh.drawInstanced((uint32_t)visibleCount);
 
             // Render ImGui
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            imguiRenderer.render(ImGui::GetDrawData());
 
             glfwSwapBuffers(window);
+            if (headless.enabled)
+                frameTimes.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+        }
+
+        if (headless.enabled)
+        {
+            glFinish();
+            frameTimes.print(stdout, "main_draggable5", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count());
         }
 
+        inputRecorder.stop();
+        imguiRenderer.shutdown();
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
+        MemoryTelemetry::restoreImGuiAllocator();
 
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        jobs.shutdown();
+        trackedDeleteBuffers(1, &instanceBuffer);
+        trackedDeleteProgram(shaderProgram);
+        mesh.destroy();
+        offscreen.destroy();
 
         glfwDestroyWindow(window);
         glfwTerminate();
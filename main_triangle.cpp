@@ -8,6 +8,7 @@
 #include <vector>
 
 #include <GL/glew.h> // Initialize with glewInit()
+#include "memory_telemetry.h"
 
 // Include glfw3.h after our OpenGL definitions
 #include <GLFW/glfw3.h>
@@ -59,9 +60,9 @@ namespace main_triangle
 		glGenBuffers(1, &ebo);
 		glBindVertexArray(vao);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(triangle_vertices), triangle_vertices, GL_STATIC_DRAW);
+		trackedBufferData(GL_ARRAY_BUFFER, vbo, sizeof(triangle_vertices), triangle_vertices, GL_STATIC_DRAW, "Triangle vertices");
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(triangle_indices), triangle_indices, GL_STATIC_DRAW);
+		trackedBufferData(GL_ELEMENT_ARRAY_BUFFER, ebo, sizeof(triangle_indices), triangle_indices, GL_STATIC_DRAW, "Triangle indices");
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
@@ -0,0 +1,173 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: data_(nullptr), size_(0), open_(false)
+#if defined(_WIN32)
+	, file_handle_(nullptr), mapping_handle_(nullptr)
+#else
+	, fd_(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: MappedFile()
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		std::swap(open_, other.open_);
+		std::swap(filename_, other.filename_);
+#if defined(_WIN32)
+		std::swap(file_handle_, other.file_handle_);
+		std::swap(mapping_handle_, other.mapping_handle_);
+#else
+		std::swap(fd_, other.fd_);
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+	filename_ = filename;
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "Failed to open file: " << filename << std::endl;
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(file, &file_size);
+	size_ = (size_t)file_size.QuadPart;
+	file_handle_ = file;
+	open_ = true;
+	if (size_ == 0)
+		return true;
+
+	mapping_handle_ = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping_handle_)
+		data_ = (const uint8_t*)MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0);
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "Failed to open file: " << filename << std::endl;
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		std::cerr << "Failed to stat file: " << filename << std::endl;
+		return false;
+	}
+	size_ = (size_t)st.st_size;
+	fd_ = fd; // kept for read()
+	open_ = true;
+	if (size_ == 0)
+		return true;
+
+	void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapping != MAP_FAILED)
+	{
+		data_ = (const uint8_t*)mapping;
+		madvise(mapping, size_, MADV_SEQUENTIAL);
+	}
+#endif
+
+	if (!data_)
+	{
+		std::cerr << "Failed to map file: " << filename << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+#if defined(_WIN32)
+	if (data_)
+		UnmapViewOfFile(data_);
+	if (mapping_handle_)
+		CloseHandle(mapping_handle_);
+	if (file_handle_)
+		CloseHandle(file_handle_);
+	file_handle_ = nullptr;
+	mapping_handle_ = nullptr;
+#else
+	if (data_)
+		munmap((void*)data_, size_);
+	if (fd_ >= 0)
+		::close(fd_);
+	fd_ = -1;
+#endif
+	data_ = nullptr;
+	size_ = 0;
+	open_ = false;
+}
+
+size_t MappedFile::read(uint64_t offset, void* out, size_t size) const
+{
+	size_t done = 0;
+#if defined(_WIN32)
+	if (!file_handle_)
+		return 0;
+	while (done < size)
+	{
+		OVERLAPPED overlapped = {};
+		uint64_t position = offset + done;
+		overlapped.Offset = (DWORD)position;
+		overlapped.OffsetHigh = (DWORD)(position >> 32);
+		DWORD count = (DWORD)std::min<size_t>(size - done, 1u << 30);
+		DWORD got = 0;
+		if (!ReadFile(file_handle_, (uint8_t*)out + done, count, &got, &overlapped) || got == 0)
+			break;
+		done += got;
+	}
+#else
+	if (fd_ < 0)
+		return 0;
+	while (done < size)
+	{
+		ssize_t got = pread(fd_, (uint8_t*)out + done, size - done, (off_t)(offset + done));
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			break;
+		done += (size_t)got;
+	}
+#endif
+	return done;
+}
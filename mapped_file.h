@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are faulted in on demand,
+// so opening a multi-GB file costs nothing until the bytes are touched.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& filename);
+	void close();
+
+	bool isOpen() const { return open_; }
+	const uint8_t* data() const { return data_; }
+	size_t size() const { return size_; }
+	const std::string& filename() const { return filename_; }
+
+	// Copies up to size bytes at offset through the file handle rather than the mapping and
+	// returns how many there were. For files that may shrink while mapped: touching a mapped
+	// page past the new end faults (SIGBUS), a read just comes up short.
+	size_t read(uint64_t offset, void* out, size_t size) const;
+
+private:
+	const uint8_t* data_;
+	size_t size_;
+	bool open_;
+	std::string filename_;
+#if defined(_WIN32)
+	void* file_handle_;
+	void* mapping_handle_;
+#else
+	int fd_;
+#endif
+};
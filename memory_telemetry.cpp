@@ -0,0 +1,314 @@
+#include "memory_telemetry.h"
+#include "size_class_pool.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	GLenum bindingFor(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER: return GL_ARRAY_BUFFER_BINDING;
+		case GL_ELEMENT_ARRAY_BUFFER: return GL_ELEMENT_ARRAY_BUFFER_BINDING;
+		case GL_UNIFORM_BUFFER: return GL_UNIFORM_BUFFER_BINDING;
+		case GL_PIXEL_PACK_BUFFER: return GL_PIXEL_PACK_BUFFER_BINDING;
+		case GL_PIXEL_UNPACK_BUFFER: return GL_PIXEL_UNPACK_BUFFER_BINDING;
+		case GL_COPY_READ_BUFFER: return GL_COPY_READ_BUFFER;
+		case GL_COPY_WRITE_BUFFER: return GL_COPY_WRITE_BUFFER;
+		case GL_TEXTURE_BUFFER: return GL_TEXTURE_BUFFER; // doubles as its binding query
+		case GL_DRAW_INDIRECT_BUFFER: return GL_DRAW_INDIRECT_BUFFER_BINDING;
+		case GL_TEXTURE_2D: return GL_TEXTURE_BINDING_2D;
+		default: return 0;
+		}
+	}
+
+	GLuint boundObject(GLenum target)
+	{
+		GLenum binding = bindingFor(target);
+		GLint id = 0;
+		if (binding)
+			glGetIntegerv(binding, &id);
+		return (GLuint)id;
+	}
+
+	size_t bytesPerPixel(GLint internal_format)
+	{
+		switch (internal_format)
+		{
+		case GL_R8: case GL_RED: case GL_ALPHA: return 1;
+		case GL_RG8: case GL_R16F: return 2;
+		case GL_RGB8: case GL_RGB: case GL_SRGB8: return 3;
+		case GL_RG16F: case GL_R32F: case GL_DEPTH_COMPONENT24: case GL_DEPTH24_STENCIL8: return 4;
+		case GL_RGBA16F: case GL_RG32F: return 8;
+		case GL_RGB32F: return 12;
+		case GL_RGBA32F: return 16;
+		default: return 4; // GL_RGBA8, GL_RGBA, GL_SRGB8_ALPHA8 and the unknown
+		}
+	}
+
+	// Mip levels of one texture are summed under one id, so remember them per level
+	std::unordered_map<uint64_t, size_t> g_texture_levels;
+	std::mutex g_texture_levels_mutex;
+}
+
+const char* memoryTagName(MemoryTag tag)
+{
+	switch (tag)
+	{
+	case MemoryTag::ImGui: return "ImGui";
+	case MemoryTag::GLBuffer: return "GL buffers";
+	case MemoryTag::GLTexture: return "GL textures";
+	case MemoryTag::GLProgram: return "GL programs";
+	default: return "?";
+	}
+}
+
+MemoryTelemetry& memoryTelemetry()
+{
+	static MemoryTelemetry telemetry;
+	return telemetry;
+}
+
+void MemoryTelemetry::add(MemoryTag tag, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	MemoryTagStats& stats = stats_[(int)tag];
+	stats.live_bytes += (int64_t)bytes;
+	stats.live_count++;
+	stats.total_allocations++;
+	stats.peak_bytes = std::max(stats.peak_bytes, stats.live_bytes);
+}
+
+void MemoryTelemetry::remove(MemoryTag tag, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	MemoryTagStats& stats = stats_[(int)tag];
+	stats.live_bytes -= (int64_t)bytes;
+	stats.live_count--;
+}
+
+MemoryTagStats MemoryTelemetry::stats(MemoryTag tag) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stats_[(int)tag];
+}
+
+void MemoryTelemetry::registerGLObject(MemoryTag tag, GLuint id, size_t bytes, const char* label)
+{
+	if (id == 0)
+		return;
+	std::lock_guard<std::mutex> lock(mutex_);
+	MemoryTagStats& stats = stats_[(int)tag];
+	auto it = gl_objects_.find(key(tag, id));
+	if (it != gl_objects_.end())
+	{
+		stats.live_bytes -= (int64_t)it->second.bytes;
+		it->second.bytes = bytes;
+		if (label)
+			it->second.label = label;
+	}
+	else
+	{
+		gl_objects_.emplace(key(tag, id), GLObject{ bytes, label ? label : "" });
+		stats.live_count++;
+	}
+	stats.live_bytes += (int64_t)bytes;
+	stats.total_allocations++;
+	stats.peak_bytes = std::max(stats.peak_bytes, stats.live_bytes);
+}
+
+void MemoryTelemetry::unregisterGLObject(MemoryTag tag, GLuint id)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = gl_objects_.find(key(tag, id));
+	if (it == gl_objects_.end())
+		return;
+	MemoryTagStats& stats = stats_[(int)tag];
+	stats.live_bytes -= (int64_t)it->second.bytes;
+	stats.live_count--;
+	gl_objects_.erase(it);
+}
+
+void MemoryTelemetry::draw(bool* open)
+{
+	if (!ImGui::Begin("Memory", open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	if (ImGui::BeginTable("tags", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Tag");
+		ImGui::TableSetupColumn("Live bytes");
+		ImGui::TableSetupColumn("Peak bytes");
+		ImGui::TableSetupColumn("Live count");
+		ImGui::TableSetupColumn("Total allocs");
+		ImGui::TableHeadersRow();
+		for (int tag = 0; tag < (int)MemoryTag::Count; tag++)
+		{
+			MemoryTagStats s = stats((MemoryTag)tag);
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(memoryTagName((MemoryTag)tag));
+			ImGui::TableNextColumn();
+			ImGui::Text("%lld", (long long)s.live_bytes);
+			ImGui::TableNextColumn();
+			ImGui::Text("%lld", (long long)s.peak_bytes);
+			ImGui::TableNextColumn();
+			ImGui::Text("%lld", (long long)s.live_count);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)s.total_allocations);
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::Button("Dump JSON"))
+		writeJson("memory_telemetry.json");
+
+	if (ImGui::TreeNode("GL objects"))
+	{
+		// drawn from a copy: ImGui allocates through imguiAlloc(), which takes mutex_ too
+		std::vector<std::pair<uint64_t, GLObject>> objects;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			objects.assign(gl_objects_.begin(), gl_objects_.end());
+		}
+		for (const auto& entry : objects)
+			ImGui::Text("%-12s %6u %10zu  %s", memoryTagName((MemoryTag)(entry.first >> 32)), (unsigned)(entry.first & 0xFFFFFFFF), entry.second.bytes, entry.second.label.c_str());
+		ImGui::TreePop();
+	}
+	ImGui::End();
+}
+
+bool MemoryTelemetry::writeJson(const std::string& filename) const
+{
+	std::ofstream file(filename, std::ios::trunc);
+	if (!file)
+		return false;
+
+	auto quoted = [](const std::string& text) {
+		std::string out = "\"";
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\';
+			out += c;
+		}
+		return out + "\"";
+	};
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	file << "{\n  \"tags\": [\n";
+	for (int tag = 0; tag < (int)MemoryTag::Count; tag++)
+	{
+		const MemoryTagStats& s = stats_[tag];
+		file << "    { \"name\": " << quoted(memoryTagName((MemoryTag)tag)) << ", \"live_bytes\": " << s.live_bytes
+			 << ", \"peak_bytes\": " << s.peak_bytes << ", \"live_count\": " << s.live_count
+			 << ", \"total_allocations\": " << s.total_allocations << " }" << (tag + 1 < (int)MemoryTag::Count ? "," : "") << "\n";
+	}
+	file << "  ],\n  \"gl_objects\": [\n";
+	size_t index = 0;
+	for (const auto& entry : gl_objects_)
+	{
+		file << "    { \"tag\": " << quoted(memoryTagName((MemoryTag)(entry.first >> 32))) << ", \"id\": " << (entry.first & 0xFFFFFFFF)
+			 << ", \"bytes\": " << entry.second.bytes << ", \"label\": " << quoted(entry.second.label) << " }"
+			 << (++index < gl_objects_.size() ? "," : "") << "\n";
+	}
+	file << "  ]\n}\n";
+	return (bool)file;
+}
+
+void* MemoryTelemetry::imguiAlloc(size_t size, void* pool)
+{
+	memoryTelemetry().add(MemoryTag::ImGui, size);
+	return ((SizeClassPool*)pool)->allocate(size);
+}
+
+void MemoryTelemetry::imguiFree(void* pointer, void* pool)
+{
+	if (!pointer)
+		return;
+	memoryTelemetry().remove(MemoryTag::ImGui, SizeClassPool::allocationSize(pointer));
+	((SizeClassPool*)pool)->deallocate(pointer);
+}
+
+void MemoryTelemetry::restoreImGuiAllocator()
+{
+	ImGui::SetAllocatorFunctions([](size_t size, void*) { return malloc(size); }, [](void* pointer, void*) { free(pointer); }, nullptr);
+}
+
+void trackedBufferData(GLenum target, GLuint buffer, GLsizeiptr size, const void* data, GLenum usage, const char* label)
+{
+	glBufferData(target, size, data, usage);
+	memoryTelemetry().registerGLObject(MemoryTag::GLBuffer, buffer, (size_t)size, label);
+}
+
+void trackedDeleteBuffers(GLsizei count, const GLuint* buffers)
+{
+	for (GLsizei i = 0; i < count; i++)
+		memoryTelemetry().unregisterGLObject(MemoryTag::GLBuffer, buffers[i]);
+	glDeleteBuffers(count, buffers);
+}
+
+void trackedTexImage2D(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels, const char* label)
+{
+	glTexImage2D(target, level, internal_format, width, height, border, format, type, pixels);
+	GLuint texture = boundObject(target);
+	if (texture == 0)
+		return;
+
+	size_t total = 0;
+	{
+		std::lock_guard<std::mutex> lock(g_texture_levels_mutex);
+		g_texture_levels[((uint64_t)texture << 8) | (uint64_t)level] = (size_t)width * height * bytesPerPixel(internal_format);
+		for (uint64_t l = 0; l < 32; l++)
+		{
+			auto it = g_texture_levels.find(((uint64_t)texture << 8) | l);
+			if (it != g_texture_levels.end())
+				total += it->second;
+		}
+	}
+	memoryTelemetry().registerGLObject(MemoryTag::GLTexture, texture, total, label);
+}
+
+void trackedDeleteTextures(GLsizei count, const GLuint* textures)
+{
+	{
+		std::lock_guard<std::mutex> lock(g_texture_levels_mutex);
+		for (GLsizei i = 0; i < count; i++)
+			for (uint64_t l = 0; l < 32; l++)
+				g_texture_levels.erase(((uint64_t)textures[i] << 8) | l);
+	}
+	for (GLsizei i = 0; i < count; i++)
+		memoryTelemetry().unregisterGLObject(MemoryTag::GLTexture, textures[i]);
+	glDeleteTextures(count, textures);
+}
+
+void trackProgram(GLuint program, const char* label)
+{
+	GLint length = 0;
+	if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	memoryTelemetry().registerGLObject(MemoryTag::GLProgram, program, (size_t)length, label);
+}
+
+void trackedDeleteProgram(GLuint program)
+{
+	memoryTelemetry().unregisterGLObject(MemoryTag::GLProgram, program);
+	glDeleteProgram(program);
+}
+
+void trackImGuiFontTexture()
+{
+	ImGuiIO& io = ImGui::GetIO();
+	unsigned char* pixels = nullptr;
+	int width = 0, height = 0;
+	io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+	memoryTelemetry().registerGLObject(MemoryTag::GLTexture, (GLuint)(intptr_t)io.Fonts->TexID, (size_t)width * height * 4, "ImGui font atlas");
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <GL/glew.h>
+
+enum class MemoryTag
+{
+	ImGui,
+	GLBuffer,
+	GLTexture,
+	GLProgram,
+	Count
+};
+
+const char* memoryTagName(MemoryTag tag);
+
+struct MemoryTagStats
+{
+	int64_t live_bytes = 0;
+	int64_t peak_bytes = 0;
+	int64_t live_count = 0;
+	uint64_t total_allocations = 0;
+};
+
+// Live bytes and high-water marks per tag, plus a registry of every tracked GL object
+// with its size and label. Thread-safe; use memoryTelemetry() for the process-wide one.
+class MemoryTelemetry
+{
+public:
+	void add(MemoryTag tag, size_t bytes);
+	void remove(MemoryTag tag, size_t bytes);
+	MemoryTagStats stats(MemoryTag tag) const;
+
+	// GL registry; re-registering an object replaces its previous size
+	void registerGLObject(MemoryTag tag, GLuint id, size_t bytes, const char* label);
+	void unregisterGLObject(MemoryTag tag, GLuint id);
+
+	// ImGui window with per-tag numbers and the GL object list
+	void draw(bool* open = nullptr);
+	bool writeJson(const std::string& filename) const;
+
+	// Route ImGui::SetAllocatorFunctions through these with a SizeClassPool as user data
+	static void* imguiAlloc(size_t size, void* pool);
+	static void imguiFree(void* pointer, void* pool);
+	// Points ImGui back at malloc/free; call after DestroyContext() when the pool goes away
+	static void restoreImGuiAllocator();
+
+private:
+	struct GLObject
+	{
+		size_t bytes;
+		std::string label;
+	};
+
+	static uint64_t key(MemoryTag tag, GLuint id) { return ((uint64_t)tag << 32) | id; }
+
+	mutable std::mutex mutex_;
+	MemoryTagStats stats_[(int)MemoryTag::Count];
+	std::unordered_map<uint64_t, GLObject> gl_objects_;
+};
+
+MemoryTelemetry& memoryTelemetry();
+
+// Replacements for the GL calls that give objects storage or delete them. buffer must be the
+// one bound to target; textures are identified through the current binding of target.
+void trackedBufferData(GLenum target, GLuint buffer, GLsizeiptr size, const void* data, GLenum usage, const char* label = nullptr);
+void trackedDeleteBuffers(GLsizei count, const GLuint* buffers);
+void trackedTexImage2D(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels, const char* label = nullptr);
+void trackedDeleteTextures(GLsizei count, const GLuint* textures);
+// Call after linking; the size is the driver's program binary length when it reports one
+void trackProgram(GLuint program, const char* label = nullptr);
+void trackedDeleteProgram(GLuint program);
+// The ImGui OpenGL backend creates the font atlas itself; register it once it exists
+void trackImGuiFontTexture();
@@ -0,0 +1,198 @@
+#include "mesh_file.h"
+#include "mesh_importer.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <GL/glew.h>
+#include "memory_telemetry.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+	const char kMeshMagic[4] = { 'M', 'E', 'S', 'H' };
+	const uint32_t kMeshVersion = 3;
+	const uint64_t kBlockAlignment = 64;
+
+	uint64_t alignUp(uint64_t value)
+	{
+		return (value + kBlockAlignment - 1) & ~(kBlockAlignment - 1);
+	}
+}
+
+bool writeMeshFile(const std::string& filename, const PackedMesh& mesh)
+{
+	MeshFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, kMeshMagic, sizeof(header.magic));
+	header.version = kMeshVersion;
+	header.position_format = (uint8_t)mesh.format.position;
+	header.normal_format = (uint8_t)mesh.format.normal;
+	header.index16 = mesh.index16 ? 1 : 0;
+	header.index_format = (uint8_t)mesh.format.index;
+	header.stride = mesh.format.stride();
+	header.vertex_count = mesh.vertex_count;
+	header.index_count = mesh.index_count;
+	header.vertex_offset = alignUp(sizeof(MeshFileHeader));
+	header.vertex_bytes = mesh.vertex_data.size();
+	header.index_offset = alignUp(header.vertex_offset + header.vertex_bytes);
+	header.index_bytes = mesh.index_data.size();
+	for (int c = 0; c < 3; c++)
+	{
+		header.position_center[c] = mesh.position_center[c];
+		header.position_extent[c] = mesh.position_extent[c];
+	}
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cerr << "Failed to create mesh file: " << filename << std::endl;
+		return false;
+	}
+
+	const char padding[kBlockAlignment] = {};
+	file.write((const char*)&header, sizeof(header));
+	file.write(padding, header.vertex_offset - sizeof(header));
+	file.write((const char*)mesh.vertex_data.data(), header.vertex_bytes);
+	file.write(padding, header.index_offset - (header.vertex_offset + header.vertex_bytes));
+	file.write((const char*)mesh.index_data.data(), header.index_bytes);
+	if (!file)
+	{
+		std::cerr << "Failed to write mesh file: " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool MeshFile::open(const std::string& filename)
+{
+	if (!file_.open(filename))
+		return false;
+
+	if (file_.size() < sizeof(MeshFileHeader) || memcmp(header().magic, kMeshMagic, sizeof(kMeshMagic)) != 0)
+	{
+		std::cerr << "Not a mesh file: " << filename << std::endl;
+		file_.close();
+		return false;
+	}
+
+	const MeshFileHeader& h = header();
+	VertexFormat expected = format();
+	bool valid = h.version == kMeshVersion
+		&& h.position_format <= (uint8_t)PositionFormat::Snorm16
+		&& h.normal_format <= (uint8_t)NormalFormat::Int2101010
+		&& h.index_format <= (uint8_t)IndexFormat::Uint32
+		&& h.stride == expected.stride()
+		&& h.vertex_bytes == (uint64_t)h.vertex_count * h.stride
+		&& h.index_bytes == (uint64_t)h.index_count * (h.index16 ? 2 : 4)
+		&& h.vertex_offset + h.vertex_bytes <= file_.size()
+		&& h.index_offset + h.index_bytes <= file_.size();
+	if (!valid)
+	{
+		std::cerr << "Corrupt or unsupported mesh file: " << filename << std::endl;
+		file_.close();
+		return false;
+	}
+	return true;
+}
+
+VertexFormat MeshFile::format() const
+{
+	VertexFormat format;
+	format.position = (PositionFormat)header().position_format;
+	format.normal = (NormalFormat)header().normal_format;
+	format.index = header().index16 ? IndexFormat::Uint16 : IndexFormat::Uint32;
+	return format;
+}
+
+bool MeshFile::packedWith(const VertexFormat& format) const
+{
+	const MeshFileHeader& h = header();
+	return h.position_format == (uint8_t)format.position
+		&& h.normal_format == (uint8_t)format.normal
+		&& h.index_format == (uint8_t)format.index;
+}
+
+glm::mat4 MeshFile::dequantization() const
+{
+	if (format().position != PositionFormat::Snorm16)
+		return glm::mat4(1.0f);
+	const MeshFileHeader& h = header();
+	glm::vec3 center(h.position_center[0], h.position_center[1], h.position_center[2]);
+	glm::vec3 extent(h.position_extent[0], h.position_extent[1], h.position_extent[2]);
+	return glm::scale(glm::translate(glm::mat4(1.0f), center), extent);
+}
+
+void GpuMesh::draw() const
+{
+	glBindVertexArray(vao);
+	glDrawElements(GL_TRIANGLES, (GLsizei)index_count, index_type, 0);
+}
+
+void GpuMesh::drawInstanced(uint32_t instance_count) const
+{
+	glBindVertexArray(vao);
+	glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)index_count, index_type, 0, (GLsizei)instance_count);
+}
+
+void GpuMesh::destroy()
+{
+	glDeleteVertexArrays(1, &vao);
+	trackedDeleteBuffers(1, &vbo);
+	trackedDeleteBuffers(1, &ebo);
+	vao = vbo = ebo = 0;
+}
+
+bool uploadMesh(const MeshFile& file, GpuMesh& mesh)
+{
+	const MeshFileHeader& h = file.header();
+
+	glGenVertexArrays(1, &mesh.vao);
+	glGenBuffers(1, &mesh.vbo);
+	glGenBuffers(1, &mesh.ebo);
+	glBindVertexArray(mesh.vao);
+
+	// the driver copies straight out of the mapped pages, no intermediate buffer
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+	trackedBufferData(GL_ARRAY_BUFFER, mesh.vbo, (GLsizeiptr)h.vertex_bytes, file.vertexData(), GL_STATIC_DRAW, "Mesh vertices");
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+	trackedBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo, (GLsizeiptr)h.index_bytes, file.indexData(), GL_STATIC_DRAW, "Mesh indices");
+	setupVertexAttributes(file.format());
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	mesh.vertex_count = h.vertex_count;
+	mesh.index_count = h.index_count;
+	mesh.index_type = h.index16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	mesh.stride = h.stride;
+	mesh.dequantization = file.dequantization();
+	mesh.bounds_center = glm::vec3(h.position_center[0], h.position_center[1], h.position_center[2]);
+	mesh.bounds_extent = glm::vec3(h.position_extent[0], h.position_extent[1], h.position_extent[2]);
+	return true;
+}
+
+bool loadMesh(const std::string& source_filename, const std::string& mesh_filename, GpuMesh& mesh, const VertexFormat& format)
+{
+	namespace fs = std::filesystem;
+	std::error_code ec;
+	bool stale = !fs::exists(mesh_filename, ec);
+	if (!stale && fs::exists(source_filename, ec))
+	{
+		stale = fs::last_write_time(source_filename, ec) > fs::last_write_time(mesh_filename, ec);
+		// an older file version or another vertex format is rebuilt as well
+		MeshFile existing;
+		if (!stale)
+			stale = !existing.open(mesh_filename) || !existing.packedWith(format);
+	}
+
+	if (stale && !convertToMeshFile(source_filename, mesh_filename, format))
+		return false;
+
+	MeshFile file;
+	if (!file.open(mesh_filename))
+		return false;
+	return uploadMesh(file, mesh);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "mapped_file.h"
+#include "vertex_format.h"
+
+// Binary mesh file: a fixed header followed by vertex and index blocks that are
+// already in their final GL layout, so loading is a mapping plus a glBufferData
+// straight from the mapped pages. Little-endian, blocks aligned to 64 bytes.
+struct MeshFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint8_t position_format;
+	uint8_t normal_format;
+	uint8_t index16;
+	uint8_t index_format; // the IndexFormat asked for; index16 is what it resolved to
+	uint32_t stride;
+	uint32_t vertex_count;
+	uint32_t index_count;
+	uint64_t vertex_offset;
+	uint64_t vertex_bytes;
+	uint64_t index_offset;
+	uint64_t index_bytes;
+	float position_center[3];
+	float position_extent[3];
+};
+
+bool writeMeshFile(const std::string& filename, const PackedMesh& mesh);
+
+// Zero-copy view of a .mesh file.
+class MeshFile
+{
+public:
+	bool open(const std::string& filename);
+	void close() { file_.close(); }
+
+	const MeshFileHeader& header() const { return *(const MeshFileHeader*)file_.data(); }
+	const uint8_t* vertexData() const { return file_.data() + header().vertex_offset; }
+	const uint8_t* indexData() const { return file_.data() + header().index_offset; }
+	VertexFormat format() const;
+	// True when the file was packed with the given requested format.
+	bool packedWith(const VertexFormat& format) const;
+	glm::mat4 dequantization() const;
+
+private:
+	MappedFile file_;
+};
+
+// GL buffers for a mesh uploaded from a MeshFile.
+struct GpuMesh
+{
+	unsigned int vao = 0, vbo = 0, ebo = 0;
+	uint32_t vertex_count = 0;
+	uint32_t index_count = 0;
+	unsigned int index_type = 0;
+	uint32_t stride = 0;
+	glm::mat4 dequantization = glm::mat4(1.0f);
+	// local bounding box of the undequantized positions, for culling
+	glm::vec3 bounds_center = glm::vec3(0.0f);
+	glm::vec3 bounds_extent = glm::vec3(0.0f);
+
+	void draw() const;
+	void drawInstanced(uint32_t instance_count) const;
+	void destroy();
+};
+
+bool uploadMesh(const MeshFile& file, GpuMesh& mesh);
+
+// Maps mesh_filename and uploads it, regenerating it from source_filename (OBJ/PLY)
+// first when the binary file is missing, unreadable, older than the source or packed
+// with a different vertex format.
+bool loadMesh(const std::string& source_filename, const std::string& mesh_filename, GpuMesh& mesh, const VertexFormat& format = VertexFormat());
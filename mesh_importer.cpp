@@ -0,0 +1,782 @@
+#include "mesh_importer.h"
+#include "mesh_file.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <glm/glm.hpp>
+
+namespace
+{
+	const size_t kShardCount = 256;
+	const size_t kMinChunkBytes = 256 * 1024;
+	const uint64_t kEmptyKey = ~0ull;
+	// negative OBJ indices are stored relative to their chunk until the chunk offsets are known
+	const int64_t kRelative = 1ll << 62;
+
+	unsigned int resolveThreadCount(unsigned int thread_count)
+	{
+		if (thread_count == 0)
+			thread_count = std::thread::hardware_concurrency();
+		return std::max(thread_count, 1u);
+	}
+
+	// Runs fn(i) for i in [0, count) on up to thread_count threads.
+	template <typename Fn>
+	void parallelFor(size_t count, unsigned int thread_count, Fn&& fn)
+	{
+		size_t workers = std::min((size_t)thread_count, count);
+		if (workers <= 1)
+		{
+			for (size_t i = 0; i < count; i++)
+				fn(i);
+			return;
+		}
+
+		std::atomic<size_t> next(0);
+		auto work = [&]() {
+			for (size_t i = next++; i < count; i = next++)
+				fn(i);
+		};
+		std::vector<std::thread> threads;
+		threads.reserve(workers - 1);
+		for (size_t t = 1; t < workers; t++)
+			threads.emplace_back(work);
+		work();
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	struct TextRange
+	{
+		const char* begin;
+		const char* end;
+	};
+
+	// Splits text into roughly equal ranges that each start at the beginning of a line.
+	std::vector<TextRange> splitLines(const char* begin, const char* end, unsigned int thread_count)
+	{
+		size_t size = (size_t)(end - begin);
+		size_t parts = std::max<size_t>(1, std::min<size_t>(thread_count * 4, size / kMinChunkBytes));
+		std::vector<TextRange> ranges;
+		ranges.reserve(parts);
+
+		const char* start = begin;
+		for (size_t i = 1; i <= parts && start < end; i++)
+		{
+			const char* split = i == parts ? end : std::max(start, begin + size / parts * i);
+			const char* newline = split < end ? (const char*)memchr(split, '\n', (size_t)(end - split)) : nullptr;
+			split = newline ? newline + 1 : end;
+			ranges.push_back({ start, split });
+			start = split;
+		}
+		return ranges;
+	}
+
+	inline const char* skipSpaces(const char* p, const char* end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+			p++;
+		return p;
+	}
+
+	inline const char* lineEnd(const char* p, const char* end)
+	{
+		const char* newline = (const char*)memchr(p, '\n', (size_t)(end - p));
+		return newline ? newline : end;
+	}
+
+	inline const char* parseFloat(const char* p, const char* end, float& value)
+	{
+		p = skipSpaces(p, end);
+		if (p < end && *p == '+')
+			p++;
+		auto result = std::from_chars(p, end, value);
+		return result.ec == std::errc() ? result.ptr : nullptr;
+	}
+
+	inline const char* parseInt(const char* p, const char* end, int64_t& value)
+	{
+		p = skipSpaces(p, end);
+		auto result = std::from_chars(p, end, value);
+		return result.ec == std::errc() ? result.ptr : nullptr;
+	}
+
+	inline uint64_t mixHash(uint64_t key)
+	{
+		// splitmix64 finalizer
+		key ^= key >> 30;
+		key *= 0xbf58476d1ce4e5b9ull;
+		key ^= key >> 27;
+		key *= 0x94d049bb133111ebull;
+		key ^= key >> 31;
+		return key;
+	}
+
+	inline size_t shardOf(uint64_t hash)
+	{
+		return (size_t)(hash >> 56) & (kShardCount - 1);
+	}
+
+	std::string excerpt(const char* p, const char* end)
+	{
+		return std::string(p, std::min(lineEnd(p, end), p + 80));
+	}
+
+	struct ObjChunk
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		// per corner: 0-based absolute index, or kRelative + chunk-local index; normal -1 if absent
+		std::vector<int64_t> corner_positions;
+		std::vector<int64_t> corner_normals;
+		std::vector<uint32_t> face_sizes;
+		std::vector<uint64_t> keys;
+		size_t flat_faces = 0;
+		size_t triangles = 0;
+		std::string error;
+
+		size_t position_base = 0, normal_base = 0, flat_base = 0, corner_base = 0, triangle_base = 0;
+	};
+
+	void parseObjChunk(const TextRange& range, ObjChunk& chunk)
+	{
+		const char* p = range.begin;
+		const char* end = range.end;
+		while (p < end)
+		{
+			p = skipSpaces(p, end);
+			const char* eol = lineEnd(p, end);
+
+			if (eol - p > 2 && p[0] == 'v' && p[1] == ' ')
+			{
+				glm::vec3 v;
+				const char* q = p + 2;
+				if (!(q = parseFloat(q, eol, v.x)) || !(q = parseFloat(q, eol, v.y)) || !(q = parseFloat(q, eol, v.z)))
+				{
+					chunk.error = "malformed vertex: " + excerpt(p, end);
+					return;
+				}
+				chunk.positions.push_back(v);
+			}
+			else if (eol - p > 3 && p[0] == 'v' && p[1] == 'n' && p[2] == ' ')
+			{
+				glm::vec3 n;
+				const char* q = p + 3;
+				if (!(q = parseFloat(q, eol, n.x)) || !(q = parseFloat(q, eol, n.y)) || !(q = parseFloat(q, eol, n.z)))
+				{
+					chunk.error = "malformed normal: " + excerpt(p, end);
+					return;
+				}
+				chunk.normals.push_back(n);
+			}
+			else if (eol - p > 2 && p[0] == 'f' && p[1] == ' ')
+			{
+				uint32_t corners = 0;
+				bool has_normals = true;
+				const char* q = skipSpaces(p + 2, eol);
+				while (q < eol)
+				{
+					// v, v/vt, v//vn or v/vt/vn
+					int64_t v = 0, vt = 0, vn = 0;
+					bool has_normal = false;
+					if (!(q = parseInt(q, eol, v)) || v == 0)
+					{
+						chunk.error = "malformed face: " + excerpt(p, end);
+						return;
+					}
+					if (q < eol && *q == '/')
+					{
+						q++;
+						if (q < eol && *q != '/')
+							q = parseInt(q, eol, vt);
+						if (q && q < eol && *q == '/')
+						{
+							q = parseInt(q + 1, eol, vn);
+							has_normal = q != nullptr && vn != 0;
+						}
+						if (!q)
+						{
+							chunk.error = "malformed face: " + excerpt(p, end);
+							return;
+						}
+					}
+					chunk.corner_positions.push_back(v > 0 ? v - 1 : kRelative + (int64_t)chunk.positions.size() + v);
+					chunk.corner_normals.push_back(!has_normal ? -1 : vn > 0 ? vn - 1 : kRelative + (int64_t)chunk.normals.size() + vn);
+					has_normals = has_normals && has_normal;
+					corners++;
+					q = skipSpaces(q, eol);
+				}
+
+				if (corners < 3)
+				{
+					chunk.corner_positions.resize(chunk.corner_positions.size() - corners);
+					chunk.corner_normals.resize(chunk.corner_normals.size() - corners);
+				}
+				else
+				{
+					chunk.face_sizes.push_back(has_normals ? corners : (corners | 0x80000000u));
+					chunk.flat_faces += has_normals ? 0 : 1;
+					chunk.triangles += corners - 2;
+				}
+			}
+
+			p = eol < end ? eol + 1 : end;
+		}
+	}
+
+	inline int64_t resolveObjIndex(int64_t index, size_t base)
+	{
+		return index >= kRelative / 2 ? (int64_t)base + (index - kRelative) : index;
+	}
+
+	// Resolves corner indices and builds the (position, normal) dedup keys for one chunk.
+	void resolveObjChunk(ObjChunk& chunk, const std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, size_t flat_normal_base)
+	{
+		size_t corner = 0;
+		size_t flat = flat_normal_base + chunk.flat_base;
+		chunk.keys.resize(chunk.corner_positions.size());
+		for (uint32_t face : chunk.face_sizes)
+		{
+			uint32_t corners = face & 0x7FFFFFFFu;
+			bool has_normals = (face & 0x80000000u) == 0;
+
+			for (uint32_t i = 0; i < corners; i++)
+			{
+				int64_t p = resolveObjIndex(chunk.corner_positions[corner + i], chunk.position_base);
+				if (p < 0 || p >= (int64_t)positions.size())
+				{
+					chunk.error = "face references a missing vertex";
+					return;
+				}
+				chunk.corner_positions[corner + i] = p;
+			}
+
+			int64_t flat_normal = -1;
+			if (!has_normals)
+			{
+				// faces without normals get a flat normal of their own
+				const glm::vec3& a = positions[chunk.corner_positions[corner]];
+				glm::vec3 n = glm::cross(positions[chunk.corner_positions[corner + 1]] - a, positions[chunk.corner_positions[corner + 2]] - a);
+				float len = glm::length(n);
+				normals[flat] = len > 0.0f ? n / len : glm::vec3(0.0f, 0.0f, 1.0f);
+				flat_normal = (int64_t)flat++;
+			}
+
+			for (uint32_t i = 0; i < corners; i++)
+			{
+				int64_t n = has_normals ? resolveObjIndex(chunk.corner_normals[corner + i], chunk.normal_base) : flat_normal;
+				if (n < 0 || n >= (int64_t)normals.size())
+				{
+					chunk.error = "face references a missing normal";
+					return;
+				}
+				chunk.keys[corner + i] = ((uint64_t)chunk.corner_positions[corner + i] << 32) | (uint64_t)n;
+			}
+			corner += corners;
+		}
+
+		chunk.corner_positions = std::vector<int64_t>();
+		chunk.corner_normals = std::vector<int64_t>();
+	}
+
+	// Open-addressing set that hands out ids in first-insertion order.
+	struct KeyIndex
+	{
+		std::vector<uint64_t> slots;
+		std::vector<uint32_t> ids;
+		std::vector<uint64_t> unique;
+		size_t mask = 0;
+
+		void reserve(size_t count)
+		{
+			size_t capacity = 16;
+			while (capacity < count * 2)
+				capacity <<= 1;
+			slots.assign(capacity, kEmptyKey);
+			ids.resize(capacity);
+			unique.clear();
+			mask = capacity - 1;
+		}
+
+		uint32_t insert(uint64_t key, uint64_t hash)
+		{
+			size_t slot = (size_t)hash & mask;
+			while (slots[slot] != kEmptyKey)
+			{
+				if (slots[slot] == key)
+					return ids[slot];
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = key;
+			ids[slot] = (uint32_t)unique.size();
+			unique.push_back(key);
+			return ids[slot];
+		}
+	};
+
+	bool hasExtension(const std::string& filename, const char* extension)
+	{
+		size_t length = strlen(extension);
+		if (filename.size() < length)
+			return false;
+		for (size_t i = 0; i < length; i++)
+		{
+			char c = filename[filename.size() - length + i];
+			if (c >= 'A' && c <= 'Z')
+				c = (char)(c - 'A' + 'a');
+			if (c != extension[i])
+				return false;
+		}
+		return true;
+	}
+
+	// Sums area-weighted face normals into the vertex normals of mesh on thread_count threads.
+	// Corners are bucketed by vertex range, so each shard sums into vertices no other shard
+	// touches; within a shard they stay in triangle order, so the sums match a serial pass.
+	void accumulateNormalsSharded(MeshData& mesh, size_t vertex_count, unsigned int thread_count)
+	{
+		const size_t block = 65536;
+		size_t triangle_count = mesh.indices.size() / 3;
+		size_t triangle_blocks = (triangle_count + block - 1) / block;
+		auto shardOf = [&](unsigned int v) { return (size_t)((uint64_t)v * kShardCount / vertex_count); };
+		auto position = [&](unsigned int v) { const float* p = &mesh.vertices[(size_t)v * 6]; return glm::vec3(p[0], p[1], p[2]); };
+
+		// 1. face normals, and how many corners each triangle block has in each shard
+		std::vector<glm::vec3> face_normals(triangle_count);
+		std::vector<size_t> shard_slots(triangle_blocks * kShardCount, 0);
+		parallelFor(triangle_blocks, thread_count, [&](size_t b) {
+			size_t* counts = &shard_slots[b * kShardCount];
+			for (size_t t = b * block; t < std::min(triangle_count, (b + 1) * block); t++)
+			{
+				const unsigned int* corner = &mesh.indices[t * 3];
+				glm::vec3 pa = position(corner[0]);
+				face_normals[t] = glm::cross(position(corner[1]) - pa, position(corner[2]) - pa);
+				for (int k = 0; k < 3; k++)
+					counts[shardOf(corner[k])]++;
+			}
+		});
+
+		// 2. shard-major offsets, then every block writes its corners into its own slots
+		std::vector<size_t> shard_begin(kShardCount + 1, 0);
+		size_t slot_count = 0;
+		for (size_t s = 0; s < kShardCount; s++)
+		{
+			shard_begin[s] = slot_count;
+			for (size_t b = 0; b < triangle_blocks; b++)
+			{
+				size_t count = shard_slots[b * kShardCount + s];
+				shard_slots[b * kShardCount + s] = slot_count;
+				slot_count += count;
+			}
+		}
+		shard_begin[kShardCount] = slot_count;
+		std::vector<unsigned int> slot_vertices(slot_count);
+		std::vector<unsigned int> slot_triangles(slot_count);
+		parallelFor(triangle_blocks, thread_count, [&](size_t b) {
+			size_t* next = &shard_slots[b * kShardCount];
+			for (size_t t = b * block; t < std::min(triangle_count, (b + 1) * block); t++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int v = mesh.indices[t * 3 + k];
+					size_t slot = next[shardOf(v)]++;
+					slot_vertices[slot] = v;
+					slot_triangles[slot] = (unsigned int)t;
+				}
+			}
+		});
+
+		// 3. sum per shard
+		parallelFor(kShardCount, thread_count, [&](size_t s) {
+			for (size_t slot = shard_begin[s]; slot < shard_begin[s + 1]; slot++)
+			{
+				float* n = &mesh.vertices[(size_t)slot_vertices[slot] * 6 + 3];
+				const glm::vec3& f = face_normals[slot_triangles[slot]];
+				n[0] += f.x;
+				n[1] += f.y;
+				n[2] += f.z;
+			}
+		});
+	}
+}
+
+bool importObj(const std::string& filename, MeshData& mesh, unsigned int thread_count)
+{
+	MappedFile file;
+	if (!file.open(filename))
+		return false;
+
+	thread_count = resolveThreadCount(thread_count);
+	const char* text = (const char*)file.data();
+	std::vector<TextRange> ranges = splitLines(text, text + file.size(), thread_count);
+	std::vector<ObjChunk> chunks(ranges.size());
+
+	// 1. parse every chunk independently
+	parallelFor(chunks.size(), thread_count, [&](size_t i) { parseObjChunk(ranges[i], chunks[i]); });
+
+	// 2. chunk offsets
+	size_t position_count = 0, normal_count = 0, flat_count = 0, corner_count = 0, triangle_count = 0;
+	for (ObjChunk& chunk : chunks)
+	{
+		if (!chunk.error.empty())
+		{
+			std::cerr << filename << ": " << chunk.error << std::endl;
+			return false;
+		}
+		chunk.position_base = position_count;
+		chunk.normal_base = normal_count;
+		chunk.flat_base = flat_count;
+		chunk.corner_base = corner_count;
+		chunk.triangle_base = triangle_count;
+		position_count += chunk.positions.size();
+		normal_count += chunk.normals.size();
+		flat_count += chunk.flat_faces;
+		corner_count += chunk.corner_positions.size();
+		triangle_count += chunk.triangles;
+	}
+	if (position_count >= 0xFFFFFFFFull || normal_count + flat_count >= 0xFFFFFFFFull || corner_count >= 0xFFFFFFFFull)
+	{
+		std::cerr << filename << ": mesh is too large" << std::endl;
+		return false;
+	}
+
+	std::vector<glm::vec3> positions(position_count);
+	std::vector<glm::vec3> normals(normal_count + flat_count);
+	parallelFor(chunks.size(), thread_count, [&](size_t i) {
+		ObjChunk& chunk = chunks[i];
+		std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.position_base);
+		std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normal_base);
+		chunk.positions = std::vector<glm::vec3>();
+		chunk.normals = std::vector<glm::vec3>();
+	});
+
+	// 3. resolve indices into (position, normal) keys
+	parallelFor(chunks.size(), thread_count, [&](size_t i) { resolveObjChunk(chunks[i], positions, normals, normal_count); });
+	for (const ObjChunk& chunk : chunks)
+	{
+		if (!chunk.error.empty())
+		{
+			std::cerr << filename << ": " << chunk.error << std::endl;
+			return false;
+		}
+	}
+
+	// 4. scatter corners into hash shards, keeping global corner order inside each shard
+	std::vector<size_t> shard_counts(chunks.size() * kShardCount, 0);
+	parallelFor(chunks.size(), thread_count, [&](size_t i) {
+		size_t* counts = &shard_counts[i * kShardCount];
+		for (uint64_t key : chunks[i].keys)
+			counts[shardOf(mixHash(key))]++;
+	});
+
+	std::vector<size_t> shard_offsets(chunks.size() * kShardCount);
+	std::vector<size_t> shard_begin(kShardCount + 1, 0);
+	size_t offset = 0;
+	for (size_t s = 0; s < kShardCount; s++)
+	{
+		shard_begin[s] = offset;
+		for (size_t c = 0; c < chunks.size(); c++)
+		{
+			shard_offsets[c * kShardCount + s] = offset;
+			offset += shard_counts[c * kShardCount + s];
+		}
+	}
+	shard_begin[kShardCount] = offset;
+
+	std::vector<uint64_t> bucket_keys(corner_count);
+	std::vector<uint32_t> bucket_corners(corner_count);
+	parallelFor(chunks.size(), thread_count, [&](size_t i) {
+		size_t* offsets = &shard_offsets[i * kShardCount];
+		const std::vector<uint64_t>& keys = chunks[i].keys;
+		for (size_t k = 0; k < keys.size(); k++)
+		{
+			size_t slot = offsets[shardOf(mixHash(keys[k]))]++;
+			bucket_keys[slot] = keys[k];
+			bucket_corners[slot] = (uint32_t)(chunks[i].corner_base + k);
+		}
+	});
+
+	// 5. dedup each shard on its own; ids follow first occurrence so the result is deterministic
+	std::vector<uint32_t> corner_vertices(corner_count);
+	std::vector<KeyIndex> shards(kShardCount);
+	parallelFor(kShardCount, thread_count, [&](size_t s) {
+		KeyIndex& index = shards[s];
+		index.reserve(shard_begin[s + 1] - shard_begin[s]);
+		for (size_t b = shard_begin[s]; b < shard_begin[s + 1]; b++)
+			corner_vertices[bucket_corners[b]] = index.insert(bucket_keys[b], mixHash(bucket_keys[b]));
+		index.slots = std::vector<uint64_t>();
+		index.ids = std::vector<uint32_t>();
+	});
+	bucket_keys = std::vector<uint64_t>();
+	bucket_corners = std::vector<uint32_t>();
+
+	std::vector<size_t> vertex_base(kShardCount + 1, 0);
+	for (size_t s = 0; s < kShardCount; s++)
+		vertex_base[s + 1] = vertex_base[s] + shards[s].unique.size();
+
+	// 6. emit vertices per shard and triangles per chunk
+	mesh.vertices.resize(vertex_base[kShardCount] * 6);
+	parallelFor(kShardCount, thread_count, [&](size_t s) {
+		float* dst = mesh.vertices.data() + vertex_base[s] * 6;
+		for (uint64_t key : shards[s].unique)
+		{
+			const glm::vec3& pos = positions[key >> 32];
+			const glm::vec3& nrm = normals[key & 0xFFFFFFFFull];
+			*dst++ = pos.x; *dst++ = pos.y; *dst++ = pos.z;
+			*dst++ = nrm.x; *dst++ = nrm.y; *dst++ = nrm.z;
+		}
+	});
+
+	mesh.indices.resize(triangle_count * 3);
+	parallelFor(chunks.size(), thread_count, [&](size_t i) {
+		const ObjChunk& chunk = chunks[i];
+		unsigned int* dst = mesh.indices.data() + chunk.triangle_base * 3;
+		size_t corner = chunk.corner_base;
+		for (size_t k = 0; k < chunk.keys.size(); k++)
+			corner_vertices[corner + k] += (uint32_t)vertex_base[shardOf(mixHash(chunk.keys[k]))];
+		for (uint32_t face : chunk.face_sizes)
+		{
+			// triangle fan around the first corner
+			uint32_t corners = face & 0x7FFFFFFFu;
+			for (uint32_t c = 2; c < corners; c++)
+			{
+				*dst++ = corner_vertices[corner];
+				*dst++ = corner_vertices[corner + c - 1];
+				*dst++ = corner_vertices[corner + c];
+			}
+			corner += corners;
+		}
+	});
+
+	return !mesh.indices.empty();
+}
+
+bool importPly(const std::string& filename, MeshData& mesh, unsigned int thread_count)
+{
+	MappedFile file;
+	if (!file.open(filename))
+		return false;
+
+	thread_count = resolveThreadCount(thread_count);
+	const char* p = (const char*)file.data();
+	const char* end = p + file.size();
+
+	// header
+	size_t vertex_count = 0, face_count = 0, vertex_properties = 0;
+	int position_property[3] = { -1, -1, -1 };
+	int normal_property[3] = { -1, -1, -1 };
+	bool in_vertex = false, faces_first = false, ascii = false;
+	if (end - p < 3 || memcmp(p, "ply", 3) != 0)
+	{
+		std::cerr << filename << ": not a PLY file" << std::endl;
+		return false;
+	}
+	while (true)
+	{
+		const char* eol = lineEnd(p, end);
+		std::string line(p, eol);
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		p = eol < end ? eol + 1 : end;
+
+		if (line.rfind("format ", 0) == 0)
+		{
+			ascii = line.find("ascii") != std::string::npos;
+		}
+		else if (line.rfind("element ", 0) == 0)
+		{
+			in_vertex = line.rfind("element vertex ", 0) == 0;
+			size_t count = strtoull(line.c_str() + line.rfind(' ') + 1, nullptr, 10);
+			if (in_vertex)
+				vertex_count = count;
+			else if (line.rfind("element face ", 0) == 0)
+			{
+				face_count = count;
+				faces_first = vertex_count == 0;
+			}
+		}
+		else if (line.rfind("property ", 0) == 0 && in_vertex)
+		{
+			std::string name = line.substr(line.rfind(' ') + 1);
+			const char* axes[3] = { "x", "y", "z" };
+			const char* normal_axes[3] = { "nx", "ny", "nz" };
+			for (int c = 0; c < 3; c++)
+			{
+				if (name == axes[c])
+					position_property[c] = (int)vertex_properties;
+				if (name == normal_axes[c])
+					normal_property[c] = (int)vertex_properties;
+			}
+			vertex_properties++;
+		}
+		else if (line == "end_header")
+		{
+			break;
+		}
+		if (p >= end)
+		{
+			std::cerr << filename << ": truncated PLY header" << std::endl;
+			return false;
+		}
+	}
+	if (!ascii || faces_first || position_property[0] < 0 || position_property[1] < 0 || position_property[2] < 0)
+	{
+		std::cerr << filename << ": only ASCII PLY with vertex x/y/z before faces is supported" << std::endl;
+		return false;
+	}
+	bool has_normals = normal_property[0] >= 0 && normal_property[1] >= 0 && normal_property[2] >= 0;
+
+	// each chunk needs its first line number to know whether it holds vertices or faces
+	std::vector<TextRange> ranges = splitLines(p, end, thread_count);
+	std::vector<size_t> first_line(ranges.size() + 1, 0);
+	parallelFor(ranges.size(), thread_count, [&](size_t i) {
+		size_t lines = 0;
+		for (const char* q = ranges[i].begin; (q = (const char*)memchr(q, '\n', (size_t)(ranges[i].end - q))) != nullptr; q++)
+			lines++;
+		first_line[i + 1] = lines;
+	});
+	for (size_t i = 0; i < ranges.size(); i++)
+		first_line[i + 1] += first_line[i];
+
+	mesh.vertices.assign(vertex_count * 6, 0.0f);
+	std::vector<std::vector<unsigned int>> chunk_indices(ranges.size());
+	std::vector<std::string> errors(ranges.size());
+	parallelFor(ranges.size(), thread_count, [&](size_t i) {
+		std::vector<float> values(vertex_properties);
+		size_t line = first_line[i];
+		for (const char* q = ranges[i].begin; q < ranges[i].end; line++)
+		{
+			const char* eol = lineEnd(q, ranges[i].end);
+			if (line < vertex_count)
+			{
+				const char* v = q;
+				for (size_t k = 0; k < vertex_properties; k++)
+				{
+					if (!(v = parseFloat(v, eol, values[k])))
+					{
+						errors[i] = "malformed vertex: " + excerpt(q, ranges[i].end);
+						return;
+					}
+				}
+				float* dst = &mesh.vertices[line * 6];
+				for (int c = 0; c < 3; c++)
+				{
+					dst[c] = values[position_property[c]];
+					dst[3 + c] = has_normals ? values[normal_property[c]] : 0.0f;
+				}
+			}
+			else if (line < vertex_count + face_count)
+			{
+				int64_t corners = 0, first = 0, previous = 0, index = 0;
+				const char* f = parseInt(q, eol, corners);
+				for (int64_t c = 0; f && c < corners; c++)
+				{
+					if (!(f = parseInt(f, eol, index)) || index < 0 || index >= (int64_t)vertex_count)
+						break;
+					if (c == 0)
+						first = index;
+					else if (c >= 2)
+						chunk_indices[i].insert(chunk_indices[i].end(), { (unsigned int)first, (unsigned int)previous, (unsigned int)index });
+					previous = index;
+				}
+				if (!f || index < 0 || index >= (int64_t)vertex_count)
+				{
+					errors[i] = "malformed face: " + excerpt(q, ranges[i].end);
+					return;
+				}
+			}
+			q = eol < ranges[i].end ? eol + 1 : ranges[i].end;
+		}
+	});
+	for (const std::string& error : errors)
+	{
+		if (!error.empty())
+		{
+			std::cerr << filename << ": " << error << std::endl;
+			return false;
+		}
+	}
+
+	std::vector<size_t> index_base(ranges.size() + 1, 0);
+	for (size_t i = 0; i < ranges.size(); i++)
+		index_base[i + 1] = index_base[i] + chunk_indices[i].size();
+	mesh.indices.resize(index_base.back());
+	parallelFor(ranges.size(), thread_count, [&](size_t i) {
+		std::copy(chunk_indices[i].begin(), chunk_indices[i].end(), mesh.indices.begin() + index_base[i]);
+	});
+
+	if (!has_normals)
+	{
+		// area-weighted vertex normals: the unnormalized cross product is twice the face area
+		const size_t block = 65536;
+		size_t triangle_count = mesh.indices.size() / 3;
+		size_t triangle_blocks = (triangle_count + block - 1) / block;
+		auto position = [&](unsigned int v) { const float* p = &mesh.vertices[(size_t)v * 6]; return glm::vec3(p[0], p[1], p[2]); };
+		if (thread_count <= 1 || triangle_blocks <= 1)
+		{
+			for (size_t t = 0; t < triangle_count; t++)
+			{
+				const unsigned int* corner = &mesh.indices[t * 3];
+				glm::vec3 pa = position(corner[0]);
+				glm::vec3 n = glm::cross(position(corner[1]) - pa, position(corner[2]) - pa);
+				for (int k = 0; k < 3; k++)
+				{
+					float* v = &mesh.vertices[(size_t)corner[k] * 6 + 3];
+					v[0] += n.x;
+					v[1] += n.y;
+					v[2] += n.z;
+				}
+			}
+		}
+		else
+		{
+			accumulateNormalsSharded(mesh, vertex_count, thread_count);
+		}
+		parallelFor((vertex_count + block - 1) / block, thread_count, [&](size_t b) {
+			for (size_t v = b * block; v < std::min(vertex_count, (b + 1) * block); v++)
+			{
+				float* n = &mesh.vertices[v * 6 + 3];
+				float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (len > 0.0f)
+				{
+					n[0] /= len;
+					n[1] /= len;
+					n[2] /= len;
+				}
+			}
+		});
+	}
+
+	return !mesh.indices.empty();
+}
+
+bool importMesh(const std::string& filename, MeshData& mesh, unsigned int thread_count)
+{
+	if (hasExtension(filename, ".ply"))
+		return importPly(filename, mesh, thread_count);
+	return importObj(filename, mesh, thread_count);
+}
+
+bool convertToMeshFile(const std::string& source_filename, const std::string& mesh_filename, const VertexFormat& format)
+{
+	MeshData data;
+	if (!importMesh(source_filename, data))
+	{
+		std::cerr << "Failed to import mesh: " << source_filename << std::endl;
+		return false;
+	}
+	PackedMesh packed;
+	if (!packMesh(data.vertices, data.indices, format, packed))
+	{
+		std::cerr << "Failed to pack mesh: " << source_filename << std::endl;
+		return false;
+	}
+	return writeMeshFile(mesh_filename, packed);
+}
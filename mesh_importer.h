@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "vertex_format.h"
+
+// Indexed mesh in the main_draggable5 layout: interleaved position(3) + normal(3) floats.
+struct MeshData
+{
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+
+	size_t vertexCount() const { return vertices.size() / 6; }
+};
+
+// Text mesh importers. The mapped file is split into line-aligned chunks that are
+// parsed in parallel with std::from_chars; thread_count 0 uses every hardware thread.
+
+// Wavefront OBJ: v, vn and f records. Polygons are fan triangulated and faces without
+// normals get a flat face normal. (position, normal) pairs are deduplicated with a
+// sharded hash, so the output is identical for any thread count.
+bool importObj(const std::string& filename, MeshData& mesh, unsigned int thread_count = 0);
+
+// ASCII PLY with float x/y/z (and optionally nx/ny/nz) vertex properties and a face
+// vertex_indices list. Meshes without normals get area-weighted vertex normals.
+bool importPly(const std::string& filename, MeshData& mesh, unsigned int thread_count = 0);
+
+// Picks the importer from the file extension.
+bool importMesh(const std::string& filename, MeshData& mesh, unsigned int thread_count = 0);
+
+// Converts an OBJ/PLY into the binary .mesh format read by MeshFile.
+bool convertToMeshFile(const std::string& source_filename, const std::string& mesh_filename, const VertexFormat& format = VertexFormat());
@@ -5,18 +5,24 @@
 #include <iostream>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "memory_telemetry.h"
 
 Shader::Shader() {
 }
 
-void Shader::init(const std::string& vertex_code, const std::string& fragment_code) {
+bool Shader::init(const std::string& vertex_code, const std::string& fragment_code) {
 	vertex_code_ = vertex_code;
 	fragment_code_ = fragment_code;
-	compile();
-	link();
+	if (vertex_code_.empty() || fragment_code_.empty()) {
+		std::cout << "Empty Shader source" << std::endl;
+		return false;
+	}
+	if (!compile())
+		return false;
+	return link();
 }
 
-void Shader::compile() {
+bool Shader::compile() {
 	const char* vcode = vertex_code_.c_str();
 	vertex_id_ = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertex_id_, 1, &vcode, NULL);
@@ -26,23 +32,39 @@ void Shader::compile() {
 	fragment_id_ = glCreateShader(GL_FRAGMENT_SHADER);
 	glShaderSource(fragment_id_, 1, &fcode, NULL);
 	glCompileShader(fragment_id_);
-	checkCompileErr();
+	if (checkCompileErr())
+		return true;
+	glDeleteShader(vertex_id_);
+	glDeleteShader(fragment_id_);
+	return false;
 }
 
-void Shader::link() {
+bool Shader::link() {
 	id_ = glCreateProgram();
 	glAttachShader(id_, vertex_id_);
 	glAttachShader(id_, fragment_id_);
 	glLinkProgram(id_);
-	checkLinkingErr();
 	glDeleteShader(vertex_id_);
 	glDeleteShader(fragment_id_);
+	if (!checkLinkingErr()) {
+		glDeleteProgram(id_);
+		id_ = 0;
+		return false;
+	}
+	trackProgram(id_, "Shader");
+	return true;
 }
 
 void Shader::use() {
     glUseProgram(id_);
 }
 
+void Shader::destroy() {
+	if (id_)
+		trackedDeleteProgram(id_);
+	id_ = 0;
+}
+
 template<>
 void Shader::setUniform<int>(const std::string& name, int val) {
 	glUniform1i(glGetUniformLocation(id_, name.c_str()), val);
@@ -68,32 +90,43 @@ void Shader::setUniform<float>(const std::string& name, float val1, float val2,
 	glUniform3f(glGetUniformLocation(id_, name.c_str()), val1, val2, val3);
 }
 
+template<>
+void Shader::setUniform<float>(const std::string& name, float val1, float val2, float val3, float val4) {
+	glUniform4f(glGetUniformLocation(id_, name.c_str()), val1, val2, val3, val4);
+}
+
 template<>
 void Shader::setUniform<float*>(const std::string& name, float* val) {
 	glUniformMatrix4fv(glGetUniformLocation(id_, name.c_str()), 1, GL_FALSE, val);
 }
 
-void Shader::checkCompileErr() {
+bool Shader::checkCompileErr() {
     int success;
+    bool ok = true;
     char infoLog[1024];
     glGetShaderiv(vertex_id_, GL_COMPILE_STATUS, &success);
     if (!success) {
         glGetShaderInfoLog(vertex_id_, 1024, NULL, infoLog);
         std::cout << "Error compiling Vertex Shader:\n" << infoLog << std::endl;
+        ok = false;
     }
 	glGetShaderiv(fragment_id_, GL_COMPILE_STATUS, &success);
 	if (!success) {
 		glGetShaderInfoLog(fragment_id_, 1024, NULL, infoLog);
 		std::cout << "Error compiling Fragment Shader:\n" << infoLog << std::endl;
+		ok = false;
 	}
+	return ok;
 }
 
-void Shader::checkLinkingErr() {
+bool Shader::checkLinkingErr() {
 	int success;
 	char infoLog[1024];
 	glGetProgramiv(id_, GL_LINK_STATUS, &success);
 	if (!success) {
 		glGetProgramInfoLog(id_, 1024, NULL, infoLog);
 		std::cout << "Error Linking Shader Program:\n" << infoLog << std::endl;
+		return false;
 	}
+	return true;
 }
@@ -8,18 +8,23 @@ class Shader
 {
 public:
 	Shader();
-	void init(const std::string& vertex_code, const std::string& fragment_code);
+	// False, with the log on stdout and no program left behind, when a source is empty or
+	// compiling or linking fails
+	bool init(const std::string& vertex_code, const std::string& fragment_code);
 	void use();
+	// Deletes the program; the owner calls it while the context is still current
+	void destroy();
 	template<typename T> void setUniform(const std::string& name, T val);
 	template<typename T> void setUniform(const std::string& name, T val1, T val2);
 	template<typename T> void setUniform(const std::string& name, T val1, T val2, T val3);
+	template<typename T> void setUniform(const std::string& name, T val1, T val2, T val3, T val4);
 
 private:
-	void checkCompileErr();
-	void checkLinkingErr();
-	void compile();
-	void link();
-	unsigned int vertex_id_, fragment_id_, id_;
+	bool checkCompileErr();
+	bool checkLinkingErr();
+	bool compile();
+	bool link();
+	unsigned int vertex_id_ = 0, fragment_id_ = 0, id_ = 0;
 	std::string vertex_code_;
 	std::string fragment_code_;
 };
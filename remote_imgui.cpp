@@ -0,0 +1,1042 @@
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "remote_imgui.h"
+#include "memory_telemetry.h"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+#if defined(_WIN32)
+	typedef SOCKET Socket;
+	const Socket kNoSocket = INVALID_SOCKET;
+	const int kShutdownBoth = SD_BOTH;
+	const int kSendFlags = 0;
+
+	bool startSockets()
+	{
+		static bool started = []() {
+			WSADATA data;
+			return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+		}();
+		return started;
+	}
+	void closeSocket(Socket socket) { closesocket(socket); }
+	int pollSockets(pollfd* fds, int count, int timeout_ms) { return WSAPoll(fds, count, timeout_ms); }
+#else
+	typedef int Socket;
+	const Socket kNoSocket = -1;
+	const int kShutdownBoth = SHUT_RDWR;
+#if defined(MSG_NOSIGNAL)
+	const int kSendFlags = MSG_NOSIGNAL;  // a viewer going away is an error, not a SIGPIPE
+#else
+	const int kSendFlags = 0;
+#endif
+
+	bool startSockets() { return true; }
+	void closeSocket(Socket socket) { close(socket); }
+	int pollSockets(pollfd* fds, int count, int timeout_ms) { return poll(fds, (nfds_t)count, timeout_ms); }
+#endif
+
+	Socket toSocket(int64_t handle) { return handle < 0 ? kNoSocket : (Socket)handle; }
+	int64_t fromSocket(Socket socket) { return socket == kNoSocket ? -1 : (int64_t)socket; }
+
+	const uint32_t kProtocolVersion = 1;
+	const uint32_t kMaxMessage = 1u << 30;
+	const uint32_t kMaxInputMessage = 1u << 20;
+	// equal runs shorter than this cost more as a (same, literal) pair than as literal bytes
+	const size_t kMinRun = 8;
+
+	enum MessageType : uint32_t
+	{
+		kHello = 1,    // version, sizeof(ImDrawVert), sizeof(ImDrawIdx)
+		kFrame = 2,    // RemoteFrameEncoder output
+		kTexture = 3,  // id, width, height, RGBA8 pixels
+		kInput = 4     // InputEvents
+	};
+
+	struct MessageHeader
+	{
+		uint32_t type;
+		uint32_t size;
+	};
+
+	static_assert(sizeof(RemoteCommand) == 40, "RemoteCommand travels as raw bytes");
+
+	void configureSocket(Socket socket)
+	{
+		int one = 1;
+		setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));  // fails harmlessly on Unix sockets
+#if defined(SO_NOSIGPIPE)
+		setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&one, sizeof(one));
+#endif
+	}
+
+	// A listening or connected socket for address; see remote_imgui.h for the forms
+	Socket openSocket(const std::string& address, bool listening)
+	{
+		if (!startSockets())
+		{
+			std::cerr << "Failed to initialize sockets" << std::endl;
+			return kNoSocket;
+		}
+#if !defined(_WIN32)
+		if (address.compare(0, 5, "unix:") == 0)
+		{
+			std::string path = address.substr(5);
+			sockaddr_un unix_address = {};
+			unix_address.sun_family = AF_UNIX;
+			if (path.empty() || path.size() >= sizeof(unix_address.sun_path))
+			{
+				std::cerr << "Bad socket path " << path << std::endl;
+				return kNoSocket;
+			}
+			memcpy(unix_address.sun_path, path.c_str(), path.size() + 1);
+			Socket socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+			if (socket == kNoSocket)
+				return kNoSocket;
+			if (listening)
+				unlink(path.c_str());  // left over from an earlier run
+			bool ok = listening ? bind(socket, (const sockaddr*)&unix_address, sizeof(unix_address)) == 0 && listen(socket, 1) == 0
+			                    : connect(socket, (const sockaddr*)&unix_address, sizeof(unix_address)) == 0;
+			if (!ok)
+			{
+				if (listening)
+					std::cerr << "Failed to listen on " << address << ": " << strerror(errno) << std::endl;
+				closeSocket(socket);
+				return kNoSocket;
+			}
+			return socket;
+		}
+#endif
+		std::string host = "127.0.0.1", port = address;
+		size_t colon = address.rfind(':');
+		if (colon != std::string::npos)
+		{
+			port = address.substr(colon + 1);
+			if (colon > 0)
+				host = address.substr(0, colon);
+		}
+		addrinfo hints = {};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = listening ? AI_PASSIVE : 0;
+		addrinfo* results = nullptr;
+		int error = getaddrinfo(host.c_str(), port.c_str(), &hints, &results);
+		if (error != 0)
+		{
+			std::cerr << "Can't resolve " << address << ": " << gai_strerror(error) << std::endl;
+			return kNoSocket;
+		}
+		Socket socket = kNoSocket;
+		for (addrinfo* info = results; info && socket == kNoSocket; info = info->ai_next)
+		{
+			socket = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+			if (socket == kNoSocket)
+				continue;
+			int one = 1;
+			if (listening)
+				setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+			bool ok = listening ? bind(socket, info->ai_addr, (int)info->ai_addrlen) == 0 && listen(socket, 1) == 0
+			                    : connect(socket, info->ai_addr, (int)info->ai_addrlen) == 0;
+			if (!ok)
+			{
+				closeSocket(socket);
+				socket = kNoSocket;
+			}
+		}
+		freeaddrinfo(results);
+		// a viewer retries until the app is up, so only a failed listen is worth a message
+		if (socket != kNoSocket)
+			configureSocket(socket);
+		else if (listening)
+			std::cerr << "Failed to listen on " << address << std::endl;
+		return socket;
+	}
+
+	// Waits up to timeout_ms for socket to have data, or a connection to accept
+	bool waitReadable(Socket socket, int timeout_ms)
+	{
+		pollfd fd = {};
+		fd.fd = socket;
+		fd.events = POLLIN;
+		return pollSockets(&fd, 1, timeout_ms) > 0;
+	}
+
+	bool sendAll(Socket socket, const void* data, size_t size)
+	{
+		const char* bytes = (const char*)data;
+		while (size > 0)
+		{
+			int sent = (int)::send(socket, bytes, (int)std::min<size_t>(size, 1 << 30), kSendFlags);
+			if (sent <= 0)
+				return false;
+			bytes += sent;
+			size -= (size_t)sent;
+		}
+		return true;
+	}
+
+	// Blocks until size bytes arrived, the peer is gone or stop is set
+	bool receiveAll(Socket socket, void* data, size_t size, const std::atomic<bool>& stop)
+	{
+		char* bytes = (char*)data;
+		while (size > 0)
+		{
+			if (stop)
+				return false;
+			if (!waitReadable(socket, 100))
+				continue;
+			int received = (int)recv(socket, bytes, (int)std::min<size_t>(size, 1 << 30), 0);
+			if (received <= 0)
+				return false;
+			bytes += received;
+			size -= (size_t)received;
+		}
+		return true;
+	}
+
+	bool receiveMessage(Socket socket, MessageHeader& header, std::vector<uint8_t>& payload, uint32_t max_size, const std::atomic<bool>& stop)
+	{
+		if (!receiveAll(socket, &header, sizeof(header), stop) || header.size > max_size)
+			return false;
+		payload.resize(header.size);
+		return receiveAll(socket, payload.data(), header.size, stop);
+	}
+
+	template <typename T>
+	void put(std::vector<uint8_t>& out, const T& value)
+	{
+		const uint8_t* bytes = (const uint8_t*)&value;
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	void putVarint(std::vector<uint8_t>& out, uint64_t value)
+	{
+		for (; value >= 0x80; value >>= 7)
+			out.push_back((uint8_t)(value | 0x80));
+		out.push_back((uint8_t)value);
+	}
+
+	size_t beginMessage(std::vector<uint8_t>& out, MessageType type)
+	{
+		size_t at = out.size();
+		put(out, MessageHeader{ type, 0 });
+		return at;
+	}
+
+	void endMessage(std::vector<uint8_t>& out, size_t at)
+	{
+		uint32_t size = (uint32_t)(out.size() - at - sizeof(MessageHeader));
+		memcpy(out.data() + at + offsetof(MessageHeader, size), &size, sizeof(size));
+	}
+
+	struct Reader
+	{
+		const uint8_t* data;
+		size_t size;
+		size_t at = 0;
+
+		const uint8_t* bytes(uint64_t count)
+		{
+			if (count > size - at)
+				return nullptr;
+			const uint8_t* result = data + at;
+			at += (size_t)count;
+			return result;
+		}
+
+		template <typename T>
+		bool get(T& value)
+		{
+			const uint8_t* source = bytes(sizeof(T));
+			if (source)
+				memcpy(&value, source, sizeof(T));
+			return source != nullptr;
+		}
+
+		bool varint(uint64_t& value)
+		{
+			value = 0;
+			for (int shift = 0; shift < 64 && at < size; shift += 7)
+			{
+				uint8_t byte = data[at++];
+				value |= (uint64_t)(byte & 0x7F) << shift;
+				if (!(byte & 0x80))
+					return true;
+			}
+			return false;
+		}
+	};
+
+	// end of the run of bytes equal in data and base from i on, base_size bounding it
+	size_t equalRun(const uint8_t* data, const uint8_t* base, size_t i, size_t common)
+	{
+		for (; i + 8 <= common; i += 8)
+		{
+			uint64_t a, b;
+			memcpy(&a, data + i, 8);
+			memcpy(&b, base + i, 8);
+			if (a != b)
+				break;
+		}
+		while (i < common && data[i] == base[i])
+			i++;
+		return i;
+	}
+
+	// The size, then (bytes equal to base, literal bytes) length pairs, each followed by its
+	// literal bytes
+	void putDelta(std::vector<uint8_t>& out, const void* data_bytes, size_t size, const void* base_bytes, size_t base_size)
+	{
+		const uint8_t* data = (const uint8_t*)data_bytes;
+		const uint8_t* base = (const uint8_t*)base_bytes;
+		size_t common = std::min(size, base_size);
+		putVarint(out, size);
+		size_t i = 0;
+		while (i < size)
+		{
+			size_t same_end = equalRun(data, base, i, common);
+			size_t literal_end = same_end;
+			while (literal_end < size)
+			{
+				if (literal_end >= common)
+				{
+					literal_end = size;
+					break;
+				}
+				if (data[literal_end] != base[literal_end])
+				{
+					literal_end++;
+					continue;
+				}
+				size_t run_end = equalRun(data, base, literal_end, common);
+				if (run_end - literal_end >= kMinRun)
+					break;
+				literal_end = run_end;
+			}
+			putVarint(out, same_end - i);
+			putVarint(out, literal_end - same_end);
+			out.insert(out.end(), data + same_end, data + literal_end);
+			i = literal_end;
+		}
+	}
+
+	bool getDelta(Reader& in, const std::vector<uint8_t>* base, std::vector<uint8_t>& out)
+	{
+		uint64_t size;
+		if (!in.varint(size) || size > kMaxMessage)
+			return false;
+		size_t base_size = base ? base->size() : 0;
+		out.resize((size_t)size);
+		size_t at = 0;
+		while (at < out.size())
+		{
+			uint64_t same, literal;
+			if (!in.varint(same) || !in.varint(literal) || same + literal == 0)
+				return false;
+			if (same > out.size() - at || at + same > base_size)
+				return false;
+			if (same > 0)
+				memcpy(out.data() + at, base->data() + at, (size_t)same);
+			at += (size_t)same;
+			const uint8_t* bytes = literal <= out.size() - at ? in.bytes(literal) : nullptr;
+			if (!bytes)
+				return false;
+			memcpy(out.data() + at, bytes, (size_t)literal);
+			at += (size_t)literal;
+		}
+		return true;
+	}
+
+	bool sameList(const RemoteDrawList& a, const RemoteDrawList& b)
+	{
+		return a.vertices == b.vertices && a.indices == b.indices && a.commands.size() == b.commands.size() &&
+			memcmp(a.commands.data(), b.commands.data(), a.commands.size() * sizeof(RemoteCommand)) == 0;
+	}
+
+	enum ListKind : uint8_t
+	{
+		kUnchanged = 0,  // index of the previous frame's list
+		kDelta = 1       // 1 + index of the base list or 0 for none, owner, vertices, indices, commands
+	};
+}
+
+void RemoteFrameEncoder::encode(const RemoteFrame& frame, std::vector<uint8_t>& out)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		put(out, frame.display_pos[i]);
+		put(out, frame.display_size[i]);
+		put(out, frame.framebuffer_scale[i]);
+	}
+	putVarint(out, frame.lists.size());
+
+	// each previous list is the base of at most one list: the first with the same owner, or
+	// failing that the one at the same index
+	std::unordered_map<std::string, size_t> by_owner;
+	for (size_t i = previous_.lists.size(); i-- > 0;)
+		by_owner[previous_.lists[i]->owner] = i;
+	std::vector<bool> used(previous_.lists.size());
+	for (size_t i = 0; i < frame.lists.size(); i++)
+	{
+		const RemoteDrawList& list = *frame.lists[i];
+		size_t base = SIZE_MAX;
+		auto owner = by_owner.find(list.owner);
+		if (owner != by_owner.end() && !used[owner->second])
+			base = owner->second;
+		else if (i < used.size() && !used[i])
+			base = i;
+		const RemoteDrawList* base_list = base != SIZE_MAX ? previous_.lists[base].get() : nullptr;
+		if (base_list)
+			used[base] = true;
+
+		if (base_list && (base_list == &list || sameList(*base_list, list)))
+		{
+			out.push_back(kUnchanged);
+			putVarint(out, base);
+			continue;
+		}
+		static const RemoteDrawList kEmpty;
+		const RemoteDrawList& from = base_list ? *base_list : kEmpty;
+		out.push_back(kDelta);
+		putVarint(out, base_list ? base + 1 : 0);
+		putVarint(out, list.owner.size());
+		out.insert(out.end(), list.owner.begin(), list.owner.end());
+		putDelta(out, list.vertices.data(), list.vertices.size(), from.vertices.data(), from.vertices.size());
+		putDelta(out, list.indices.data(), list.indices.size(), from.indices.data(), from.indices.size());
+		putDelta(out, list.commands.data(), list.commands.size() * sizeof(RemoteCommand), from.commands.data(), from.commands.size() * sizeof(RemoteCommand));
+	}
+	previous_ = frame;
+}
+
+bool RemoteFrameDecoder::decode(const uint8_t* data, size_t size, RemoteFrame& frame)
+{
+	Reader in{ data, size };
+	frame = RemoteFrame();
+	for (int i = 0; i < 2; i++)
+	{
+		if (!in.get(frame.display_pos[i]) || !in.get(frame.display_size[i]) || !in.get(frame.framebuffer_scale[i]))
+			return false;
+	}
+	uint64_t count;
+	if (!in.varint(count) || count > (1 << 20))
+		return false;
+	std::vector<uint8_t> commands;
+	for (uint64_t i = 0; i < count; i++)
+	{
+		uint8_t kind;
+		uint64_t base;
+		if (!in.get(kind) || !in.varint(base))
+			return false;
+		if (kind == kUnchanged)
+		{
+			if (base >= previous_.lists.size())
+				return false;
+			frame.lists.push_back(previous_.lists[(size_t)base]);
+			continue;
+		}
+		if (kind != kDelta || base > previous_.lists.size())
+			return false;
+		const RemoteDrawList* from = base > 0 ? previous_.lists[(size_t)base - 1].get() : nullptr;
+		auto list = std::make_shared<RemoteDrawList>();
+		uint64_t owner_size;
+		const uint8_t* owner = in.varint(owner_size) ? in.bytes(owner_size) : nullptr;
+		if (!owner)
+			return false;
+		list->owner.assign((const char*)owner, (size_t)owner_size);
+		std::vector<uint8_t> base_commands;
+		if (from)
+			base_commands.assign((const uint8_t*)from->commands.data(), (const uint8_t*)(from->commands.data() + from->commands.size()));
+		if (!getDelta(in, from ? &from->vertices : nullptr, list->vertices) || !getDelta(in, from ? &from->indices : nullptr, list->indices) ||
+			!getDelta(in, &base_commands, commands) || commands.size() % sizeof(RemoteCommand) != 0)
+			return false;
+		list->commands.resize(commands.size() / sizeof(RemoteCommand));
+		memcpy(list->commands.data(), commands.data(), commands.size());
+		frame.lists.push_back(std::move(list));
+	}
+	if (in.at != size)
+		return false;
+	previous_ = frame;
+	return true;
+}
+
+bool parseRemoteOptions(int argc, char** argv, RemoteOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--remote") != 0)
+			continue;
+		if (i + 1 >= argc)
+		{
+			std::cerr << "--remote needs an address, e.g. 127.0.0.1:7071\n";
+			return false;
+		}
+		options.listen_address = argv[++i];
+	}
+	return true;
+}
+
+RemoteServer::RemoteServer()
+{
+}
+
+RemoteServer::~RemoteServer()
+{
+	stop();
+}
+
+bool RemoteServer::listen(const std::string& address)
+{
+	stop();
+	Socket listener = openSocket(address, true);
+	if (listener == kNoSocket)
+		return false;
+	address_ = address;
+	listener_ = fromSocket(listener);
+	listening_ = true;
+	accept_thread_ = std::thread(&RemoteServer::acceptLoop, this);
+	send_thread_ = std::thread(&RemoteServer::sendLoop, this);
+	return true;
+}
+
+int RemoteServer::port() const
+{
+	if (!listening_)
+		return -1;
+	sockaddr_storage bound = {};
+	socklen_t size = sizeof(bound);
+	if (getsockname(toSocket(listener_), (sockaddr*)&bound, &size) != 0)
+		return -1;
+	if (bound.ss_family == AF_INET)
+		return ntohs(((const sockaddr_in*)&bound)->sin_port);
+	if (bound.ss_family == AF_INET6)
+		return ntohs(((const sockaddr_in6*)&bound)->sin6_port);
+	return -1;
+}
+
+void RemoteServer::stop()
+{
+	if (!listening_)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+		if (client_ >= 0)
+			shutdown(toSocket(client_), kShutdownBoth);
+	}
+	wake_.notify_all();
+	accept_thread_.join();
+	send_thread_.join();
+	closeSocket(toSocket(listener_));
+	listener_ = -1;
+#if !defined(_WIN32)
+	if (address_.compare(0, 5, "unix:") == 0)
+		unlink(address_.c_str() + 5);
+#endif
+	listening_ = false;
+	stopping_ = false;
+}
+
+void RemoteServer::acceptLoop()
+{
+	Socket listener = toSocket(listener_);
+	std::vector<uint8_t> payload;
+	while (!stopping_)
+	{
+		if (!waitReadable(listener, 100))
+			continue;
+		Socket client = accept(listener, nullptr, nullptr);
+		if (client == kNoSocket)
+			continue;
+		configureSocket(client);
+		std::vector<uint8_t> hello;
+		size_t at = beginMessage(hello, kHello);
+		put(hello, kProtocolVersion);
+		put(hello, (uint32_t)sizeof(ImDrawVert));
+		put(hello, (uint32_t)sizeof(ImDrawIdx));
+		endMessage(hello, at);
+		if (!sendAll(client, hello.data(), hello.size()))
+		{
+			closeSocket(client);
+			continue;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			client_ = fromSocket(client);
+			connection_++;
+			input_.clear();
+		}
+		connected_ = true;
+
+		// input until the viewer goes away
+		MessageHeader header;
+		while (receiveMessage(client, header, payload, kMaxInputMessage, stopping_))
+		{
+			if (header.type != kInput || header.size % sizeof(InputEvent) != 0)
+				continue;
+			std::lock_guard<std::mutex> lock(mutex_);
+			size_t count = header.size / sizeof(InputEvent);
+			size_t first = input_.size();
+			input_.resize(first + count);
+			memcpy(input_.data() + first, payload.data(), header.size);
+		}
+
+		connected_ = false;
+		std::unique_lock<std::mutex> lock(mutex_);
+		client_ = -1;
+		shutdown(client, kShutdownBoth);
+		// the send thread may still be writing to it
+		wake_.wait(lock, [this]() { return !sending_; });
+		closeSocket(client);
+	}
+}
+
+void RemoteServer::sendLoop()
+{
+	std::vector<uint8_t> message;
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (;;)
+	{
+		wake_.wait(lock, [this]() { return sending_ || stopping_; });
+		if (stopping_)
+			break;
+		Socket client = toSocket(client_);
+		message.swap(outgoing_);
+		lock.unlock();
+		bool sent = client != kNoSocket && sendAll(client, message.data(), message.size());
+		if (sent)
+		{
+			bytes_sent_ += message.size();
+			frames_sent_++;
+		}
+		lock.lock();
+		// hand the buffer back for the next frame
+		outgoing_.swap(message);
+		sending_ = false;
+		if (!sent && client != kNoSocket && client_ == fromSocket(client))
+			shutdown(client, kShutdownBoth);
+		wake_.notify_all();
+	}
+	sending_ = false;
+	wake_.notify_all();
+}
+
+void RemoteServer::newFrame(GLFWwindow* window)
+{
+	std::vector<InputEvent> events;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (input_.empty())
+			return;
+		events.swap(input_);
+	}
+	for (const InputEvent& event : events)
+		dispatchInputEvent(window, event);
+	input_events_ += events.size();
+}
+
+void RemoteServer::setTexture(ImTextureID id, int width, int height, const void* rgba)
+{
+	Texture& texture = textures_[(uint64_t)(uintptr_t)id];
+	texture.width = width;
+	texture.height = height;
+	texture.pixels.assign((const uint8_t*)rgba, (const uint8_t*)rgba + (size_t)width * height * 4);
+	texture.version++;
+}
+
+void RemoteServer::queueTextures(std::vector<uint8_t>& message)
+{
+	ImFontAtlas* fonts = ImGui::GetIO().Fonts;
+	unsigned char* pixels = nullptr;
+	int width = 0, height = 0;
+	fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+	// rebuilt, or handed a new id by the renderer
+	if (pixels && (pixels != font_pixels_ || !textures_.count((uint64_t)(uintptr_t)fonts->TexID)))
+	{
+		font_pixels_ = pixels;
+		setTexture(fonts->TexID, width, height, pixels);
+	}
+
+	for (auto& it : textures_)
+	{
+		uint64_t& sent = sent_textures_[it.first];
+		if (sent == it.second.version)
+			continue;
+		sent = it.second.version;
+		size_t at = beginMessage(message, kTexture);
+		put(message, it.first);
+		put(message, (uint32_t)it.second.width);
+		put(message, (uint32_t)it.second.height);
+		message.insert(message.end(), it.second.pixels.begin(), it.second.pixels.end());
+		endMessage(message, at);
+	}
+}
+
+void RemoteServer::capture(const ImDrawData* draw_data, RemoteFrame& frame) const
+{
+	frame.display_pos[0] = draw_data->DisplayPos.x;
+	frame.display_pos[1] = draw_data->DisplayPos.y;
+	frame.display_size[0] = draw_data->DisplaySize.x;
+	frame.display_size[1] = draw_data->DisplaySize.y;
+	frame.framebuffer_scale[0] = draw_data->FramebufferScale.x;
+	frame.framebuffer_scale[1] = draw_data->FramebufferScale.y;
+	for (int i = 0; i < draw_data->CmdLists.Size; i++)
+	{
+		const ImDrawList* source = draw_data->CmdLists[i];
+		auto list = std::make_shared<RemoteDrawList>();
+		list->owner = source->_OwnerName ? source->_OwnerName : "";
+		list->vertices.assign((const uint8_t*)source->VtxBuffer.Data, (const uint8_t*)(source->VtxBuffer.Data + source->VtxBuffer.Size));
+		list->indices.assign((const uint8_t*)source->IdxBuffer.Data, (const uint8_t*)(source->IdxBuffer.Data + source->IdxBuffer.Size));
+		list->commands.reserve(source->CmdBuffer.Size);
+		for (const ImDrawCmd& cmd : source->CmdBuffer)
+		{
+			bool reset = cmd.UserCallback == ImDrawCallback_ResetRenderState;
+			if ((cmd.UserCallback && !reset) || (!cmd.UserCallback && cmd.ElemCount == 0))
+				continue;
+			RemoteCommand command = {};
+			command.clip_rect[0] = cmd.ClipRect.x;
+			command.clip_rect[1] = cmd.ClipRect.y;
+			command.clip_rect[2] = cmd.ClipRect.z;
+			command.clip_rect[3] = cmd.ClipRect.w;
+			command.texture = (uint64_t)(uintptr_t)cmd.GetTexID();
+			command.vtx_offset = cmd.VtxOffset;
+			command.idx_offset = cmd.IdxOffset;
+			command.elem_count = cmd.ElemCount;
+			command.reset_render_state = reset ? 1 : 0;
+			list->commands.push_back(command);
+		}
+		frame.lists.push_back(std::move(list));
+	}
+}
+
+void RemoteServer::send(const ImDrawData* draw_data)
+{
+	if (!connected_ || !draw_data || !draw_data->Valid)
+		return;
+	uint64_t connection;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (sending_)
+		{
+			frames_skipped_++;
+			return;
+		}
+		connection = connection_;
+	}
+	// a new viewer has nothing to apply deltas to
+	if (connection != encoded_connection_)
+	{
+		encoded_connection_ = connection;
+		encoder_.reset();
+		sent_textures_.clear();
+	}
+
+	message_.clear();
+	queueTextures(message_);
+	RemoteFrame frame;
+	capture(draw_data, frame);
+	size_t at = beginMessage(message_, kFrame);
+	encoder_.encode(frame, message_);
+	endMessage(message_, at);
+	uint64_t raw = at + sizeof(MessageHeader) + 7 * sizeof(float);
+	for (const auto& list : frame.lists)
+		raw += list->vertices.size() + list->indices.size() + list->commands.size() * sizeof(RemoteCommand);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		// the viewer this was encoded for has gone; the next frame starts over for the new one
+		if (connection_ != encoded_connection_)
+			return;
+		outgoing_.swap(message_);
+		sending_ = true;
+	}
+	raw_bytes_ += raw;
+	wake_.notify_all();
+}
+
+RemoteStats RemoteServer::stats() const
+{
+	RemoteStats stats;
+	stats.listening = listening_;
+	stats.connected = connected_;
+	stats.frames_sent = frames_sent_;
+	stats.frames_skipped = frames_skipped_;
+	stats.bytes_sent = bytes_sent_;
+	stats.raw_bytes = raw_bytes_;
+	stats.input_events = input_events_;
+	return stats;
+}
+
+RemoteClient::RemoteClient()
+{
+}
+
+RemoteClient::~RemoteClient()
+{
+	disconnect();
+}
+
+bool RemoteClient::connect(const std::string& address)
+{
+	disconnect();
+	Socket socket = openSocket(address, false);
+	if (socket == kNoSocket)
+		return false;
+	MessageHeader header;
+	std::vector<uint8_t> payload;
+	Reader hello{ nullptr, 0 };
+	uint32_t version = 0, vertex_size = 0, index_size = 0;
+	bool ok = receiveMessage(socket, header, payload, 64, stopping_) && header.type == kHello;
+	if (ok)
+	{
+		hello = Reader{ payload.data(), payload.size() };
+		ok = hello.get(version) && hello.get(vertex_size) && hello.get(index_size);
+	}
+	if (!ok || version != kProtocolVersion || vertex_size != sizeof(ImDrawVert) || index_size != sizeof(ImDrawIdx))
+	{
+		std::cerr << address << " is not a compatible remote ImGui app" << std::endl;
+		closeSocket(socket);
+		return false;
+	}
+	socket_ = fromSocket(socket);
+	connected_ = true;
+	receive_thread_ = std::thread(&RemoteClient::receiveLoop, this);
+	return true;
+}
+
+void RemoteClient::disconnect()
+{
+	if (socket_ < 0)
+		return;
+	stopping_ = true;
+	shutdown(toSocket(socket_), kShutdownBoth);
+	receive_thread_.join();
+	closeSocket(toSocket(socket_));
+	socket_ = -1;
+	stopping_ = false;
+	connected_ = false;
+	std::lock_guard<std::mutex> lock(mutex_);
+	latest_.reset();
+}
+
+void RemoteClient::receiveLoop()
+{
+	Socket socket = toSocket(socket_);
+	RemoteFrameDecoder decoder;
+	MessageHeader header;
+	std::vector<uint8_t> payload;
+	while (receiveMessage(socket, header, payload, kMaxMessage, stopping_))
+	{
+		bytes_received_ += sizeof(header) + header.size;
+		if (header.type == kFrame)
+		{
+			auto frame = std::make_shared<RemoteFrame>();
+			if (!decoder.decode(payload.data(), payload.size(), *frame))
+			{
+				std::cerr << "Malformed remote frame" << std::endl;
+				break;
+			}
+			std::lock_guard<std::mutex> lock(mutex_);
+			latest_ = std::move(frame);
+			frames_received_++;
+		}
+		else if (header.type == kTexture)
+		{
+			Reader in{ payload.data(), payload.size() };
+			Texture texture;
+			uint32_t width = 0, height = 0;
+			if (!in.get(texture.id) || !in.get(width) || !in.get(height) || width > 16384 || height > 16384 ||
+				(uint64_t)width * height * 4 != payload.size() - in.at)
+			{
+				std::cerr << "Malformed remote texture" << std::endl;
+				break;
+			}
+			texture.width = (int)width;
+			texture.height = (int)height;
+			texture.pixels.assign(payload.begin() + in.at, payload.end());
+			std::lock_guard<std::mutex> lock(mutex_);
+			arrived_textures_.push_back(std::move(texture));
+		}
+	}
+	connected_ = false;
+}
+
+std::shared_ptr<const RemoteFrame> RemoteClient::latestFrame() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return latest_;
+}
+
+bool RemoteClient::sendInput(const std::vector<InputEvent>& events)
+{
+	if (!connected_ || events.empty())
+		return connected_;
+	std::vector<uint8_t> message;
+	size_t at = beginMessage(message, kInput);
+	message.insert(message.end(), (const uint8_t*)events.data(), (const uint8_t*)(events.data() + events.size()));
+	endMessage(message, at);
+	std::lock_guard<std::mutex> lock(send_mutex_);
+	return sendAll(toSocket(socket_), message.data(), message.size());
+}
+
+void RemoteClient::uploadTextures()
+{
+	std::vector<Texture> arrived;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		arrived.swap(arrived_textures_);
+	}
+	if (!white_texture_)
+	{
+		// stands in for textures the app never sent
+		const uint32_t white = 0xFFFFFFFF;
+		glGenTextures(1, &white_texture_);
+		glBindTexture(GL_TEXTURE_2D, white_texture_);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		trackedTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white, "RemoteClient placeholder");
+	}
+	for (const Texture& texture : arrived)
+	{
+		unsigned int& id = textures_[texture.id];
+		if (!id)
+			glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D, id);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		trackedTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture.width, texture.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture.pixels.data(), "RemoteClient texture");
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Copies a received list into an ImDrawList, leaving out commands that point outside its buffers
+void RemoteClient::build(const RemoteDrawList& source, BuiltList& built) const
+{
+	ImDrawList& list = *built.list;
+	size_t vertex_count = source.vertices.size() / sizeof(ImDrawVert);
+	size_t index_count = source.indices.size() / sizeof(ImDrawIdx);
+	list.VtxBuffer.resize((int)vertex_count);
+	list.IdxBuffer.resize((int)index_count);
+	memcpy(list.VtxBuffer.Data, source.vertices.data(), vertex_count * sizeof(ImDrawVert));
+	memcpy(list.IdxBuffer.Data, source.indices.data(), index_count * sizeof(ImDrawIdx));
+	list.CmdBuffer.resize(0);
+	built.textures.clear();
+	for (const RemoteCommand& command : source.commands)
+	{
+		ImDrawCmd cmd;
+		if (command.reset_render_state)
+			cmd.UserCallback = ImDrawCallback_ResetRenderState;
+		else
+		{
+			if (command.idx_offset > index_count || command.elem_count > index_count - command.idx_offset)
+				continue;
+			const ImDrawIdx* indices = list.IdxBuffer.Data + command.idx_offset;
+			size_t highest = command.elem_count ? *std::max_element(indices, indices + command.elem_count) : 0;
+			if (command.vtx_offset + highest >= vertex_count)
+				continue;
+		}
+		cmd.ClipRect = ImVec4(command.clip_rect[0], command.clip_rect[1], command.clip_rect[2], command.clip_rect[3]);
+		cmd.VtxOffset = command.vtx_offset;
+		cmd.IdxOffset = command.idx_offset;
+		cmd.ElemCount = command.elem_count;
+		list.CmdBuffer.push_back(cmd);
+		built.textures.push_back(command.texture);
+	}
+}
+
+ImDrawData* RemoteClient::drawData(ImVec2 framebuffer_size)
+{
+	uploadTextures();
+	std::shared_ptr<const RemoteFrame> frame = latestFrame();
+	if (!frame)
+		return nullptr;
+
+	if (frame != built_)
+	{
+		// lists the new frame shares with the last one keep their ImDrawList
+		std::unordered_map<const RemoteDrawList*, size_t> previous;
+		for (size_t i = 0; i < lists_.size(); i++)
+			previous.emplace(lists_[i].source.get(), i);
+		std::vector<BuiltList> lists(frame->lists.size());
+		for (size_t i = 0; i < frame->lists.size(); i++)
+		{
+			auto it = previous.find(frame->lists[i].get());
+			if (it != previous.end() && lists_[it->second].list)
+			{
+				lists[i] = std::move(lists_[it->second]);
+				continue;
+			}
+			lists[i].source = frame->lists[i];
+			lists[i].list = std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData());
+			build(*lists[i].source, lists[i]);
+		}
+		lists_.swap(lists);
+		built_ = frame;
+	}
+
+	// filled directly like DrawDataSnapshot: AddDrawList() checks write cursors only the ImDrawList
+	// API sets
+	draw_data_.CmdLists.resize(0);
+	draw_data_.CmdListsCount = 0;
+	draw_data_.TotalVtxCount = 0;
+	draw_data_.TotalIdxCount = 0;
+	draw_data_.Valid = true;
+	draw_data_.DisplayPos = ImVec2(frame->display_pos[0], frame->display_pos[1]);
+	draw_data_.DisplaySize = ImVec2(frame->display_size[0], frame->display_size[1]);
+	draw_data_.FramebufferScale = ImVec2(frame->display_size[0] > 0.0f ? framebuffer_size.x / frame->display_size[0] : 1.0f,
+		frame->display_size[1] > 0.0f ? framebuffer_size.y / frame->display_size[1] : 1.0f);
+	for (BuiltList& built : lists_)
+	{
+		// textures can arrive after the lists using them
+		for (int i = 0; i < built.list->CmdBuffer.Size; i++)
+		{
+			auto texture = textures_.find(built.textures[i]);
+			built.list->CmdBuffer[i].TextureId = (ImTextureID)(intptr_t)(texture != textures_.end() ? texture->second : white_texture_);
+		}
+		if (built.list->CmdBuffer.Size == 0)
+			continue;
+		draw_data_.CmdLists.push_back(built.list.get());
+		draw_data_.CmdListsCount++;
+		draw_data_.TotalVtxCount += built.list->VtxBuffer.Size;
+		draw_data_.TotalIdxCount += built.list->IdxBuffer.Size;
+	}
+	return &draw_data_;
+}
+
+void RemoteClient::shutdownGL()
+{
+	for (auto& it : textures_)
+		trackedDeleteTextures(1, &it.second);
+	textures_.clear();
+	if (white_texture_)
+		trackedDeleteTextures(1, &white_texture_);
+	white_texture_ = 0;
+	lists_.clear();
+	built_.reset();
+	draw_data_.CmdLists.clear();
+	draw_data_.CmdListsCount = 0;
+	draw_data_.Valid = false;
+}
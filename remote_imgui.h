@@ -0,0 +1,244 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "imgui.h"
+#include "input_recorder.h"
+
+struct GLFWwindow;
+
+// Remote ImGui: an app serializes its ImDrawData every frame and streams it to a viewer, which
+// renders it and sends its input back. Each draw list goes out as a delta against the list of
+// the previous frame with the same owner window: unchanged lists cost a few bytes, and changed
+// ones only the byte runs that differ, so the bandwidth follows what changed on screen. Textures
+// go out once per connection and again when they change.
+//
+// Addresses are "host:port", ":port" or "port" (loopback) for TCP, and "unix:/path" for a Unix
+// domain socket where there are any. Listening on loopback keeps the app private to the
+// machine; reach it from elsewhere through an SSH tunnel, or listen on 0.0.0.0.
+
+// A draw command as it travels: no pointers, and of the callbacks only ResetRenderState, since
+// the others run the app's own GL code
+struct RemoteCommand
+{
+	float clip_rect[4];
+	uint64_t texture;
+	uint32_t vtx_offset;
+	uint32_t idx_offset;
+	uint32_t elem_count;
+	uint32_t reset_render_state;
+};
+
+struct RemoteDrawList
+{
+	std::string owner;  // window name, to match lists across frames when windows reorder
+	std::vector<uint8_t> vertices;  // ImDrawVert
+	std::vector<uint8_t> indices;   // ImDrawIdx
+	std::vector<RemoteCommand> commands;
+};
+
+struct RemoteFrame
+{
+	float display_pos[2] = {};
+	float display_size[2] = {};
+	float framebuffer_scale[2] = { 1.0f, 1.0f };
+	// lists that didn't change are shared with the previous frame
+	std::vector<std::shared_ptr<const RemoteDrawList>> lists;
+};
+
+// Writes frames as deltas against the one encoded before; the decoder on the other end must have
+// decoded every one of them. reset() makes the next frame self-contained.
+class RemoteFrameEncoder
+{
+public:
+	void reset() { previous_ = RemoteFrame(); }
+	// appends the encoded frame to out
+	void encode(const RemoteFrame& frame, std::vector<uint8_t>& out);
+	const RemoteFrame& previous() const { return previous_; }
+
+private:
+	RemoteFrame previous_;
+};
+
+class RemoteFrameDecoder
+{
+public:
+	void reset() { previous_ = RemoteFrame(); }
+	// false on a malformed frame
+	bool decode(const uint8_t* data, size_t size, RemoteFrame& frame);
+
+private:
+	RemoteFrame previous_;
+};
+
+struct RemoteOptions
+{
+	std::string listen_address;
+};
+
+// Reads --remote ADDRESS; anything else is left for the entry point
+bool parseRemoteOptions(int argc, char** argv, RemoteOptions& options);
+
+struct RemoteStats
+{
+	bool listening = false;
+	bool connected = false;
+	uint64_t frames_sent = 0;
+	// frames not sent because the previous one was still going out
+	uint64_t frames_skipped = 0;
+	uint64_t bytes_sent = 0;
+	// what the frames sent would have taken without the deltas
+	uint64_t raw_bytes = 0;
+	uint64_t input_events = 0;
+};
+
+// The app end. Accepts one viewer at a time on a background thread and sends from another, so
+// a slow link never blocks a frame: a frame produced while the previous one is still being sent
+// is skipped, and the next one is encoded against what the viewer last got.
+class RemoteServer
+{
+public:
+	RemoteServer();
+	~RemoteServer();
+	RemoteServer(const RemoteServer&) = delete;
+	RemoteServer& operator=(const RemoteServer&) = delete;
+
+	bool listen(const std::string& address);
+	void stop();
+	bool listening() const { return listening_; }
+	bool connected() const { return connected_; }
+	// The TCP port listened on, which is how to find the one picked for port 0; -1 when not
+	// listening on TCP
+	int port() const;
+
+	// UI thread, right after glfwPollEvents(): feeds the viewer's input to the ImGui GLFW backend
+	void newFrame(GLFWwindow* window);
+	// UI thread, after ImGui::Render()
+	void send(const ImDrawData* draw_data);
+	// An image the app draws with ImGui::Image(), for the viewer; RGBA8, width * height * 4
+	// bytes. The font atlas is sent without this.
+	void setTexture(ImTextureID id, int width, int height, const void* rgba);
+
+	RemoteStats stats() const;
+
+private:
+	struct Texture
+	{
+		int width = 0, height = 0;
+		std::vector<uint8_t> pixels;
+		uint64_t version = 0;
+	};
+
+	void acceptLoop();
+	void sendLoop();
+	void capture(const ImDrawData* draw_data, RemoteFrame& frame) const;
+	void queueTextures(std::vector<uint8_t>& message);
+
+	std::string address_;
+	std::atomic<bool> listening_{ false };
+	std::atomic<bool> connected_{ false };
+	std::atomic<bool> stopping_{ false };
+	std::thread accept_thread_;
+	std::thread send_thread_;
+
+	// the socket of the connected viewer; handles are stored as int64_t to keep the platform
+	// headers out of here
+	mutable std::mutex mutex_;
+	std::condition_variable wake_;
+	int64_t listener_ = -1;
+	int64_t client_ = -1;
+	uint64_t connection_ = 0;       // bumped on every accept
+	std::vector<uint8_t> outgoing_; // the message being sent
+	bool sending_ = false;
+	std::vector<InputEvent> input_;
+
+	// UI thread
+	uint64_t encoded_connection_ = 0;
+	RemoteFrameEncoder encoder_;
+	std::vector<uint8_t> message_;
+	std::map<uint64_t, Texture> textures_;
+	std::map<uint64_t, uint64_t> sent_textures_;  // id -> version
+	const void* font_pixels_ = nullptr;  // the atlas last sent, to notice a rebuild
+
+	std::atomic<uint64_t> frames_sent_{ 0 };
+	std::atomic<uint64_t> frames_skipped_{ 0 };
+	std::atomic<uint64_t> bytes_sent_{ 0 };
+	std::atomic<uint64_t> raw_bytes_{ 0 };
+	std::atomic<uint64_t> input_events_{ 0 };
+};
+
+// The viewer end: receives and decodes frames on a background thread; the GL thread uploads the
+// textures and renders the newest frame. Input goes back with sendInput().
+class RemoteClient
+{
+public:
+	RemoteClient();
+	~RemoteClient();
+	RemoteClient(const RemoteClient&) = delete;
+	RemoteClient& operator=(const RemoteClient&) = delete;
+
+	// false, quietly, when nothing listens there yet
+	bool connect(const std::string& address);
+	void disconnect();
+	bool connected() const { return connected_; }
+
+	// the newest frame, nullptr before the first one
+	std::shared_ptr<const RemoteFrame> latestFrame() const;
+	// events with positions in the app's coordinates
+	bool sendInput(const std::vector<InputEvent>& events);
+
+	// GL thread: uploads the textures that arrived, then turns the newest frame into draw data for
+	// ImGui_ImplOpenGL3_RenderDrawData, scaled to fill framebuffer_size. nullptr before the first frame.
+	ImDrawData* drawData(ImVec2 framebuffer_size);
+	// GL thread, before the context goes away
+	void shutdownGL();
+
+	uint64_t framesReceived() const { return frames_received_; }
+	uint64_t bytesReceived() const { return bytes_received_; }
+
+private:
+	struct Texture
+	{
+		uint64_t id = 0;
+		int width = 0, height = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	struct BuiltList
+	{
+		std::shared_ptr<const RemoteDrawList> source;
+		std::unique_ptr<ImDrawList> list;
+		std::vector<uint64_t> textures;  // the app's id of each command
+	};
+
+	void receiveLoop();
+	void uploadTextures();
+	void build(const RemoteDrawList& source, BuiltList& built) const;
+
+	std::atomic<bool> connected_{ false };
+	std::atomic<bool> stopping_{ false };
+	std::thread receive_thread_;
+	int64_t socket_ = -1;
+	std::mutex send_mutex_;
+
+	mutable std::mutex mutex_;
+	std::shared_ptr<const RemoteFrame> latest_;
+	std::vector<Texture> arrived_textures_;
+	std::atomic<uint64_t> frames_received_{ 0 };
+	std::atomic<uint64_t> bytes_received_{ 0 };
+
+	// GL thread
+	std::map<uint64_t, unsigned int> textures_;  // the app's id -> GL texture
+	unsigned int white_texture_ = 0;
+	std::shared_ptr<const RemoteFrame> built_;
+	std::vector<BuiltList> lists_;
+	ImDrawData draw_data_;
+};
@@ -0,0 +1,220 @@
+// dear-imgui-viewer: shows the UI of an app started with --remote ADDRESS and sends the mouse and
+// keyboard input back to it.
+//
+//   dear-imgui-viewer [ADDRESS]
+//
+// ADDRESS defaults to 127.0.0.1:7071; see remote_imgui.h for the forms. The viewer keeps trying
+// to connect every second, so either end can be started first and the app can be restarted.
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include "imgui.h"
+#include "bindings/imgui_impl_opengl3.h"
+#include "headless.h"
+#include "remote_imgui.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Viewer
+    {
+        RemoteClient client;
+        std::vector<InputEvent> events;
+        ImVec2 remote_size = ImVec2(0.0f, 0.0f);
+    };
+
+    Viewer *viewerOf(GLFWwindow *window)
+    {
+        return (Viewer *)glfwGetWindowUserPointer(window);
+    }
+
+    void push(GLFWwindow *window, InputEventType type, int action, int mods, int a, int b)
+    {
+        InputEvent event = {};
+        event.type = type;
+        event.action = (uint8_t)action;
+        event.mods = (uint16_t)mods;
+        event.i[0] = a;
+        event.i[1] = b;
+        viewerOf(window)->events.push_back(event);
+    }
+
+    void pushFloats(GLFWwindow *window, InputEventType type, float x, float y)
+    {
+        InputEvent event = {};
+        event.type = type;
+        event.f[0] = x;
+        event.f[1] = y;
+        viewerOf(window)->events.push_back(event);
+    }
+
+    // the app's window may be a different size than this one
+    void onCursorPos(GLFWwindow *window, double x, double y)
+    {
+        Viewer *viewer = viewerOf(window);
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        float scaleX = width > 0 && viewer->remote_size.x > 0.0f ? viewer->remote_size.x / width : 1.0f;
+        float scaleY = height > 0 && viewer->remote_size.y > 0.0f ? viewer->remote_size.y / height : 1.0f;
+        pushFloats(window, InputEventType::CursorPos, (float)x * scaleX, (float)y * scaleY);
+    }
+
+    void onMouseButton(GLFWwindow *window, int button, int action, int mods)
+    {
+        push(window, InputEventType::MouseButton, action, mods, button, 0);
+    }
+
+    void onScroll(GLFWwindow *window, double x, double y)
+    {
+        pushFloats(window, InputEventType::Scroll, (float)x, (float)y);
+    }
+
+    void onKey(GLFWwindow *window, int key, int scancode, int action, int mods)
+    {
+        push(window, InputEventType::Key, action, mods, key, scancode);
+    }
+
+    void onChar(GLFWwindow *window, unsigned int codepoint)
+    {
+        push(window, InputEventType::Char, 0, 0, (int)codepoint, 0);
+    }
+
+    void onCursorEnter(GLFWwindow *window, int entered)
+    {
+        push(window, InputEventType::CursorEnter, 0, 0, entered, 0);
+    }
+
+    void onWindowFocus(GLFWwindow *window, int focused)
+    {
+        push(window, InputEventType::WindowFocus, 0, 0, focused, 0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string address = argc > 1 ? argv[1] : "127.0.0.1:7071";
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "ERROR: INITIALIZING GLFW\n");
+        return 1;
+    }
+#if defined(__APPLE__)
+    const char *glslVersion = "#version 150";
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+    const char *glslVersion = "#version 130";
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+#endif
+    GLFWwindow *window = glfwCreateWindow(1280, 720, "dear-imgui-viewer", NULL, NULL);
+    if (window == NULL)
+    {
+        fprintf(stderr, "ERROR: CREATING WINDOW\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(1);
+    if (!initGlew())
+    {
+        fprintf(stderr, "ERROR: SETTING UP OPENGL\n");
+        return 1;
+    }
+
+    // only the renderer backend: the input goes to the app, not to a local ImGui
+    ImGui::CreateContext();
+    ImGui::GetIO().IniFilename = NULL;
+    ImGui_ImplOpenGL3_Init(glslVersion);
+
+    Viewer viewer;
+    glfwSetWindowUserPointer(window, &viewer);
+    glfwSetCursorPosCallback(window, onCursorPos);
+    glfwSetMouseButtonCallback(window, onMouseButton);
+    glfwSetScrollCallback(window, onScroll);
+    glfwSetKeyCallback(window, onKey);
+    glfwSetCharCallback(window, onChar);
+    glfwSetCursorEnterCallback(window, onCursorEnter);
+    glfwSetWindowFocusCallback(window, onWindowFocus);
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point lastAttempt, lastTitle = Clock::now();
+    bool sized = false;
+    bool waiting = false;
+    uint64_t lastFrames = 0, lastBytes = 0;
+    while (!glfwWindowShouldClose(window))
+    {
+        glfwPollEvents();
+        Clock::time_point now = Clock::now();
+        if (!viewer.client.connected() && now - lastAttempt >= std::chrono::seconds(1))
+        {
+            lastAttempt = now;
+            if (viewer.client.connect(address))
+            {
+                printf("Connected to %s\n", address.c_str());
+                // the app's GLFW backend polls its own cursor until it hears the mouse entered
+                onCursorEnter(window, glfwGetWindowAttrib(window, GLFW_HOVERED));
+                sized = false;
+                waiting = false;
+                lastFrames = viewer.client.framesReceived();
+                lastBytes = viewer.client.bytesReceived();
+            }
+            else if (!waiting)
+            {
+                printf("Waiting for an app on %s\n", address.c_str());
+                waiting = true;
+            }
+        }
+        viewer.client.sendInput(viewer.events);
+        viewer.events.clear();
+
+        int displayW, displayH;
+        glfwGetFramebufferSize(window, &displayW, &displayH);
+        glViewport(0, 0, displayW, displayH);
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        // creates the device objects on the first call
+        ImGui_ImplOpenGL3_NewFrame();
+        if (ImDrawData *drawData = viewer.client.drawData(ImVec2((float)displayW, (float)displayH)))
+        {
+            viewer.remote_size = drawData->DisplaySize;
+            if (!sized && drawData->DisplaySize.x > 0.0f && drawData->DisplaySize.y > 0.0f)
+            {
+                glfwSetWindowSize(window, (int)drawData->DisplaySize.x, (int)drawData->DisplaySize.y);
+                sized = true;
+            }
+            ImGui_ImplOpenGL3_RenderDrawData(drawData);
+        }
+
+        double elapsed = std::chrono::duration<double>(now - lastTitle).count();
+        if (elapsed >= 0.5)
+        {
+            uint64_t frames = viewer.client.framesReceived(), bytes = viewer.client.bytesReceived();
+            char title[256];
+            if (viewer.client.connected())
+                snprintf(title, sizeof(title), "dear-imgui-viewer - %s - %.0f FPS, %.1f KB/s", address.c_str(),
+                         (frames - lastFrames) / elapsed, (bytes - lastBytes) / elapsed / 1024.0);
+            else
+                snprintf(title, sizeof(title), "dear-imgui-viewer - waiting for %s", address.c_str());
+            glfwSetWindowTitle(window, title);
+            lastFrames = frames;
+            lastBytes = bytes;
+            lastTitle = now;
+        }
+        glfwSwapBuffers(window);
+    }
+
+    viewer.client.disconnect();
+    viewer.client.shutdownGL();
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui::DestroyContext();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,227 @@
+#include "scene_graph.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+	const uint32_t kNoParent = UINT32_MAX;
+	// subtrees smaller than this are updated as a single job
+	const uint32_t kParallelSubtreeSize = 4096;
+
+	glm::mat4 composeLocal(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale)
+	{
+		glm::mat4 local = glm::translate(glm::mat4(1.0f), translation);
+		local = glm::rotate(local, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		local = glm::rotate(local, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		local = glm::rotate(local, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		return glm::scale(local, scale);
+	}
+
+	template <typename T>
+	void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+	{
+		std::vector<T> permuted(values.size());
+		for (size_t i = 0; i < order.size(); i++)
+			permuted[i] = values[order[i]];
+		values.swap(permuted);
+	}
+}
+
+SceneNode SceneGraph::create(SceneNode parent)
+{
+	uint32_t parent_position = parent == kInvalidNode ? kNoParent : position_[parent];
+	uint32_t position = (uint32_t)node_.size();
+
+	// a child belongs at the end of its parent's subtree; anywhere else needs a reorder
+	if (ordered_ && parent_position != kNoParent && parent_position + subtree_size_[parent_position] != position)
+		ordered_ = false;
+	for (uint32_t ancestor = parent_position; ancestor != kNoParent; ancestor = parent_[ancestor])
+		subtree_size_[ancestor]++;
+
+	SceneNode node = (SceneNode)position_.size();
+	position_.push_back(position);
+	node_.push_back(node);
+	translation_.push_back(glm::vec3(0.0f));
+	rotation_.push_back(glm::vec3(0.0f));
+	scale_.push_back(glm::vec3(1.0f));
+	parent_.push_back(parent_position);
+	subtree_size_.push_back(1);
+	world_.push_back(glm::mat4(1.0f));
+	dirty_.push_back(0);
+	markDirty(position);
+	return node;
+}
+
+void SceneGraph::clear()
+{
+	translation_.clear();
+	rotation_.clear();
+	scale_.clear();
+	parent_.clear();
+	subtree_size_.clear();
+	world_.clear();
+	dirty_.clear();
+	node_.clear();
+	position_.clear();
+	dirty_nodes_.clear();
+	updated_ranges_.clear();
+	ordered_ = true;
+}
+
+void SceneGraph::setTranslation(SceneNode node, const glm::vec3& translation)
+{
+	translation_[position_[node]] = translation;
+	markDirty(position_[node]);
+}
+
+void SceneGraph::setRotation(SceneNode node, const glm::vec3& rotation)
+{
+	rotation_[position_[node]] = rotation;
+	markDirty(position_[node]);
+}
+
+void SceneGraph::setScale(SceneNode node, const glm::vec3& scale)
+{
+	scale_[position_[node]] = scale;
+	markDirty(position_[node]);
+}
+
+void SceneGraph::markDirty(uint32_t position)
+{
+	if (!dirty_[position])
+	{
+		dirty_[position] = 1;
+		dirty_nodes_.push_back(node_[position]);
+	}
+}
+
+size_t SceneGraph::update(JobSystem* jobs)
+{
+	if (!ordered_)
+		reorder();
+
+	std::vector<uint32_t> dirty_positions;
+	dirty_positions.reserve(dirty_nodes_.size());
+	for (SceneNode node : dirty_nodes_)
+	{
+		dirty_positions.push_back(position_[node]);
+		dirty_[position_[node]] = 0;
+	}
+	dirty_nodes_.clear();
+	std::sort(dirty_positions.begin(), dirty_positions.end());
+
+	// dirty nodes inside an already dirty subtree are covered by that subtree's range
+	updated_ranges_.clear();
+	for (uint32_t position : dirty_positions)
+	{
+		if (!updated_ranges_.empty() && position < updated_ranges_.back().second)
+			continue;
+		updated_ranges_.emplace_back(position, position + subtree_size_[position]);
+	}
+
+	size_t updated = 0;
+	for (const auto& range : updated_ranges_)
+		updated += range.second - range.first;
+
+	if (!jobs || jobs->threadCount() <= 1 || updated < kParallelSubtreeSize)
+	{
+		for (const auto& range : updated_ranges_)
+			updateRange(range.first, range.second);
+		return updated;
+	}
+
+	// the ranges are disjoint subtrees; a large one is split by computing its root here
+	// and handing each child subtree (again a contiguous range) to the jobs
+	tasks_.clear();
+	split_ranges_.assign(updated_ranges_.begin(), updated_ranges_.end());
+	while (!split_ranges_.empty())
+	{
+		auto range = split_ranges_.back();
+		split_ranges_.pop_back();
+		if (range.second - range.first < kParallelSubtreeSize)
+		{
+			tasks_.push_back(range);
+			continue;
+		}
+		updateRange(range.first, range.first + 1);
+		for (uint32_t child = range.first + 1; child < range.second; child += subtree_size_[child])
+			split_ranges_.emplace_back(child, child + subtree_size_[child]);
+	}
+
+	size_t grain = std::max<size_t>(1, tasks_.size() / (jobs->threadCount() * 16));
+	jobs->parallelFor(tasks_.size(), grain, [this](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			updateRange(tasks_[i].first, tasks_[i].second);
+	});
+	return updated;
+}
+
+void SceneGraph::updateRange(uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i < end; i++)
+	{
+		glm::mat4 local = composeLocal(translation_[i], rotation_[i], scale_[i]);
+		world_[i] = parent_[i] == kNoParent ? local : world_[parent_[i]] * local;
+	}
+}
+
+void SceneGraph::reorder()
+{
+	uint32_t count = (uint32_t)node_.size();
+
+	// children of each node in CSR form, keeping their current relative order
+	std::vector<uint32_t> child_offset(count + 1, 0);
+	for (uint32_t i = 0; i < count; i++)
+		if (parent_[i] != kNoParent)
+			child_offset[parent_[i] + 1]++;
+	for (uint32_t i = 0; i < count; i++)
+		child_offset[i + 1] += child_offset[i];
+	std::vector<uint32_t> children(child_offset[count]);
+	std::vector<uint32_t> fill(child_offset.begin(), child_offset.end() - 1);
+	for (uint32_t i = 0; i < count; i++)
+		if (parent_[i] != kNoParent)
+			children[fill[parent_[i]]++] = i;
+
+	// iterative depth-first walk from each root; order[new position] = old position
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	std::vector<uint32_t> stack;
+	for (uint32_t root = 0; root < count; root++)
+	{
+		if (parent_[root] != kNoParent)
+			continue;
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			uint32_t old_position = stack.back();
+			stack.pop_back();
+			order.push_back(old_position);
+			for (uint32_t c = child_offset[old_position + 1]; c > child_offset[old_position]; c--)
+				stack.push_back(children[c - 1]);
+		}
+	}
+
+	std::vector<uint32_t> new_position(count);
+	for (uint32_t i = 0; i < count; i++)
+		new_position[order[i]] = i;
+	for (uint32_t& parent : parent_)
+		parent = parent == kNoParent ? kNoParent : new_position[parent];
+
+	permute(translation_, order);
+	permute(rotation_, order);
+	permute(scale_, order);
+	permute(parent_, order);
+	permute(world_, order);
+	permute(dirty_, order);
+	permute(node_, order);
+	for (uint32_t i = 0; i < count; i++)
+		position_[node_[i]] = i;
+
+	std::fill(subtree_size_.begin(), subtree_size_.end(), 1);
+	for (uint32_t i = count; i-- > 0;)
+		if (parent_[i] != kNoParent)
+			subtree_size_[parent_[i]] += subtree_size_[i];
+	ordered_ = true;
+}
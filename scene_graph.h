@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+using SceneNode = uint32_t;
+constexpr SceneNode kInvalidNode = UINT32_MAX;
+
+// Transform hierarchy in structure-of-arrays form. Nodes are kept in depth-first
+// preorder, so every subtree is a contiguous range and parents come before their
+// children; update() recomputes world matrices only for the subtrees under nodes
+// that changed since the last update. SceneNode handles stay valid when nodes move.
+class SceneGraph
+{
+public:
+	SceneNode create(SceneNode parent = kInvalidNode);
+	void clear();
+
+	// Local transform: translate * rotate x, y, z (degrees) * scale, same order as the demos used
+	void setTranslation(SceneNode node, const glm::vec3& translation);
+	void setRotation(SceneNode node, const glm::vec3& rotation);
+	void setScale(SceneNode node, const glm::vec3& scale);
+	const glm::vec3& translation(SceneNode node) const { return translation_[position_[node]]; }
+	const glm::vec3& rotation(SceneNode node) const { return rotation_[position_[node]]; }
+	const glm::vec3& scale(SceneNode node) const { return scale_[position_[node]]; }
+
+	// Propagates dirty transforms; returns the number of world matrices recomputed.
+	// With a job system, large dirty subtrees are split into their child subtrees and
+	// recomputed in parallel.
+	size_t update(JobSystem* jobs = nullptr);
+
+	const glm::mat4& world(SceneNode node) const { return world_[position_[node]]; }
+	size_t size() const { return node_.size(); }
+
+	// Preorder positions, valid until the next create()/update()
+	uint32_t position(SceneNode node) const { return position_[node]; }
+	SceneNode nodeAt(uint32_t position) const { return node_[position]; }
+	const glm::mat4* worldMatrices() const { return world_.data(); }
+	// [begin, end) position ranges recomputed by the last update()
+	const std::vector<std::pair<uint32_t, uint32_t>>& updatedRanges() const { return updated_ranges_; }
+
+private:
+	void markDirty(uint32_t position);
+	void updateRange(uint32_t begin, uint32_t end);
+	void reorder();
+
+	// indexed by preorder position
+	std::vector<glm::vec3> translation_, rotation_, scale_;
+	std::vector<uint32_t> parent_;       // position of the parent, UINT32_MAX for roots
+	std::vector<uint32_t> subtree_size_; // the node plus all of its descendants
+	std::vector<glm::mat4> world_;
+	std::vector<uint8_t> dirty_;
+	std::vector<SceneNode> node_;
+
+	std::vector<uint32_t> position_; // indexed by SceneNode
+	std::vector<SceneNode> dirty_nodes_;
+	std::vector<std::pair<uint32_t, uint32_t>> updated_ranges_;
+	std::vector<std::pair<uint32_t, uint32_t>> split_ranges_, tasks_;
+	bool ordered_ = true;
+};
@@ -0,0 +1,96 @@
+#include "size_class_pool.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	const size_t kSlabSize = 64 * 1024;
+	const uint32_t kLargeClass = UINT32_MAX;
+
+	// Every block starts with a 16-byte header holding its class and requested size,
+	// which keeps the payload 16-byte aligned and lets deallocate() find the free list
+	struct BlockHeader
+	{
+		uint32_t size_class;
+		uint32_t padding;
+		uint64_t size;
+	};
+	static_assert(sizeof(BlockHeader) == 16, "header must preserve 16-byte alignment");
+}
+
+SizeClassPool::~SizeClassPool()
+{
+	for (void* slab : slabs_)
+		free(slab);
+}
+
+void* SizeClassPool::allocate(size_t size)
+{
+	allocations_.fetch_add(1, std::memory_order_relaxed);
+	allocated_bytes_.fetch_add(size, std::memory_order_relaxed);
+
+	size_t total = size + kHeaderSize;
+	uint32_t size_class = 0;
+	while (size_class < kClassCount && ((size_t)16 << size_class) < total)
+		size_class++;
+
+	if (size_class == kClassCount)
+	{
+		system_allocations_.fetch_add(1, std::memory_order_relaxed);
+		BlockHeader* header = (BlockHeader*)malloc(total);
+		if (!header)
+			throw std::bad_alloc();
+		header->size_class = kLargeClass;
+		header->size = size;
+		return (uint8_t*)header + kHeaderSize;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!free_lists_[size_class])
+	{
+		// carve a fresh slab into blocks of this class
+		size_t block_size = (size_t)16 << size_class;
+		uint8_t* slab = (uint8_t*)malloc(kSlabSize);
+		if (!slab)
+			throw std::bad_alloc();
+		system_allocations_.fetch_add(1, std::memory_order_relaxed);
+		slabs_.push_back(slab);
+		for (size_t offset = 0; offset + block_size <= kSlabSize; offset += block_size)
+		{
+			FreeBlock* block = (FreeBlock*)(slab + offset);
+			block->next = free_lists_[size_class];
+			free_lists_[size_class] = block;
+		}
+	}
+
+	FreeBlock* block = free_lists_[size_class];
+	free_lists_[size_class] = block->next;
+	BlockHeader* header = (BlockHeader*)block;
+	header->size_class = size_class;
+	header->size = size;
+	return (uint8_t*)header + kHeaderSize;
+}
+
+size_t SizeClassPool::allocationSize(const void* pointer)
+{
+	return pointer ? (size_t)((const BlockHeader*)((const uint8_t*)pointer - kHeaderSize))->size : 0;
+}
+
+void SizeClassPool::deallocate(void* pointer)
+{
+	if (!pointer)
+		return;
+	BlockHeader* header = (BlockHeader*)((uint8_t*)pointer - kHeaderSize);
+	if (header->size_class == kLargeClass)
+	{
+		free(header);
+		return;
+	}
+
+	uint32_t size_class = header->size_class;
+	FreeBlock* block = (FreeBlock*)header;
+	std::lock_guard<std::mutex> lock(mutex_);
+	block->next = free_lists_[size_class];
+	free_lists_[size_class] = block;
+}
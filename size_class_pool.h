@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Thread-safe pool with power-of-two size classes from 16 bytes to 64 KB. Freed blocks
+// go onto their class's free list and are reused; new blocks are carved from 64 KB
+// slabs, so once the working set is warm no request reaches the system allocator.
+// Requests above the largest class fall through to malloc. Memory is returned to the
+// system only when the pool is destroyed.
+class SizeClassPool
+{
+public:
+	SizeClassPool() = default;
+	~SizeClassPool();
+	SizeClassPool(const SizeClassPool&) = delete;
+	SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+	void* allocate(size_t size);
+	void deallocate(void* pointer);
+	// Size originally requested for a pointer returned by allocate()
+	static size_t allocationSize(const void* pointer);
+
+	// Cumulative counters, for per-frame deltas
+	uint64_t allocations() const { return allocations_.load(std::memory_order_relaxed); }
+	uint64_t allocatedBytes() const { return allocated_bytes_.load(std::memory_order_relaxed); }
+	uint64_t systemAllocations() const { return system_allocations_.load(std::memory_order_relaxed); }
+
+	// Signatures match ImGui::SetAllocatorFunctions, with the pool as user data
+	static void* imguiAlloc(size_t size, void* pool) { return ((SizeClassPool*)pool)->allocate(size); }
+	static void imguiFree(void* pointer, void* pool) { ((SizeClassPool*)pool)->deallocate(pointer); }
+
+private:
+	static const int kClassCount = 13; // 16 << 12 = 64 KB
+	static const size_t kHeaderSize = 16;
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	std::mutex mutex_;
+	FreeBlock* free_lists_[kClassCount] = {};
+	std::vector<void*> slabs_;
+	std::atomic<uint64_t> allocations_{ 0 };
+	std::atomic<uint64_t> allocated_bytes_{ 0 };
+	std::atomic<uint64_t> system_allocations_{ 0 };
+};
@@ -0,0 +1,300 @@
+#include "telemetry_plot.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+SampleRing::SampleRing(size_t capacity)
+{
+	size_t size = 1;
+	while (size < capacity)
+		size <<= 1;
+	buffer_.resize(size);
+	mask_ = size - 1;
+}
+
+bool SampleRing::push(float value)
+{
+	size_t head = head_.load(std::memory_order_relaxed);
+	if (head - cached_tail_ >= buffer_.size())
+	{
+		// only re-read the consumer's index when the ring looks full
+		cached_tail_ = tail_.load(std::memory_order_acquire);
+		if (head - cached_tail_ >= buffer_.size())
+		{
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+	}
+	buffer_[head & mask_] = value;
+	head_.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+MinMaxHistory::MinMaxHistory(size_t capacity)
+{
+	// stop adding levels while the top one still has 64 buckets, so when the oldest bucket is
+	// partly rolled off it is a small piece of the history
+	size_t levels = 0, top_bucket = 1;
+	while (top_bucket * 8 * 64 <= capacity)
+	{
+		top_bucket *= 8;
+		levels++;
+	}
+	capacity_ = (std::max<size_t>(capacity, 1) + top_bucket - 1) / top_bucket * top_bucket;
+	samples_.resize(capacity_);
+	levels_.resize(levels);
+	for (size_t k = 1; k <= levels; k++)
+		levels_[k - 1].resize(capacity_ >> (3 * k));
+}
+
+void MinMaxHistory::clear()
+{
+	total_ = 0;
+}
+
+void MinMaxHistory::append(const float* values, size_t count)
+{
+	if (count == 0)
+		return;
+	// of a batch longer than the history only the tail survives
+	uint64_t begin = total_;
+	if (count > capacity_)
+	{
+		begin += count - capacity_;
+		values += count - capacity_;
+	}
+	total_ += count;
+	for (uint64_t index = begin; index < total_;)
+	{
+		size_t slot = (size_t)(index % capacity_);
+		size_t piece = (size_t)std::min<uint64_t>(total_ - index, capacity_ - slot);
+		memcpy(&samples_[slot], values, piece * sizeof(float));
+		values += piece;
+		index += piece;
+	}
+
+	// Rebuild the buckets the new samples touched, each from its 8 children one level down.
+	// Slot counts are multiples of 8, so the children of a bucket never wrap around.
+	uint64_t last = total_ - 1;
+	for (size_t k = 1; k <= levels_.size(); k++)
+	{
+		std::vector<Bucket>& level = levels_[k - 1];
+		unsigned child_shift = (unsigned)(3 * (k - 1));
+		uint64_t last_child = last >> child_shift;
+		for (uint64_t b = begin >> (3 * k); b <= last >> (3 * k); b++)
+		{
+			uint64_t child = b << 3;
+			size_t children = (size_t)std::min<uint64_t>(8, last_child - child + 1);
+			Bucket bucket;
+			if (k == 1)
+			{
+				const float* first = &samples_[(size_t)(child % capacity_)];
+				bucket.min = bucket.max = first[0];
+				for (size_t c = 1; c < children; c++)
+				{
+					bucket.min = std::min(bucket.min, first[c]);
+					bucket.max = std::max(bucket.max, first[c]);
+				}
+			}
+			else
+			{
+				const std::vector<Bucket>& finer = levels_[k - 2];
+				const Bucket* first = &finer[(size_t)(child % finer.size())];
+				bucket = first[0];
+				for (size_t c = 1; c < children; c++)
+				{
+					bucket.min = std::min(bucket.min, first[c].min);
+					bucket.max = std::max(bucket.max, first[c].max);
+				}
+			}
+			level[(size_t)(b % level.size())] = bucket;
+		}
+	}
+}
+
+bool MinMaxHistory::range(uint64_t begin, uint64_t end, float& min, float& max) const
+{
+	if (begin >= end || begin < first() || end > total_)
+		return false;
+	min = FLT_MAX;
+	max = -FLT_MAX;
+	accumulate(begin, end, min, max);
+	return true;
+}
+
+void MinMaxHistory::accumulate(uint64_t begin, uint64_t end, float& min, float& max) const
+{
+	// the coarsest level whose buckets are at most an eighth of the range: 8 to 63 whole ones
+	// cover it, plus the two partial ones at the ends
+	uint64_t length = end - begin;
+	size_t k = 0;
+	while (k < levels_.size() && (uint64_t(8) << (3 * k)) <= length)
+		k++;
+	if (k == 0)
+	{
+		for (uint64_t i = begin; i < end; i++)
+		{
+			float value = sample(i);
+			min = std::min(min, value);
+			max = std::max(max, value);
+		}
+		return;
+	}
+
+	unsigned shift = (unsigned)(3 * k);
+	uint64_t first_bucket = begin >> shift;
+	uint64_t end_bucket = (end + (uint64_t(1) << shift) - 1) >> shift;
+	if ((first_bucket << shift) < first())
+	{
+		// part of the oldest bucket rolled off and its slot now holds the newest one;
+		// take that piece from the finer levels instead
+		accumulate(begin, std::min(end, (first_bucket + 1) << shift), min, max);
+		first_bucket++;
+	}
+	const std::vector<Bucket>& level = levels_[k - 1];
+	for (uint64_t b = first_bucket; b < end_bucket; b++)
+	{
+		const Bucket& bucket = level[(size_t)(b % level.size())];
+		min = std::min(min, bucket.min);
+		max = std::max(max, bucket.max);
+	}
+}
+
+size_t MinMaxHistory::memoryBytes() const
+{
+	size_t bytes = samples_.size() * sizeof(float);
+	for (const std::vector<Bucket>& level : levels_)
+		bytes += level.size() * sizeof(Bucket);
+	return bytes;
+}
+
+TelemetryPlot::TelemetryPlot(size_t history_capacity, size_t ring_capacity)
+	: ring_(ring_capacity), history_(history_capacity)
+{
+}
+
+void TelemetryPlot::update()
+{
+	ring_.drain([this](const float* values, size_t count) { history_.append(values, count); });
+}
+
+void TelemetryPlot::draw(const char* label, ImVec2 size)
+{
+	ImVec2 available_size = ImGui::GetContentRegionAvail();
+	if (size.x <= 0.0f)
+		size.x = std::max(available_size.x + size.x, 64.0f);
+	if (size.y <= 0.0f)
+		size.y = std::max(available_size.y + size.y, 32.0f);
+	ImVec2 p0 = ImGui::GetCursorScreenPos();
+	ImVec2 p1(p0.x + size.x, p0.y + size.y);
+	ImGui::InvisibleButton(label, size);
+	ImGuiIO& io = ImGui::GetIO();
+
+	int width = std::max((int)size.x, 1);
+	double oldest = (double)history_.first();
+	double newest = (double)history_.total();
+	double available = newest - oldest;
+	double visible = view_samples_ > 0.0 ? std::min(view_samples_, available) : available;
+	if (follow_)
+		view_end_ = newest;
+
+	if (ImGui::IsItemHovered() && available > 0.0)
+	{
+		if (io.MouseWheel != 0.0f)
+		{
+			// keep the sample under the cursor where it is; zoom in down to 8 pixels per sample
+			double t = (io.MousePos.x - p0.x) / size.x;
+			double anchor = view_end_ - visible * (1.0 - t);
+			visible = std::clamp(visible * std::pow(0.8, (double)io.MouseWheel), std::min(available, width / 8.0), available);
+			view_samples_ = visible;
+			view_end_ = anchor + visible * (1.0 - t);
+			follow_ = false;
+		}
+		if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+		{
+			view_samples_ = 0.0;
+			visible = available;
+			follow_ = true;
+		}
+	}
+	if (ImGui::IsItemActive() && io.MouseDelta.x != 0.0f)
+	{
+		view_end_ -= io.MouseDelta.x * visible / size.x;
+		follow_ = false;
+	}
+	view_end_ = std::clamp(view_end_, oldest + visible, newest);
+	// panned or zoomed back up to the newest sample: stick to it again
+	if (view_end_ >= newest)
+		follow_ = true;
+
+	ImDrawList* draw_list = ImGui::GetWindowDrawList();
+	draw_list->AddRectFilled(p0, p1, ImGui::GetColorU32(ImGuiCol_FrameBg));
+	float lo = FLT_MAX, hi = -FLT_MAX;
+	double begin = view_end_ - visible;
+	double per_column = visible / width;
+	columns_.clear();
+	if (visible >= 1.0 && per_column >= 1.0)
+	{
+		// one (min, max) per pixel column, each from a handful of pyramid buckets
+		columns_.resize(width);
+		for (int c = 0; c < width; c++)
+		{
+			uint64_t first = (uint64_t)(begin + c * per_column);
+			uint64_t last = std::min(std::max((uint64_t)(begin + (c + 1) * per_column), first + 1), history_.total());
+			float min, max;
+			if (!history_.range(first, last, min, max))
+				min = max = NAN;
+			columns_[c] = ImVec2(min, max);
+			lo = std::min(lo, min);
+			hi = std::max(hi, max);
+		}
+	}
+	else if (visible >= 1.0)
+	{
+		// fewer samples than columns: a line through the samples themselves
+		uint64_t first = (uint64_t)std::floor(begin);
+		uint64_t last = std::min((uint64_t)std::ceil(view_end_) + 1, history_.total());
+		for (uint64_t i = first; i < last; i++)
+		{
+			float value = history_.sample(i);
+			columns_.push_back(ImVec2((float)(p0.x + (i - begin) / per_column), value));
+			lo = std::min(lo, value);
+			hi = std::max(hi, value);
+		}
+	}
+
+	if (hi < lo)
+		lo = hi = 0.0f;
+	if (hi == lo)
+	{
+		lo -= 1.0f;
+		hi += 1.0f;
+	}
+	float scale = (size.y - 2.0f) / (hi - lo);
+	auto y = [&](float value) { return p1.y - 1.0f - (value - lo) * scale; };
+	ImU32 color = ImGui::GetColorU32(ImGuiCol_PlotLines);
+	draw_list->PushClipRect(p0, p1, true);
+	if (per_column >= 1.0)
+	{
+		for (int c = 0; c < (int)columns_.size(); c++)
+			if (!std::isnan(columns_[c].x))
+				draw_list->AddRectFilled(ImVec2(p0.x + c, y(columns_[c].y)), ImVec2(p0.x + c + 1, y(columns_[c].x) + 1.0f), color);
+	}
+	else if (!columns_.empty())
+	{
+		for (ImVec2& point : columns_)
+			point.y = y(point.y);
+		draw_list->AddPolyline(columns_.data(), (int)columns_.size(), color, ImDrawFlags_None, 1.0f);
+	}
+
+	char text[256];
+	const char* label_end = strstr(label, "##");
+	int label_length = label_end ? (int)(label_end - label) : (int)strlen(label);
+	int n = snprintf(text, sizeof(text), "%.*s  [%.4g, %.4g]  %.0f of %llu samples", label_length, label, lo, hi, visible, (unsigned long long)history_.total());
+	if (ring_.dropped() > 0 && n > 0 && n < (int)sizeof(text))
+		snprintf(text + n, sizeof(text) - n, "  %llu dropped", (unsigned long long)ring_.dropped());
+	draw_list->AddText(ImVec2(p0.x + 4.0f, p0.y + 2.0f), ImGui::GetColorU32(ImGuiCol_Text), text);
+	draw_list->PopClipRect();
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "imgui.h"
+
+// Lock-free single-producer single-consumer ring of samples. The producer never waits on the
+// consumer: when the ring is full the sample is dropped and counted. Give each producer thread
+// its own ring.
+class SampleRing
+{
+public:
+	// capacity is rounded up to a power of two
+	explicit SampleRing(size_t capacity = 1 << 16);
+
+	// Producer thread
+	bool push(float value);
+	// Consumer thread: hands the queued samples to sink(const float* values, size_t count) in
+	// at most two contiguous pieces, and returns how many there were
+	template<typename Sink> size_t drain(Sink&& sink);
+
+	uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	std::vector<float> buffer_;
+	size_t mask_;
+	// each index on its own cache line, so the two threads don't invalidate each other's
+	alignas(64) std::atomic<size_t> head_{ 0 };
+	size_t cached_tail_ = 0;  // producer's last look at tail_
+	alignas(64) std::atomic<size_t> tail_{ 0 };
+	alignas(64) std::atomic<uint64_t> dropped_{ 0 };
+};
+
+template<typename Sink> size_t SampleRing::drain(Sink&& sink)
+{
+	size_t tail = tail_.load(std::memory_order_relaxed);
+	size_t head = head_.load(std::memory_order_acquire);
+	size_t count = head - tail;
+	if (count == 0)
+		return 0;
+	size_t start = tail & mask_;
+	size_t first = std::min(count, buffer_.size() - start);
+	sink(buffer_.data() + start, first);
+	if (first < count)
+		sink(buffer_.data(), count - first);
+	tail_.store(head, std::memory_order_release);
+	return count;
+}
+
+// The last `capacity` samples of a stream plus a min/max pyramid over them: level k keeps one
+// (min, max) pair per 8^k samples, so the extremes of any range come from at most 65 buckets
+// of one level, however long the range. Samples are numbered from 0 since the first append();
+// older ones roll off once capacity is reached.
+class MinMaxHistory
+{
+public:
+	// capacity is rounded up to a whole number of top-level buckets
+	explicit MinMaxHistory(size_t capacity);
+
+	void append(const float* values, size_t count);
+	void clear();
+
+	uint64_t total() const { return total_; }
+	size_t size() const { return (size_t)std::min<uint64_t>(total_, capacity_); }
+	// index of the oldest sample still kept
+	uint64_t first() const { return total_ - size(); }
+	float sample(uint64_t index) const { return samples_[(size_t)(index % capacity_)]; }
+
+	// Extremes over [begin, end), which must lie within [first(), total()). For speed the range is
+	// widened to whole buckets of the chosen level, by less than a quarter of its length.
+	bool range(uint64_t begin, uint64_t end, float& min, float& max) const;
+
+	size_t memoryBytes() const;
+
+private:
+	struct Bucket
+	{
+		float min, max;
+	};
+
+	void accumulate(uint64_t begin, uint64_t end, float& min, float& max) const;
+
+	size_t capacity_;
+	uint64_t total_ = 0;
+	std::vector<float> samples_;
+	// levels_[k - 1] is level k: one bucket per 8^k samples, capacity_ / 8^k slots used as a ring
+	std::vector<std::vector<Bucket>> levels_;
+};
+
+// Live plot of one sample stream, drawn with ImDrawList as one min/max bar per pixel column.
+// A producer thread pushes into input(); the render thread calls update() then draw() each frame.
+// Mouse wheel zooms around the cursor, dragging pans back in time, double-click returns to
+// following the newest samples.
+class TelemetryPlot
+{
+public:
+	explicit TelemetryPlot(size_t history_capacity = 1 << 20, size_t ring_capacity = 1 << 16);
+
+	SampleRing& input() { return ring_; }
+	const MinMaxHistory& history() const { return history_; }
+
+	// Moves everything queued in the ring into the history
+	void update();
+	// A size.x or size.y <= 0 fills the available space, less that much
+	void draw(const char* label, ImVec2 size = ImVec2(0.0f, 150.0f));
+
+private:
+	SampleRing ring_;
+	MinMaxHistory history_;
+	bool follow_ = true;
+	double view_end_ = 0.0;      // one past the newest visible sample
+	double view_samples_ = 0.0;  // 0 shows the whole history
+	std::vector<ImVec2> columns_;  // (min, max) per pixel column, reused across frames
+};
@@ -0,0 +1,368 @@
+#include "text_search.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <regex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXT_SEARCH_SSE2 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+	const size_t kChunkSize = 1 << 20;
+	// libstdc++'s regex matcher recurses per character, about 700 bytes of stack each for (a|b)*,
+	// which overflows a 1 MB thread stack at 1500 characters (macOS gives threads 512 KB). Only
+	// the start of longer lines goes to the regex.
+	const size_t kMaxRegexLine = 512;
+
+#if defined(TEXT_SEARCH_SSE2)
+	int lowestBit(uint32_t mask)
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (int)index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+#endif
+}
+
+struct TextSearch::Search
+{
+	std::shared_ptr<const MappedFile> file;
+	size_t chunk_count = 0;
+	std::unique_ptr<std::regex> regex;
+	// Byte k of a match is b with (b | fold[k]) == folded[k]: fold is 0x20 for the letters when
+	// ignoring case, which maps both cases of a letter to the lower one, and 0 otherwise
+	std::vector<uint8_t> folded;
+	std::vector<uint8_t> fold;
+	bool exact = true;
+
+	std::atomic<size_t> next_chunk{ 0 };
+	std::atomic<bool> cancelled{ false };
+	std::atomic<uint64_t> clipped_lines{ 0 };  // cut to kMaxRegexLine for the regex
+
+	std::mutex mutex;
+	std::vector<std::pair<size_t, std::vector<SearchHit>>> finished;  // chunk, its hits
+
+	void findSubstring(size_t begin, size_t end, std::vector<SearchHit>& hits) const;
+	void findRegex(size_t begin, size_t end, std::vector<SearchHit>& hits);
+};
+
+// Matches starting in [begin, end); they may run past end
+void TextSearch::Search::findSubstring(size_t begin, size_t end, std::vector<SearchHit>& hits) const
+{
+	const uint8_t* data = file->data();
+	size_t size = file->size();
+	size_t length = folded.size();
+	if (size < length)
+		return;
+	size_t limit = std::min(end, size - length + 1);
+	size_t allowed = begin;  // past the previous match
+	auto matches = [&](size_t at) {
+		if (exact)
+			return memcmp(data + at, folded.data(), length) == 0;
+		for (size_t k = 0; k < length; k++)
+			if ((data[at + k] | fold[k]) != folded[k])
+				return false;
+		return true;
+	};
+
+	size_t i = begin;
+#if defined(TEXT_SEARCH_SSE2)
+	// both loads stay inside the file as long as i + 16 <= limit
+	const __m128i first = _mm_set1_epi8((char)folded[0]), first_fold = _mm_set1_epi8((char)fold[0]);
+	const __m128i last = _mm_set1_epi8((char)folded[length - 1]), last_fold = _mm_set1_epi8((char)fold[length - 1]);
+	for (; i + 16 <= limit; i += 16)
+	{
+		__m128i head = _mm_or_si128(_mm_loadu_si128((const __m128i*)(data + i)), first_fold);
+		__m128i tail = _mm_or_si128(_mm_loadu_si128((const __m128i*)(data + i + length - 1)), last_fold);
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+		while (mask)
+		{
+			size_t at = i + lowestBit(mask);
+			mask &= mask - 1;
+			if (at >= allowed && matches(at))
+			{
+				hits.push_back({ at, (uint32_t)length });
+				allowed = at + length;
+			}
+		}
+	}
+#endif
+	for (; i < limit; i++)
+	{
+		if (i >= allowed && matches(i))
+		{
+			hits.push_back({ i, (uint32_t)length });
+			allowed = i + length;
+		}
+	}
+}
+
+// Lines starting in [begin, end), each matched on its own
+void TextSearch::Search::findRegex(size_t begin, size_t end, std::vector<SearchHit>& hits)
+{
+	const char* data = (const char*)file->data();
+	size_t size = file->size();
+	size_t line = begin;
+	if (begin > 0)
+	{
+		const char* newline = (const char*)memchr(data + begin - 1, '\n', size - begin + 1);
+		line = newline ? (size_t)(newline - data) + 1 : size;
+	}
+	while (line < end && !cancelled.load(std::memory_order_relaxed))
+	{
+		const char* newline = (const char*)memchr(data + line, '\n', size - line);
+		size_t line_end = newline ? (size_t)(newline - data) : size;
+		size_t text_end = line_end > line && data[line_end - 1] == '\r' ? line_end - 1 : line_end;
+		if (text_end - line > kMaxRegexLine)
+		{
+			text_end = line + kMaxRegexLine;
+			clipped_lines.fetch_add(1, std::memory_order_relaxed);
+		}
+		try
+		{
+			for (std::cregex_iterator match(data + line, data + text_end, *regex), done; match != done; ++match)
+				if (match->length() > 0)
+					hits.push_back({ line + (uint64_t)match->position(), (uint32_t)std::min<ptrdiff_t>(match->length(), UINT32_MAX) });
+		}
+		catch (const std::regex_error&)
+		{
+			// error_complexity or error_stack on this line; the others are still searched
+		}
+		line = line_end + 1;
+	}
+}
+
+// Takes chunks until there are none left, the search is cancelled or, with seconds >= 0, the
+// time is up
+void TextSearch::scan(Search& search, double seconds)
+{
+	auto start = std::chrono::steady_clock::now();
+	std::vector<SearchHit> hits;
+	while (!search.cancelled.load(std::memory_order_relaxed))
+	{
+		size_t chunk = search.next_chunk.fetch_add(1, std::memory_order_relaxed);
+		if (chunk >= search.chunk_count)
+			break;
+		size_t begin = chunk * kChunkSize;
+		size_t end = std::min(search.file->size(), begin + kChunkSize);
+		hits = std::vector<SearchHit>();
+		if (search.regex)
+			search.findRegex(begin, end, hits);
+		else
+			search.findSubstring(begin, end, hits);
+		{
+			std::lock_guard<std::mutex> lock(search.mutex);
+			search.finished.emplace_back(chunk, std::move(hits));
+		}
+		if (seconds >= 0.0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > seconds)
+			break;
+	}
+}
+
+TextSearch::TextSearch(JobSystem& jobs)
+	: jobs_(jobs)
+{
+}
+
+TextSearch::~TextSearch()
+{
+	cancel();
+	jobs_.wait(job_counter_);
+}
+
+bool TextSearch::start(std::shared_ptr<const MappedFile> file, const std::string& pattern, const SearchOptions& options)
+{
+	cancel();
+	pending_.clear();
+	next_chunk_ = 0;
+	hits_.clear();
+	truncated_ = false;
+	clipped_lines_ = 0;
+	error_.clear();
+	if (!file || pattern.empty())
+		return true;
+
+	auto search = std::make_shared<Search>();
+	search->file = file;
+	search->chunk_count = (file->size() + kChunkSize - 1) / kChunkSize;
+	if (options.regex)
+	{
+		auto flags = std::regex::ECMAScript | std::regex::optimize;
+		if (options.ignore_case)
+			flags |= std::regex::icase;
+		try
+		{
+			search->regex = std::make_unique<std::regex>(pattern, flags);
+		}
+		catch (const std::regex_error& e)
+		{
+			error_ = e.what();
+			return false;
+		}
+	}
+	for (char c : pattern)
+	{
+		bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+		bool fold = options.ignore_case && letter;
+		search->folded.push_back((uint8_t)(fold ? (c | 0x20) : c));
+		search->fold.push_back(fold ? 0x20 : 0);
+		search->exact = search->exact && !fold;
+	}
+
+	search_ = search;
+	for (unsigned int t = 1; t < jobs_.threadCount(); t++)
+		jobs_.run([search]() { scan(*search, -1.0); }, &job_counter_);
+	return true;
+}
+
+void TextSearch::cancel()
+{
+	if (search_)
+		search_->cancelled = true;
+	search_.reset();
+}
+
+bool TextSearch::running() const
+{
+	return search_ != nullptr;
+}
+
+float TextSearch::progress() const
+{
+	return search_ && search_->chunk_count > 0 ? (float)next_chunk_ / search_->chunk_count : 1.0f;
+}
+
+void TextSearch::poll()
+{
+	if (!search_)
+		return;
+	if (jobs_.threadCount() < 2)
+		scan(*search_, 0.004);
+
+	std::vector<std::pair<size_t, std::vector<SearchHit>>> finished;
+	{
+		std::lock_guard<std::mutex> lock(search_->mutex);
+		finished.swap(search_->finished);
+	}
+	for (auto& chunk : finished)
+		pending_.emplace(chunk.first, std::move(chunk.second));
+	clipped_lines_ = search_->clipped_lines.load(std::memory_order_relaxed);
+
+	while (!pending_.empty() && pending_.begin()->first == next_chunk_)
+	{
+		std::vector<SearchHit>& chunk_hits = pending_.begin()->second;
+		// A substring match at the end of the previous chunk may run into this one, which was
+		// searched from its own start; search it again from where that match ends. Rare, and
+		// the hits then come out as one scan of the whole file would give them.
+		size_t chunk_begin = next_chunk_ * kChunkSize;
+		if (!search_->regex && !hits_.empty() && hits_.back().offset + hits_.back().length > chunk_begin)
+		{
+			chunk_hits.clear();
+			search_->findSubstring((size_t)(hits_.back().offset + hits_.back().length), std::min(search_->file->size(), chunk_begin + kChunkSize), chunk_hits);
+		}
+		size_t room = kMaxHits - hits_.size();
+		truncated_ = chunk_hits.size() > room;
+		hits_.insert(hits_.end(), chunk_hits.begin(), chunk_hits.begin() + std::min(room, chunk_hits.size()));
+		pending_.erase(pending_.begin());
+		next_chunk_++;
+		if (truncated_)
+			break;
+	}
+	if (truncated_ || next_chunk_ == search_->chunk_count)
+	{
+		cancel();
+		pending_.clear();
+	}
+}
+
+void TextSearch::restart(std::shared_ptr<const MappedFile> file)
+{
+	start(file, query_, options_);
+	selected_ = -1;
+}
+
+bool TextSearch::draw(const char* label, std::shared_ptr<const MappedFile> file, SearchHit& clicked, ImVec2 size)
+{
+	ImGui::PushID(label);
+	ImGui::SetNextItemWidth(-220.0f);
+	bool changed = ImGui::InputTextWithHint("##query", options_.regex ? "regex" : "search", query_, sizeof(query_));
+	ImGui::SameLine();
+	changed |= ImGui::Checkbox("Regex", &options_.regex);
+	ImGui::SameLine();
+	changed |= ImGui::Checkbox("Ignore case", &options_.ignore_case);
+	if (changed)
+		restart(file);
+	poll();
+
+	if (!error_.empty())
+		ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", error_.c_str());
+	else if (query_[0])
+		ImGui::Text("%zu%s hits", hits_.size(), truncated_ ? "+" : "");
+	if (running())
+	{
+		ImGui::SameLine();
+		ImGui::TextDisabled("scanning %.0f%%", progress() * 100.0f);
+	}
+	if (clipped_lines_ > 0)
+	{
+		ImGui::SameLine();
+		ImGui::TextDisabled("(%llu long lines matched in their first %zu bytes only)", (unsigned long long)clipped_lines_, kMaxRegexLine);
+	}
+
+	bool result = false;
+	ImVec2 available_size = ImGui::GetContentRegionAvail();
+	if (size.x <= 0.0f)
+		size.x = std::max(available_size.x + size.x, 64.0f);
+	if (size.y <= 0.0f)
+		size.y = std::max(available_size.y + size.y, 32.0f);
+	if (ImGui::BeginChild("##hits", size, ImGuiChildFlags_Border) && file)
+	{
+		// a bit of the line before each hit, the hit and what follows up to the end of the line
+		const char* data = (const char*)file->data();
+		uint64_t file_size = file->size();
+		ImGuiListClipper clipper;
+		clipper.Begin((int)std::min<size_t>(hits_.size(), INT_MAX));
+		while (clipper.Step())
+		{
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+			{
+				uint64_t at = std::min<uint64_t>(hits_[i].offset, file_size);
+				uint64_t begin = at;
+				while (begin > 0 && at - begin < 24 && data[begin - 1] != '\n')
+					begin--;
+				uint64_t end = at;
+				while (end < file_size && end - at < 96 && data[end] != '\n' && data[end] != '\r')
+					end++;
+				char text[160];
+				snprintf(text, sizeof(text), "%10llu  %s%.*s", (unsigned long long)at, begin > 0 && data[begin - 1] != '\n' ? "..." : "",
+					(int)(end - begin), data + begin);
+				ImGui::PushID(i);
+				if (ImGui::Selectable(text, selected_ == i))
+				{
+					selected_ = i;
+					clicked = hits_[i];
+					result = true;
+				}
+				ImGui::PopID();
+			}
+		}
+	}
+	ImGui::EndChild();
+	ImGui::PopID();
+	return result;
+}
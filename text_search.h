@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+#include "job_system.h"
+#include "mapped_file.h"
+
+struct SearchHit
+{
+	uint64_t offset;
+	uint32_t length;
+};
+
+struct SearchOptions
+{
+	bool regex = false;  // ECMAScript syntax, matched line by line, on the first 512 bytes of each
+	bool ignore_case = false;
+};
+
+// Searches a mapped file for a substring or a regex on every thread of a JobSystem. The file is
+// cut into chunks that the jobs take in order; each finished chunk's hits go through a queue to
+// poll(), which hands them on in file order, so results show up while the scan goes on.
+// Starting a new search cancels the running one: its jobs notice within a chunk and drop out.
+//
+// Substrings are found with SSE2, comparing the first and last byte of the pattern at 16
+// positions at once and checking only the positions where both match. Matches don't overlap.
+class TextSearch
+{
+public:
+	static const size_t kMaxHits = 1 << 22;
+
+	// Without worker threads the search runs inside poll(), a few milliseconds a call
+	explicit TextSearch(JobSystem& jobs);
+	~TextSearch();
+	TextSearch(const TextSearch&) = delete;
+	TextSearch& operator=(const TextSearch&) = delete;
+
+	// Cancels the running search and starts this one; false, with error() set, for a bad regex.
+	// An empty pattern just cancels.
+	bool start(std::shared_ptr<const MappedFile> file, const std::string& pattern, const SearchOptions& options = SearchOptions());
+	void cancel();
+
+	// Moves the hits found since the last call to hits(); call once a frame (draw() does)
+	void poll();
+	const std::vector<SearchHit>& hits() const { return hits_; }
+	bool running() const;
+	float progress() const;
+	// Stopped at kMaxHits
+	bool truncated() const { return truncated_; }
+	// Regex mode: lines so far that were longer than the part of them matched
+	uint64_t clippedLines() const { return clipped_lines_; }
+	const std::string& error() const { return error_; }
+
+	// Query row and hit list; true when a hit was clicked, which is then in clicked. Searches
+	// file whenever the query or the options change.
+	bool draw(const char* label, std::shared_ptr<const MappedFile> file, SearchHit& clicked, ImVec2 size = ImVec2(0.0f, 0.0f));
+	// Runs draw()'s query again on file, e.g. after another one was opened
+	void restart(std::shared_ptr<const MappedFile> file);
+
+private:
+	struct Search;
+
+	static void scan(Search& search, double seconds);
+
+	JobSystem& jobs_;
+	JobCounter job_counter_;  // jobs of every search so far, cancelled or not
+	std::shared_ptr<Search> search_;
+
+	// chunks that finished ahead of an earlier one, until that one is in
+	std::map<size_t, std::vector<SearchHit>> pending_;
+	size_t next_chunk_ = 0;
+	std::vector<SearchHit> hits_;
+	bool truncated_ = false;
+	uint64_t clipped_lines_ = 0;
+	std::string error_;
+
+	// draw()
+	char query_[256] = {};
+	SearchOptions options_;
+	int selected_ = -1;
+};
@@ -0,0 +1,400 @@
+#include "texture_manager.h"
+#include "mapped_file.h"
+#include "memory_telemetry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+TextureManager::TextureManager(JobSystem& jobs, size_t vram_budget)
+	: jobs_(jobs), vram_budget_(vram_budget)
+{
+}
+
+TextureManager::~TextureManager()
+{
+	// decode jobs write into entries
+	jobs_.wait(decodes_);
+}
+
+void TextureManager::newFrame()
+{
+	frame_++;
+
+	// Start decodes for what was asked for last frame, most recent requests first; whatever
+	// wasn't asked for again has scrolled out of view and goes back to waiting for get()
+	queued_.erase(std::remove_if(queued_.begin(), queued_.end(), [this](Entry* entry) {
+		bool stale = entry->last_used.load() + 1 < frame_;
+		entry->queued = !stale;
+		return stale;
+	}), queued_.end());
+	size_t max_in_flight = std::max<size_t>(4, jobs_.threadCount() * 2);
+	while (!queued_.empty() && in_flight_.load() < max_in_flight)
+	{
+		Entry* entry = queued_.back();
+		queued_.pop_back();
+		entry->queued = false;
+		if (entry->state.load() == Unloaded)
+			startDecode(entry);
+	}
+
+	CallbackParams& params = params_[frame_ % kFramesInFlight];
+	params.manager = this;
+	params.frame = frame_;
+	ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
+	draw_list->AddCallback(&TextureManager::uploadCallback, &params);
+	draw_list->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
+TextureManager::Texture TextureManager::get(const std::string& path)
+{
+	auto it = entries_.find(path);
+	if (it == entries_.end())
+	{
+		it = entries_.emplace(path, std::make_unique<Entry>()).first;
+		it->second->path = path;
+	}
+	Entry* entry = it->second.get();
+
+	// last_used before state: the GL thread checks them the other way round when evicting
+	entry->last_used.store(frame_);
+	int state = entry->state.load();
+	Texture texture;
+	texture.failed = state == Failed;
+	if (state >= Decoded && state != Failed)
+	{
+		texture.width = entry->width;
+		texture.height = entry->height;
+	}
+	if (state == Resident)
+		texture.id = (ImTextureID)(intptr_t)entry->texture.load();
+	else if (state == Unloaded && !entry->queued)
+	{
+		entry->queued = true;
+		queued_.push_back(entry);
+	}
+	return texture;
+}
+
+void TextureManager::image(const std::string& path, ImVec2 size)
+{
+	Texture texture = get(path);
+	ImVec2 p0 = ImGui::GetCursorScreenPos();
+	ImGui::Dummy(size);
+	ImDrawList* draw_list = ImGui::GetWindowDrawList();
+	if (!texture.id)
+	{
+		draw_list->AddRectFilled(p0, ImVec2(p0.x + size.x, p0.y + size.y), ImGui::GetColorU32(ImGuiCol_FrameBg));
+		if (texture.failed)
+			draw_list->AddText(ImVec2(p0.x + 4.0f, p0.y + 4.0f), ImGui::GetColorU32(ImGuiCol_Text), "failed");
+		return;
+	}
+	float scale = std::min(size.x / texture.width, size.y / texture.height);
+	ImVec2 fitted(texture.width * scale, texture.height * scale);
+	ImVec2 q0(p0.x + (size.x - fitted.x) * 0.5f, p0.y + (size.y - fitted.y) * 0.5f);
+	draw_list->AddImage(texture.id, q0, ImVec2(q0.x + fitted.x, q0.y + fitted.y));
+}
+
+TextureManager::Stats TextureManager::stats() const
+{
+	Stats stats;
+	stats.resident_count = resident_count_.load();
+	stats.resident_bytes = resident_bytes_.load();
+	stats.queued = queued_.size();
+	stats.in_flight = in_flight_.load();
+	stats.uploaded_bytes = uploaded_bytes_.load();
+	stats.evictions = evictions_.load();
+	return stats;
+}
+
+void TextureManager::startDecode(Entry* entry)
+{
+	entry->state = Decoding;
+	in_flight_++;
+	auto decode = [this, entry]() {
+		MappedFile file;
+		int width = 0, height = 0, channels = 0;
+		stbi_uc* pixels = nullptr;
+		if (file.open(entry->path))
+			pixels = stbi_load_from_memory(file.data(), (int)std::min<size_t>(file.size(), INT32_MAX), &width, &height, &channels, 4);
+		if (!pixels)
+		{
+			std::cerr << "Failed to load image " << entry->path << ": " << stbi_failure_reason() << std::endl;
+			entry->state = Failed;
+			in_flight_--;
+			return;
+		}
+		entry->width = width;
+		entry->height = height;
+		entry->pixels.assign(pixels, pixels + (size_t)width * height * 4);
+		stbi_image_free(pixels);
+		entry->bytes = 0;
+		for (int w = width, h = height;; w = std::max(w / 2, 1), h = std::max(h / 2, 1))
+		{
+			entry->bytes += (size_t)w * h * 4;
+			if (w == 1 && h == 1)
+				break;
+		}
+		entry->state = Decoded;
+		std::lock_guard<std::mutex> lock(decoded_mutex_);
+		decoded_.push_back(entry);
+	};
+	// without workers a job would only run in a wait(), so decode right away
+	if (jobs_.threadCount() < 2)
+		decode();
+	else
+		jobs_.run(decode, &decodes_);
+}
+
+void TextureManager::uploadCallback(const ImDrawList*, const ImDrawCmd* cmd)
+{
+	const CallbackParams& params = *(const CallbackParams*)cmd->UserCallbackData;
+	params.manager->update(params.frame);
+}
+
+bool TextureManager::initGL()
+{
+	gl_initialized_ = true;
+	if (!GLEW_VERSION_3_0)
+	{
+		std::cerr << "TextureManager needs OpenGL 3.0 for pixel buffers and mipmap generation" << std::endl;
+		gl_failed_ = true;
+		return false;
+	}
+	use_fences_ = GLEW_VERSION_3_2 || GLEW_ARB_sync;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size_);
+	for (StagingBuffer& staging : staging_)
+	{
+		glGenBuffers(1, &staging.buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+		trackedBufferData(GL_PIXEL_UNPACK_BUFFER, staging.buffer, kStagingBytes, NULL, GL_STREAM_DRAW, "TextureManager staging");
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return true;
+}
+
+void TextureManager::shutdown()
+{
+	jobs_.wait(decodes_);
+	if (!gl_initialized_ || gl_failed_)
+		return;
+	for (auto& it : entries_)
+	{
+		Entry& entry = *it.second;
+		GLuint texture = entry.texture.exchange(0);
+		if (texture)
+			trackedDeleteTextures(1, &texture);
+		entry.pixels = std::vector<uint8_t>();
+		entry.state = Unloaded;
+	}
+	for (StagingBuffer& staging : staging_)
+	{
+		if (staging.fence)
+			glDeleteSync(staging.fence);
+		trackedDeleteBuffers(1, &staging.buffer);
+		staging = StagingBuffer();
+	}
+	uploads_.clear();
+	resident_.clear();
+	decoded_.clear();
+	resident_bytes_ = 0;
+	resident_count_ = 0;
+	in_flight_ = 0;
+	gl_initialized_ = false;
+}
+
+void TextureManager::update(uint64_t frame)
+{
+	if (!gl_initialized_ && !initGL())
+		return;
+	if (gl_failed_)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(decoded_mutex_);
+		uploads_.insert(uploads_.end(), decoded_.begin(), decoded_.end());
+		decoded_.clear();
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	size_t budget = upload_budget_.load();
+	// entries that don't fit yet go to the back; once all have, the rest waits for a later frame
+	size_t deferred = 0;
+	while (!uploads_.empty() && deferred < uploads_.size())
+	{
+		Entry* entry = uploads_.front();
+		if (entry->state.load() == Decoded)
+		{
+			if (entry->bytes > vram_budget_.load())
+			{
+				std::cerr << "Image " << entry->path << " is larger than the whole texture budget" << std::endl;
+				entry->pixels = std::vector<uint8_t>();
+				entry->state = Failed;
+				in_flight_--;
+				uploads_.pop_front();
+				continue;
+			}
+			if (!makeRoom(entry->bytes, frame))
+			{
+				// doesn't fit next to what is on screen; if it isn't itself, forget it
+				uploads_.pop_front();
+				if (entry->last_used.load() + 1 >= frame)
+				{
+					uploads_.push_back(entry);
+					deferred++;
+					continue;
+				}
+				entry->pixels = std::vector<uint8_t>();
+				entry->state = Unloaded;
+				in_flight_--;
+				continue;
+			}
+			if (!beginUpload(entry))
+			{
+				uploads_.pop_front();
+				continue;
+			}
+		}
+		if (!uploadRows(entry, budget))
+			break;
+
+		glBindTexture(GL_TEXTURE_2D, entry->texture.load());
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		entry->pixels = std::vector<uint8_t>();
+		entry->state = Resident;
+		resident_.push_back(entry);
+		resident_count_++;
+		in_flight_--;
+		uploads_.pop_front();
+	}
+	// the budget may have been lowered
+	makeRoom(0, frame);
+}
+
+// Evicts least recently used textures until bytes more fit in the budget. A texture drawn in
+// this frame or a later one is never evicted: frames render in order, so older frames are done.
+bool TextureManager::makeRoom(size_t bytes, uint64_t frame)
+{
+	size_t budget = vram_budget_.load();
+	if (resident_bytes_ + bytes <= budget)
+		return true;
+	std::sort(resident_.begin(), resident_.end(), [](const Entry* a, const Entry* b) { return a->last_used.load() < b->last_used.load(); });
+	for (Entry* entry : resident_)
+	{
+		if (resident_bytes_ + bytes <= budget || entry->last_used.load() >= frame)
+			break;
+		int state = Resident;
+		if (!entry->state.compare_exchange_strong(state, Evicting))
+			continue;
+		// the UI may have picked it up again between the sort and the exchange
+		if (entry->last_used.load() >= frame)
+		{
+			entry->state = Resident;
+			break;
+		}
+		GLuint texture = entry->texture.exchange(0);
+		trackedDeleteTextures(1, &texture);
+		resident_bytes_ -= entry->bytes;
+		resident_count_--;
+		evictions_++;
+		entry->state = Unloaded;
+	}
+	resident_.erase(std::remove_if(resident_.begin(), resident_.end(), [](const Entry* entry) { return entry->state.load() != Resident; }),
+		resident_.end());
+	return resident_bytes_ + bytes <= budget;
+}
+
+// Creates the texture with all its mip levels; rows are filled in by uploadRows()
+bool TextureManager::beginUpload(Entry* entry)
+{
+	if (entry->width > max_texture_size_ || entry->height > max_texture_size_)
+	{
+		std::cerr << "Image " << entry->path << " is larger than the maximum texture size " << max_texture_size_ << std::endl;
+		entry->pixels = std::vector<uint8_t>();
+		entry->state = Failed;
+		in_flight_--;
+		return false;
+	}
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	for (int level = 0, w = entry->width, h = entry->height;; level++, w = std::max(w / 2, 1), h = std::max(h / 2, 1))
+	{
+		trackedTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL, entry->path.c_str());
+		if (w == 1 && h == 1)
+			break;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	entry->texture = texture;
+	entry->rows_uploaded = 0;
+	entry->state = Uploading;
+	resident_bytes_ += entry->bytes;
+	return true;
+}
+
+// Copies rows into free staging buffers and has the GPU take them from there, until the image is
+// complete (true) or the budget or the free buffers run out (false, to be continued next frame)
+bool TextureManager::uploadRows(Entry* entry, size_t& budget)
+{
+	size_t row_bytes = (size_t)entry->width * 4;
+	size_t staging_bytes = kStagingBytes;
+	while (entry->rows_uploaded < entry->height)
+	{
+		if (budget < row_bytes)
+			return false;
+		StagingBuffer* staging = freeStagingBuffer();
+		if (!staging)
+			return false;
+		size_t rows = std::min<size_t>(entry->height - entry->rows_uploaded, std::min(staging_bytes, budget) / row_bytes);
+		size_t bytes = rows * row_bytes;
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging->buffer);
+		GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+		// the fence said the GPU is done with this buffer, so the driver needn't check
+		if (use_fences_)
+			access |= GL_MAP_UNSYNCHRONIZED_BIT;
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, access);
+		if (!mapped)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			return false;
+		}
+		memcpy(mapped, entry->pixels.data() + entry->rows_uploaded * row_bytes, bytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindTexture(GL_TEXTURE_2D, entry->texture.load());
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, entry->rows_uploaded, entry->width, (GLsizei)rows, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		if (use_fences_)
+			staging->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		entry->rows_uploaded += (int)rows;
+		budget -= bytes;
+		uploaded_bytes_ += bytes;
+	}
+	return true;
+}
+
+// Next buffer of the ring, or nullptr while the GPU may still be reading it
+TextureManager::StagingBuffer* TextureManager::freeStagingBuffer()
+{
+	StagingBuffer& staging = staging_[next_staging_];
+	if (staging.fence)
+	{
+		if (glClientWaitSync(staging.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			return nullptr;
+		glDeleteSync(staging.fence);
+		staging.fence = nullptr;
+	}
+	next_staging_ = (next_staging_ + 1) % kStagingBuffers;
+	return &staging;
+}
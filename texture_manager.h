@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <GL/glew.h>
+
+#include "imgui.h"
+#include "job_system.h"
+
+// Image files as ImGui textures, loaded on demand and kept under a VRAM budget. Asking for an
+// image queues its decode (stb_image) on the job system; decoded images are uploaded through a
+// ring of pixel buffer objects, a few rows at a time within a per-frame byte budget, then get
+// their mipmaps generated. Textures not drawn for a while are evicted, least recently used first,
+// whenever the resident ones exceed the budget, and load again when asked for. An image larger
+// than the whole budget fails, like one larger than GL_MAX_TEXTURE_SIZE.
+//
+// The GL side runs in an ImDrawList callback that newFrame() adds, so on whichever thread
+// renders ImGui, as with App's threaded rendering. Draw with image() or the id from get().
+class TextureManager
+{
+public:
+	struct Texture
+	{
+		ImTextureID id = 0;  // 0 until resident
+		int width = 0, height = 0;
+		bool failed = false;
+	};
+
+	struct Stats
+	{
+		size_t resident_count = 0;
+		size_t resident_bytes = 0;
+		size_t queued = 0;       // waiting for a decode slot
+		size_t in_flight = 0;    // decoding, decoded or uploading
+		uint64_t uploaded_bytes = 0;
+		uint64_t evictions = 0;
+	};
+
+	explicit TextureManager(JobSystem& jobs, size_t vram_budget = 256 << 20);
+	~TextureManager();
+	TextureManager(const TextureManager&) = delete;
+	TextureManager& operator=(const TextureManager&) = delete;
+
+	void setVramBudget(size_t bytes) { vram_budget_ = bytes; }
+	// Bytes copied into staging buffers per frame; bounds the upload cost of any frame
+	void setUploadBudget(size_t bytes) { upload_budget_ = bytes; }
+
+	// UI thread, once a frame after ImGui::NewFrame(): starts queued decodes and records the
+	// callback that uploads and evicts
+	void newFrame();
+	// Marks path as used this frame and returns its texture, loading it if it isn't resident
+	Texture get(const std::string& path);
+	// The image scaled to fit size, or a placeholder while it loads
+	void image(const std::string& path, ImVec2 size);
+
+	Stats stats() const;
+
+	// On the GL thread, before the context goes away and once the UI stopped calling get()
+	void shutdown();
+
+private:
+	static const int kFramesInFlight = 4;  // callback parameters kept for frames not rendered yet
+	static const int kStagingBuffers = 3;
+	static const size_t kStagingBytes = 4 << 20;
+
+	enum State
+	{
+		Unloaded,
+		Decoding,
+		Decoded,
+		Uploading,
+		Resident,
+		Evicting,
+		Failed
+	};
+
+	struct Entry
+	{
+		std::string path;
+		std::atomic<int> state{ Unloaded };
+		std::atomic<uint64_t> last_used{ 0 };
+		std::atomic<GLuint> texture{ 0 };
+		int width = 0, height = 0;          // set by the decode
+		std::vector<uint8_t> pixels;        // RGBA8, from the decode until uploaded
+		size_t bytes = 0;                   // VRAM with mipmaps
+		bool queued = false;                // UI thread: in queued_
+		int rows_uploaded = 0;              // GL thread
+	};
+
+	struct StagingBuffer
+	{
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+	};
+
+	struct CallbackParams
+	{
+		TextureManager* manager;
+		uint64_t frame;
+	};
+
+	static void uploadCallback(const ImDrawList* list, const ImDrawCmd* cmd);
+	void startDecode(Entry* entry);
+	// GL thread
+	bool initGL();
+	void update(uint64_t frame);
+	bool makeRoom(size_t bytes, uint64_t frame);
+	bool beginUpload(Entry* entry);
+	bool uploadRows(Entry* entry, size_t& budget);
+	StagingBuffer* freeStagingBuffer();
+
+	JobSystem& jobs_;
+	JobCounter decodes_;
+	std::atomic<size_t> vram_budget_;
+	std::atomic<size_t> upload_budget_{ 8 << 20 };
+
+	// UI thread; entries live until destruction, pixels and texture come and go
+	std::unordered_map<std::string, std::unique_ptr<Entry>> entries_;
+	std::vector<Entry*> queued_;
+	uint64_t frame_ = 0;
+	CallbackParams params_[kFramesInFlight];
+	std::atomic<size_t> in_flight_{ 0 };
+
+	// decode jobs -> GL thread
+	std::mutex decoded_mutex_;
+	std::vector<Entry*> decoded_;
+
+	// GL thread
+	bool gl_initialized_ = false;
+	bool gl_failed_ = false;
+	bool use_fences_ = false;
+	GLint max_texture_size_ = 0;
+	StagingBuffer staging_[kStagingBuffers];
+	int next_staging_ = 0;
+	std::deque<Entry*> uploads_;
+	std::vector<Entry*> resident_;
+	std::atomic<size_t> resident_bytes_{ 0 };
+	std::atomic<size_t> resident_count_{ 0 };
+	std::atomic<uint64_t> uploaded_bytes_{ 0 };
+	std::atomic<uint64_t> evictions_{ 0 };
+};
@@ -0,0 +1,245 @@
+#include "vertex_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <GL/glew.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+uint32_t VertexFormat::positionSize() const
+{
+	switch (position)
+	{
+	case PositionFormat::Float3: return 12;
+	case PositionFormat::Half3: return 8;
+	case PositionFormat::Snorm16: return 8;
+	}
+	return 0;
+}
+
+uint32_t VertexFormat::normalSize() const
+{
+	switch (normal)
+	{
+	case NormalFormat::Float3: return 12;
+	case NormalFormat::Int2101010: return 4;
+	}
+	return 0;
+}
+
+glm::mat4 PackedMesh::dequantization() const
+{
+	if (format.position != PositionFormat::Snorm16)
+		return glm::mat4(1.0f);
+	return glm::scale(glm::translate(glm::mat4(1.0f), position_center), position_extent);
+}
+
+unsigned int PackedMesh::glIndexType() const
+{
+	return index16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+bool packMesh(const float* interleaved, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, const VertexFormat& format, PackedMesh& mesh)
+{
+	// 16-bit indices address at most 65536 vertices
+	if (format.index == IndexFormat::Uint16 && vertex_count > 65536)
+	{
+		std::cerr << "16-bit indices can't address " << vertex_count << " vertices" << std::endl;
+		return false;
+	}
+
+	mesh = PackedMesh();
+	mesh.format = format;
+	mesh.vertex_count = vertex_count;
+	mesh.index_count = index_count;
+
+	if (vertex_count > 0)
+	{
+		glm::vec3 lo(interleaved[0], interleaved[1], interleaved[2]);
+		glm::vec3 hi = lo;
+		for (uint32_t i = 1; i < vertex_count; i++)
+		{
+			const float* p = interleaved + i * 6;
+			lo = glm::min(lo, glm::vec3(p[0], p[1], p[2]));
+			hi = glm::max(hi, glm::vec3(p[0], p[1], p[2]));
+		}
+		mesh.position_center = (lo + hi) * 0.5f;
+		mesh.position_extent = glm::max((hi - lo) * 0.5f, glm::vec3(1e-20f));
+	}
+
+	uint32_t stride = format.stride();
+	mesh.vertex_data.assign((size_t)vertex_count * stride, 0);
+	for (uint32_t i = 0; i < vertex_count; i++)
+	{
+		const float* src = interleaved + i * 6;
+		uint8_t* dst = mesh.vertex_data.data() + (size_t)i * stride;
+
+		switch (format.position)
+		{
+		case PositionFormat::Float3:
+			memcpy(dst, src, 12);
+			break;
+		case PositionFormat::Half3:
+		{
+			uint16_t h[3] = { packHalf(src[0]), packHalf(src[1]), packHalf(src[2]) };
+			memcpy(dst, h, sizeof(h));
+			break;
+		}
+		case PositionFormat::Snorm16:
+		{
+			int16_t q[3];
+			for (int c = 0; c < 3; c++)
+				q[c] = packSnorm16((src[c] - mesh.position_center[c]) / mesh.position_extent[c]);
+			memcpy(dst, q, sizeof(q));
+			break;
+		}
+		}
+
+		dst += format.positionSize();
+		if (format.normal == NormalFormat::Float3)
+		{
+			memcpy(dst, src + 3, 12);
+		}
+		else
+		{
+			uint32_t n = packNormal2101010(glm::vec3(src[3], src[4], src[5]));
+			memcpy(dst, &n, sizeof(n));
+		}
+	}
+
+	mesh.index16 = format.index == IndexFormat::Uint16 || (format.index == IndexFormat::Auto && vertex_count <= 65536);
+	if (mesh.index16)
+	{
+		mesh.index_data.resize((size_t)index_count * 2);
+		uint16_t* dst = (uint16_t*)mesh.index_data.data();
+		for (uint32_t i = 0; i < index_count; i++)
+			dst[i] = (uint16_t)indices[i];
+	}
+	else
+	{
+		mesh.index_data.resize((size_t)index_count * 4);
+		memcpy(mesh.index_data.data(), indices, mesh.index_data.size());
+	}
+	return true;
+}
+
+bool packMesh(const std::vector<float>& interleaved, const std::vector<unsigned int>& indices, const VertexFormat& format, PackedMesh& mesh)
+{
+	return packMesh(interleaved.data(), (uint32_t)(interleaved.size() / 6), indices.data(), (uint32_t)indices.size(), format, mesh);
+}
+
+void setupVertexAttributes(const VertexFormat& format, size_t base_offset)
+{
+	GLsizei stride = (GLsizei)format.stride();
+	const void* position_offset = (const void*)base_offset;
+	const void* normal_offset = (const void*)(base_offset + format.positionSize());
+
+	switch (format.position)
+	{
+	case PositionFormat::Float3:
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, position_offset);
+		break;
+	case PositionFormat::Half3:
+		glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, stride, position_offset);
+		break;
+	case PositionFormat::Snorm16:
+		glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, position_offset);
+		break;
+	}
+	glEnableVertexAttribArray(0);
+
+	if (format.normal == NormalFormat::Float3)
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, normal_offset);
+	else
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, normal_offset); // packed types must use size 4
+	glEnableVertexAttribArray(1);
+}
+
+uint16_t packHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (((bits >> 23) & 0xFF) == 0xFF) // inf / nan
+		return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+	if (exponent >= 31) // overflow to inf
+		return (uint16_t)(sign | 0x7C00);
+	if (exponent <= 0) // subnormal or zero
+	{
+		if (exponent < -10)
+			return (uint16_t)sign;
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t rest = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1)))
+			half++;
+		return (uint16_t)(sign | half);
+	}
+
+	// round to nearest even; a carry into the exponent is still correct
+	uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+	uint32_t rest = mantissa & 0x1FFF;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+		half++;
+	return (uint16_t)half;
+}
+
+float unpackHalf(uint16_t value)
+{
+	uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1F;
+	uint32_t mantissa = value & 0x3FF;
+	uint32_t bits;
+
+	if (exponent == 0)
+	{
+		if (mantissa == 0)
+		{
+			bits = sign;
+		}
+		else
+		{
+			// renormalize the subnormal
+			exponent = 127 - 15 + 1;
+			while (!(mantissa & 0x400))
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+	}
+	else if (exponent == 31)
+	{
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+int16_t packSnorm16(float value)
+{
+	return (int16_t)std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f);
+}
+
+uint32_t packNormal2101010(const glm::vec3& normal)
+{
+	auto component = [](float v) {
+		int32_t q = (int32_t)std::lround(std::min(std::max(v, -1.0f), 1.0f) * 511.0f);
+		return (uint32_t)q & 0x3FF;
+	};
+	// x in the low bits, w (unused) left at 0
+	return component(normal.x) | (component(normal.y) << 10) | (component(normal.z) << 20);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Compact vertex encodings for indexed position+normal meshes.
+// A float position+normal vertex is 24 bytes; half positions with a packed
+// 2_10_10_10 normal are 12, and indices drop to 16 bits when the mesh allows it.
+enum class PositionFormat
+{
+	Float3,  // 12 bytes
+	Half3,   // 8 bytes (3 halves + padding), exact for small integer-ish coordinates
+	Snorm16, // 8 bytes, quantized to the mesh bounds; apply dequantization() to the model matrix
+};
+
+enum class NormalFormat
+{
+	Float3,     // 12 bytes
+	Int2101010, // 4 bytes, GL_INT_2_10_10_10_REV (GL 3.3)
+};
+
+enum class IndexFormat
+{
+	Auto, // 16 bit when the vertex count permits, 32 bit otherwise
+	Uint16, // packMesh fails past 65536 vertices rather than truncating indices
+	Uint32,
+};
+
+struct VertexFormat
+{
+	PositionFormat position = PositionFormat::Half3;
+	NormalFormat normal = NormalFormat::Int2101010;
+	IndexFormat index = IndexFormat::Auto;
+
+	uint32_t positionSize() const;
+	uint32_t normalSize() const;
+	uint32_t stride() const { return positionSize() + normalSize(); }
+};
+
+struct PackedMesh
+{
+	VertexFormat format;
+	std::vector<uint8_t> vertex_data;
+	std::vector<uint8_t> index_data;
+	uint32_t vertex_count = 0;
+	uint32_t index_count = 0;
+	bool index16 = false;
+	// Bounding box of the positions; Snorm16 positions decode to [-1, 1] within it
+	glm::vec3 position_center = glm::vec3(0.0f);
+	glm::vec3 position_extent = glm::vec3(1.0f);
+
+	glm::mat4 dequantization() const;
+	unsigned int glIndexType() const;
+	size_t indexSize() const { return index16 ? 2 : 4; }
+};
+
+// Packs an interleaved position(3) + normal(3) float stream, the layout used by main_draggable5.
+// False when the format can't hold the mesh (Uint16 indices for more than 65536 vertices).
+bool packMesh(const float* interleaved, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, const VertexFormat& format, PackedMesh& mesh);
+bool packMesh(const std::vector<float>& interleaved, const std::vector<unsigned int>& indices, const VertexFormat& format, PackedMesh& mesh);
+
+// Sets up attribute 0 (position) and 1 (normal) for the currently bound VAO/VBO. Needs GL 3.3
+// for GL_INT_2_10_10_10_REV, and shaders that read them use layout(location) from GLSL 330.
+void setupVertexAttributes(const VertexFormat& format, size_t base_offset = 0);
+
+uint16_t packHalf(float value);
+float unpackHalf(uint16_t value);
+int16_t packSnorm16(float value);
+uint32_t packNormal2101010(const glm::vec3& normal);